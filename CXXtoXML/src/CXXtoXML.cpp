@@ -3,6 +3,7 @@
 #include "TypeTableInfo.h"
 #include "NnsTableInfo.h"
 #include "DeclarationsVisitor.h"
+#include "XcodeMlPasses.h"
 
 #include "clang/AST/ASTConsumer.h"
 #include "clang/Frontend/ASTConsumers.h"
@@ -26,6 +27,33 @@ using namespace llvm;
 static cl::extrahelp CommonHelp(CommonOptionsParser::HelpMessage);
 static std::unique_ptr<opt::OptTable> Options(createDriverOptTable());
 
+static cl::bits<XcodeMlPass> OptPasses(
+    cl::desc("Post-process the output (replaces XSLTs/*.xsl):"),
+    cl::values(
+        clEnumValN(DropColumnPass, "drop-prop-column", "drop @column"),
+        clEnumValN(DropFilePass, "drop-prop-file", "drop @file"),
+        clEnumValN(DropLinenoPass, "drop-prop-lineno", "drop @lineno"),
+        clEnumValN(ReorderDeclPass,
+            "reorder-decl",
+            "hoist declarations out of for-init-statements"),
+        clEnumValN(AddSymbolsPass,
+            "add-symbols",
+            "add <symbols> to compound statements"),
+        clEnumValN(AddGlobalSymbolsPass,
+            "add-global-symbols",
+            "add <typeTable>, <nnsTable> and <globalSymbols>"),
+        clEnumValN(HandleNamePass,
+            "handle-name",
+            "turn <name> into <operator>, <constructor>, ..."),
+        clEnumValN(ToXcodeProgramPass,
+            "to-xcode-program",
+            "convert <clangAST> into <XcodeProgram>")),
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<bool> OptXcodeProgram("xcodeml-program",
+    cl::desc("run all the post-processing passes"),
+    cl::cat(CXX2XMLCategory));
+
 namespace {
 
 const char *
@@ -54,10 +82,11 @@ public:
     InheritanceInfo inheritanceinfo;
     InheritanceInfo *II = &inheritanceinfo;
     DeclarationsVisitorContext DVC(MC, II);
-    DeclarationsVisitor DV(MC, rootNode, nullptr, &DVC);
     Decl *D = CXT.getTranslationUnitDecl();
     
-    DV.TraverseDecl(D);
+    traverseDeclarations(MC, rootNode, &DVC, D);
+    runXcodeMlPasses(rootNode,
+        OptXcodeProgram ? ~0u : OptPasses.getBits());
   }
 #if 0
     virtual bool HandleTopLevelDecl(DeclGroupRef DG) override {
@@ -21,9 +21,10 @@ static cl::opt<bool> OptDisableDeclarations("disable-declarations",
     cl::desc("disable <globalDeclarations>, <declarations>"),
     cl::cat(CXX2XMLCategory));
 
+template <class TracePolicy>
 const char *
-DeclarationsVisitor::getVisitorName() const {
-  return OptTraceDeclarations ? "Declarations" : nullptr;
+DeclarationsVisitor<TracePolicy>::getVisitorName() const {
+  return TracePolicy::enabled ? "Declarations" : nullptr;
 }
 
 namespace {
@@ -46,8 +47,9 @@ unsignedToHexString(unsigned u) {
 
 } // namespace
 
+template <class TracePolicy>
 bool
-DeclarationsVisitor::PreVisitStmt(Stmt *S) {
+DeclarationsVisitor<TracePolicy>::PreVisitStmt(Stmt *S) {
   if (!S) {
     newComment("Stmt:NULL");
     return true;
@@ -301,8 +303,9 @@ DeclarationsVisitor::PreVisitStmt(Stmt *S) {
   return true;
 }
 
+template <class TracePolicy>
 bool
-DeclarationsVisitor::PreVisitType(QualType T) {
+DeclarationsVisitor<TracePolicy>::PreVisitType(QualType T) {
   if (T.isNull()) {
     newComment("Type:NULL");
     return true;
@@ -313,8 +316,9 @@ DeclarationsVisitor::PreVisitType(QualType T) {
   return false;
 }
 
+template <class TracePolicy>
 bool
-DeclarationsVisitor::PreVisitTypeLoc(TypeLoc TL) {
+DeclarationsVisitor<TracePolicy>::PreVisitTypeLoc(TypeLoc TL) {
   newChild("clangTypeLoc");
   newProp("class", NameForTypeLoc(TL));
   const auto T = TL.getType();
@@ -322,22 +326,27 @@ DeclarationsVisitor::PreVisitTypeLoc(TypeLoc TL) {
   return true;
 }
 
+template <class TracePolicy>
 bool
-DeclarationsVisitor::PreVisitAttr(Attr *A) {
+DeclarationsVisitor<TracePolicy>::PreVisitAttr(Attr *A) {
   if (!A) {
     newComment("Attr:NULL");
     return true;
   }
-  newComment(std::string("Attr:") + A->getSpelling());
+  if (TracePolicy::enabled) {
+    newComment(std::string("Attr:") + A->getSpelling());
+  }
   newChild("gccAttribute");
 
   newProp("name", contentBySource(A->getLocation(), A->getLocation()).c_str());
 
-  std::string prettyprint;
-  raw_string_ostream OS(prettyprint);
-  ASTContext &CXT = mangleContext->getASTContext();
-  A->printPretty(OS, PrintingPolicy(CXT.getLangOpts()));
-  newComment(OS.str());
+  if (TracePolicy::enabled) {
+    std::string prettyprint;
+    raw_string_ostream OS(prettyprint);
+    ASTContext &CXT = mangleContext->getASTContext();
+    A->printPretty(OS, PrintingPolicy(CXT.getLangOpts()));
+    newComment(OS.str());
+  }
 
   return true;
 }
@@ -355,8 +364,9 @@ getLanguageIdAsString(clang::LinkageSpecDecl::LanguageIDs id) {
 
 } // namespace
 
+template <class TracePolicy>
 bool
-DeclarationsVisitor::PreVisitDecl(Decl *D) {
+DeclarationsVisitor<TracePolicy>::PreVisitDecl(Decl *D) {
   if (!D) {
     return true;
   }
@@ -504,8 +514,9 @@ DeclarationsVisitor::PreVisitDecl(Decl *D) {
   return true;
 }
 
+template <class TracePolicy>
 bool
-DeclarationsVisitor::PostVisitDecl(Decl *D) {
+DeclarationsVisitor<TracePolicy>::PostVisitDecl(Decl *D) {
   if (!D) {
     return true;
   }
@@ -517,8 +528,10 @@ DeclarationsVisitor::PostVisitDecl(Decl *D) {
   return true;
 }
 
+template <class TracePolicy>
 bool
-DeclarationsVisitor::PreVisitDeclarationNameInfo(DeclarationNameInfo NI) {
+DeclarationsVisitor<TracePolicy>::PreVisitDeclarationNameInfo(
+    DeclarationNameInfo NI) {
   DeclarationName DN = NI.getName();
 
   const auto name = NI.getAsString();
@@ -553,8 +566,10 @@ SpecifierKindToString(clang::NestedNameSpecifier::SpecifierKind kind) {
 
 } // namespace
 
+template <class TracePolicy>
 bool
-DeclarationsVisitor::PreVisitNestedNameSpecifierLoc(NestedNameSpecifierLoc N) {
+DeclarationsVisitor<TracePolicy>::PreVisitNestedNameSpecifierLoc(
+    NestedNameSpecifierLoc N) {
   const auto Spec = N.getNestedNameSpecifier();
   if (!Spec) {
     return true;
@@ -589,8 +604,10 @@ DeclarationsVisitor::PreVisitNestedNameSpecifierLoc(NestedNameSpecifierLoc N) {
   return true;
 }
 
+template <class TracePolicy>
 bool
-DeclarationsVisitor::PreVisitConstructorInitializer(CXXCtorInitializer *CI) {
+DeclarationsVisitor<TracePolicy>::PreVisitConstructorInitializer(
+    CXXCtorInitializer *CI) {
   if (!CI) {
     return true;
   }
@@ -610,6 +627,20 @@ DeclarationsVisitor::PreVisitConstructorInitializer(CXXCtorInitializer *CI) {
   return true;
 }
 
+void
+traverseDeclarations(MangleContext *MC,
+    xmlNodePtr rootNode,
+    DeclarationsVisitorContext *DVC,
+    Decl *D) {
+  if (OptTraceDeclarations) {
+    DeclarationsVisitor<WithTrace> DV(MC, rootNode, nullptr, DVC);
+    DV.TraverseDecl(D);
+  } else {
+    DeclarationsVisitor<NoTrace> DV(MC, rootNode, nullptr, DVC);
+    DV.TraverseDecl(D);
+  }
+}
+
 ///
 /// Local Variables:
 /// indent-tabs-mode: nil
@@ -3,8 +3,11 @@
 
 class DeclarationsVisitorContext;
 
-class DeclarationsVisitor : public XMLVisitorBase<DeclarationsVisitor,
-                                DeclarationsVisitorContext *> {
+template <class TracePolicy>
+class DeclarationsVisitor
+    : public XMLVisitorBase<DeclarationsVisitor<TracePolicy>,
+          DeclarationsVisitorContext *,
+          TracePolicy> {
   /* OptContext := DeclarationsVisitorContext *
    *
    * The optContext data member is frequently copied since
@@ -13,10 +16,29 @@ class DeclarationsVisitor : public XMLVisitorBase<DeclarationsVisitor,
    * optContext should be a pointer to DeclarationsVisitorContext rather than
    * DeclarationsVisitorContext itself.
    */
+  using Base = XMLVisitorBase<DeclarationsVisitor<TracePolicy>,
+      DeclarationsVisitorContext *,
+      TracePolicy>;
+
+protected:
+  using Base::curNode;
+  using Base::mangleContext;
+  using Base::optContext;
 
 public:
   // use base constructors
-  using XMLVisitorBase::XMLVisitorBase;
+  using Base::Base;
+  using Base::addChild;
+  using Base::contentBySource;
+  using Base::newBoolProp;
+  using Base::newChild;
+  using Base::newComment;
+  using Base::newProp;
+  using Base::setLocation;
+  using Base::NameForDeclarationName;
+  using Base::NameForTypeLoc;
+  using Base::TraverseStmt;
+  using Base::TraverseType;
 
   const char *getVisitorName() const override;
   bool PreVisitStmt(clang::Stmt *);
@@ -42,6 +64,15 @@ public:
   NnsTableInfo nnstableinfo;
 };
 
+/*!
+ * \brief Traverse \c D with the DeclarationsVisitor instantiation
+ * that --trace-declarations selects.
+ */
+void traverseDeclarations(clang::MangleContext *MC,
+    xmlNodePtr rootNode,
+    DeclarationsVisitorContext *DVC,
+    clang::Decl *D);
+
 #endif /* !DECLARATIONSVISITOR_H */
 
 ///
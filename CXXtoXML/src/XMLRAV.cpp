@@ -35,15 +35,15 @@ public:
 
 #define DISPATCHER(NAME, TYPE)                                                \
   bool Traverse##NAME(TYPE S) {                                               \
-    const char *VN = otherside->getVisitorName();                             \
-    if (OptTraceRAV && VN) {                                                  \
+    const char *VN = OptTraceRAV ? otherside->getVisitorName() : nullptr;     \
+    if (VN) {                                                                 \
       errs() << VN << "::       Traverse" #NAME "\n";                         \
     }                                                                         \
     return otherside->Bridge##NAME(S);                                        \
   }                                                                           \
   bool Bridge##NAME(TYPE S) override {                                        \
-    const char *VN = otherside->getVisitorName();                             \
-    if (OptTraceRAV && VN) {                                                  \
+    const char *VN = OptTraceRAV ? otherside->getVisitorName() : nullptr;     \
+    if (VN) {                                                                 \
       errs() << VN << "::BridgeTraverse" #NAME "\n";                          \
     }                                                                         \
     return static_cast<RAV *>(this)->Traverse##NAME(S);                       \
@@ -43,9 +43,19 @@ public:
       clang::SourceLocation LocStart, clang::SourceLocation LocEnd);
 };
 
+// Tracing policies for XMLVisitorBase:
+// with NoTrace, TraverseMe##NAME formats no trace at all,
+// so that the untraced visitor pays nothing for tracing.
+struct NoTrace {
+  static constexpr bool enabled = false;
+};
+struct WithTrace {
+  static constexpr bool enabled = true;
+};
+
 // Main class: XMLVisitorBase<Derived>
 // this is CRTP (Curiously Recurring Template Pattern)
-template <class Derived, class OptContext = bool>
+template <class Derived, class OptContext = bool, class TracePolicy = NoTrace>
 class XMLVisitorBase : public XMLVisitorBaseImpl {
 protected:
   OptContext optContext;
@@ -85,6 +95,17 @@ public:                                                                       \
     return V.TraverseMe##NAME(S);                                             \
   }                                                                           \
   bool TraverseMe##NAME(TYPE S) {                                             \
+    if (TracePolicy::enabled || getDerived().FullTrace()) {                   \
+      TraceMe##NAME(S);                                                       \
+    }                                                                         \
+    if (!getDerived().PreVisit##NAME(S)) {                                    \
+      return true; /* avoid traverse children */                              \
+    }                                                                         \
+    bool ret = getDerived().TraverseChildOf##NAME(S);                         \
+    ret &= getDerived().PostVisit##NAME(S);                                   \
+    return ret;                                                               \
+  }                                                                           \
+  void TraceMe##NAME(TYPE S) {                                                \
     std::string comment("Traverse" #NAME ":");                                \
     llvm::raw_string_ostream OS(comment);                                     \
     OS << NameFor##NAME(S);                                                   \
@@ -103,12 +124,6 @@ public:                                                                       \
         newComment(OS.str().c_str());                                         \
       }                                                                       \
     }                                                                         \
-    if (!getDerived().PreVisit##NAME(S)) {                                    \
-      return true; /* avoid traverse children */                              \
-    }                                                                         \
-    bool ret = getDerived().TraverseChildOf##NAME(S);                         \
-    ret &= getDerived().PostVisit##NAME(S);                                   \
-    return ret;                                                               \
   }                                                                           \
   bool TraverseChildOf##NAME(TYPE S) {                                        \
     getDerived().otherside->Bridge##NAME(S);                                  \
@@ -0,0 +1,1058 @@
+#include "XcodeMlPasses.h"
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Set in xmlNode::_private on a node whose own rules have already
+// been applied by the running walk, which then only descends into it.
+char rewrittenMark;
+
+void
+markRewritten(xmlNodePtr node) {
+  node->_private = &rewrittenMark;
+}
+
+bool
+isRewritten(xmlNodePtr node) {
+  return node->_private == &rewrittenMark;
+}
+
+bool
+takeRewrittenMark(xmlNodePtr node) {
+  if (!isRewritten(node)) {
+    return false;
+  }
+  node->_private = nullptr;
+  return true;
+}
+
+bool
+isElement(xmlNodePtr node, const char *name) {
+  return node && node->type == XML_ELEMENT_NODE
+      && xmlStrEqual(node->name, BAD_CAST name);
+}
+
+bool
+hasProp(xmlNodePtr node, const char *name) {
+  return xmlHasProp(node, BAD_CAST name) != nullptr;
+}
+
+std::string
+getProp(xmlNodePtr node, const char *name) {
+  xmlChar *value = xmlGetProp(node, BAD_CAST name);
+  if (!value) {
+    return std::string();
+  }
+  std::string result(reinterpret_cast<const char *>(value));
+  xmlFree(value);
+  return result;
+}
+
+bool
+propEquals(xmlNodePtr node, const char *name, const char *value) {
+  return hasProp(node, name) && getProp(node, name) == value;
+}
+
+bool
+isTrueProp(xmlNodePtr node, const char *name) {
+  const auto value = getProp(node, name);
+  return value == "1" || value == "true";
+}
+
+bool
+isClass(xmlNodePtr node, const char *element, const char *className) {
+  return isElement(node, element) && propEquals(node, "class", className);
+}
+
+std::string
+getText(xmlNodePtr node) {
+  if (!node) {
+    return std::string();
+  }
+  xmlChar *content = xmlNodeGetContent(node);
+  if (!content) {
+    return std::string();
+  }
+  std::string result(reinterpret_cast<const char *>(content));
+  xmlFree(content);
+  return result;
+}
+
+std::vector<xmlNodePtr>
+elementChildren(xmlNodePtr node) {
+  std::vector<xmlNodePtr> result;
+  for (xmlNodePtr child = xmlFirstElementChild(node); child;
+       child = xmlNextElementSibling(child)) {
+    result.push_back(child);
+  }
+  return result;
+}
+
+std::vector<xmlNodePtr>
+elementChildren(xmlNodePtr node, const char *name) {
+  std::vector<xmlNodePtr> result;
+  for (xmlNodePtr child = xmlFirstElementChild(node); child;
+       child = xmlNextElementSibling(child)) {
+    if (isElement(child, name)) {
+      result.push_back(child);
+    }
+  }
+  return result;
+}
+
+xmlNodePtr
+firstElementChild(xmlNodePtr node, const char *name) {
+  for (xmlNodePtr child = xmlFirstElementChild(node); child;
+       child = xmlNextElementSibling(child)) {
+    if (isElement(child, name)) {
+      return child;
+    }
+  }
+  return nullptr;
+}
+
+void
+removeNode(xmlNodePtr node) {
+  xmlUnlinkNode(node);
+  xmlFreeNode(node);
+}
+
+void
+removeChildren(xmlNodePtr node) {
+  while (node->children) {
+    removeNode(node->children);
+  }
+}
+
+void
+removeProps(xmlNodePtr node) {
+  xmlFreePropList(node->properties);
+  node->properties = nullptr;
+}
+
+// Replace the content of `node` with `text`, taken verbatim
+// (unlike xmlNodeSetContent, which parses entity references).
+void
+setText(xmlNodePtr node, const std::string &text) {
+  removeChildren(node);
+  if (!text.empty()) {
+    xmlAddChild(node, xmlNewDocText(node->doc, BAD_CAST text.c_str()));
+  }
+}
+
+xmlNodePtr
+newChild(xmlNodePtr parent, const char *name) {
+  return xmlNewChild(parent, nullptr, BAD_CAST name, nullptr);
+}
+
+void
+copyNames(xmlNodePtr from, xmlNodePtr to) {
+  for (auto name : elementChildren(from, "name")) {
+    xmlAddChild(to, xmlDocCopyNode(name, to->doc, 1));
+  }
+}
+
+// Insert `nodes` in order as the first children of `parent`.
+void
+prependChildren(xmlNodePtr parent, const std::vector<xmlNodePtr> &nodes) {
+  xmlNodePtr first = parent->children;
+  for (auto node : nodes) {
+    if (first) {
+      xmlAddPrevSibling(first, node);
+    } else {
+      xmlAddChild(parent, node);
+    }
+  }
+}
+
+/*
+ * Passes over the clangAST document: drop_prop_*, reorder_decl,
+ * add_symbols_elem, add_globalsymbols_elem and handle_name_elem.
+ * Each of them rewrites a node from its own attributes and children
+ * as they are before any later pass runs, so they are fused into a
+ * single pre-order walk applying them to each node in pipeline order.
+ */
+class ClangAstRewriter {
+public:
+  explicit ClangAstRewriter(unsigned passes) : passes(passes) {}
+  void run(xmlNodePtr root);
+
+private:
+  bool isEnabled(XcodeMlPass) const;
+  bool isDropped(const xmlChar *) const;
+  void copyProps(xmlNodePtr, xmlNodePtr) const;
+  xmlNodePtr rewrite(xmlNodePtr, bool);
+  void dropProps(xmlNodePtr);
+  xmlNodePtr reorderDecl(xmlNodePtr);
+  void addSymbols(xmlNodePtr);
+  void addGlobalSymbols(xmlNodePtr);
+  void emitIdListInNamespace(xmlNodePtr, xmlNodePtr);
+  void emitIdListsInClass(xmlNodePtr, xmlNodePtr);
+  xmlNodePtr handleName(xmlNodePtr);
+
+  unsigned passes;
+};
+
+bool
+ClangAstRewriter::isEnabled(XcodeMlPass pass) const {
+  return passes & (1u << pass);
+}
+
+bool
+ClangAstRewriter::isDropped(const xmlChar *attr) const {
+  return (isEnabled(DropColumnPass) && xmlStrEqual(attr, BAD_CAST "column"))
+      || (isEnabled(DropFilePass) && xmlStrEqual(attr, BAD_CAST "file"))
+      || (isEnabled(DropLinenoPass) && xmlStrEqual(attr, BAD_CAST "lineno"));
+}
+
+/*!
+ * \brief Copy the attributes of \c from to \c to, overwriting
+ * the ones \c to already has, except those the drop_prop_* passes
+ * remove (\c from may not have been visited yet).
+ */
+void
+ClangAstRewriter::copyProps(xmlNodePtr from, xmlNodePtr to) const {
+  for (xmlAttrPtr attr = from->properties; attr; attr = attr->next) {
+    if (isDropped(attr->name)) {
+      continue;
+    }
+    const auto name = reinterpret_cast<const char *>(attr->name);
+    xmlSetProp(to, attr->name, BAD_CAST getProp(from, name).c_str());
+  }
+}
+
+void
+ClangAstRewriter::run(xmlNodePtr root) {
+  std::vector<xmlNodePtr> pending(1, root);
+  while (!pending.empty()) {
+    xmlNodePtr node = pending.back();
+    pending.pop_back();
+    if (!takeRewrittenMark(node)) {
+      node = rewrite(node, node == root);
+      if (!node) {
+        continue;
+      }
+    }
+    for (xmlNodePtr child = xmlLastElementChild(node); child;
+         child = xmlPreviousElementSibling(child)) {
+      pending.push_back(child);
+    }
+  }
+}
+
+/*!
+ * \brief Apply every enabled pass to \c node.
+ * \return The node now standing in its place, or nullptr if it
+ * was removed.
+ */
+xmlNodePtr
+ClangAstRewriter::rewrite(xmlNodePtr node, bool isRoot) {
+  dropProps(node);
+  if (isEnabled(ReorderDeclPass)) {
+    node = reorderDecl(node);
+  }
+  if (isEnabled(AddSymbolsPass)) {
+    addSymbols(node);
+  }
+  if (isEnabled(AddGlobalSymbolsPass) && isRoot) {
+    addGlobalSymbols(node);
+  }
+  if (isEnabled(HandleNamePass)) {
+    node = handleName(node);
+  }
+  return node;
+}
+
+void
+ClangAstRewriter::dropProps(xmlNodePtr node) {
+  if (isEnabled(DropColumnPass)) {
+    xmlUnsetProp(node, BAD_CAST "column");
+  }
+  if (isEnabled(DropFilePass)) {
+    xmlUnsetProp(node, BAD_CAST "file");
+  }
+  if (isEnabled(DropLinenoPass)) {
+    xmlUnsetProp(node, BAD_CAST "lineno");
+  }
+}
+
+/*!
+ * \brief Hoist the declaration out of a for-init-statement:
+ * `for (T x; ...) S` becomes `{ T x; for (; ...) S }`.
+ */
+xmlNodePtr
+ClangAstRewriter::reorderDecl(xmlNodePtr node) {
+  if (!isClass(node, "clangStmt", "ForStmt")) {
+    return node;
+  }
+  const auto init = firstElementChild(node, "clangStmt");
+  if (!init || !propEquals(init, "class", "DeclStmt")) {
+    return node;
+  }
+  xmlNodePtr compound =
+      xmlNewDocNode(node->doc, nullptr, BAD_CAST "clangStmt", nullptr);
+  xmlNewProp(compound, BAD_CAST "class", BAD_CAST "CompoundStmt");
+  xmlReplaceNode(node, compound);
+  xmlNodePtr first = xmlFirstElementChild(node);
+  xmlUnlinkNode(first);
+  xmlAddChild(compound, first);
+  xmlAddChild(compound, node);
+  markRewritten(node);
+  return compound;
+}
+
+void
+ClangAstRewriter::addSymbols(xmlNodePtr node) {
+  if (!isClass(node, "clangStmt", "CompoundStmt")) {
+    return;
+  }
+  xmlNodePtr symbols =
+      xmlNewDocNode(node->doc, nullptr, BAD_CAST "symbols", nullptr);
+  for (auto stmt : elementChildren(node, "clangStmt")) {
+    if (!propEquals(stmt, "class", "DeclStmt")) {
+      continue;
+    }
+    for (auto decl : elementChildren(stmt)) {
+      xmlNodePtr id = newChild(symbols, "id");
+      xmlNewProp(id,
+          BAD_CAST "type",
+          BAD_CAST getProp(decl, "xcodemlType").c_str());
+      xmlNewProp(id,
+          BAD_CAST "sclass",
+          BAD_CAST(propEquals(decl, "class", "Var") ? "auto" : "__unknown__"));
+      copyNames(decl, id);
+    }
+  }
+  prependChildren(node, {symbols});
+}
+
+void
+ClangAstRewriter::addGlobalSymbols(xmlNodePtr root) {
+  if (!isElement(root, "clangAST")) {
+    return;
+  }
+  xmlNodePtr typeTable =
+      xmlNewDocNode(root->doc, nullptr, BAD_CAST "typeTable", nullptr);
+  xmlNodePtr nnsTable =
+      xmlNewDocNode(root->doc, nullptr, BAD_CAST "nnsTable", nullptr);
+  xmlNodePtr globalSymbols =
+      xmlNewDocNode(root->doc, nullptr, BAD_CAST "globalSymbols", nullptr);
+  for (auto unit : elementChildren(root, "clangDecl")) {
+    if (!propEquals(unit, "class", "TranslationUnit")) {
+      continue;
+    }
+    for (auto table : elementChildren(unit, "xcodemlTypeTable")) {
+      for (auto type : elementChildren(table)) {
+        xmlAddChild(typeTable, xmlDocCopyNode(type, root->doc, 1));
+      }
+    }
+    for (auto table : elementChildren(unit, "xcodemlNnsTable")) {
+      for (auto nns : elementChildren(table)) {
+        xmlAddChild(nnsTable, xmlDocCopyNode(nns, root->doc, 1));
+      }
+    }
+    emitIdListInNamespace(unit, globalSymbols);
+  }
+  for (xmlNodePtr child = root->children; child;) {
+    xmlNodePtr next = child->next;
+    if (!isElement(child, "clangDecl")) {
+      removeNode(child);
+    }
+    child = next;
+  }
+  prependChildren(root, {typeTable, nnsTable, globalSymbols});
+}
+
+void
+ClangAstRewriter::emitIdListInNamespace(xmlNodePtr ns, xmlNodePtr symbols) {
+  for (auto decl : elementChildren(ns, "clangDecl")) {
+    const auto className = getProp(decl, "class");
+    if (className == "LinkageSpec") {
+      emitIdListInNamespace(decl, symbols);
+    } else if (className == "CXXRecord") {
+      xmlNodePtr id = newChild(symbols, "id");
+      xmlNewProp(id, BAD_CAST "sclass", BAD_CAST "class_name");
+      xmlNewProp(id,
+          BAD_CAST "type",
+          BAD_CAST getProp(decl, "xcodemlType").c_str());
+      copyNames(decl, id);
+      emitIdListsInClass(decl, symbols);
+    } else if (className == "Typedef") {
+      xmlNodePtr id = newChild(symbols, "id");
+      xmlNewProp(id, BAD_CAST "sclass", BAD_CAST "typedef_name");
+      copyProps(decl, id);
+      xmlSetProp(id,
+          BAD_CAST "type",
+          BAD_CAST getProp(decl, "xcodemlTypedefType").c_str());
+      copyNames(decl, id);
+    } else if (firstElementChild(decl, "name")
+        && hasProp(decl, "xcodemlType")) {
+      xmlNodePtr id = newChild(symbols, "id");
+      xmlNewProp(id,
+          BAD_CAST "type",
+          BAD_CAST getProp(decl, "xcodemlType").c_str());
+      xmlNewProp(id,
+          BAD_CAST "sclass",
+          BAD_CAST(className == "Function" ? "extern_def" : "__unknown__"));
+      copyNames(decl, id);
+    }
+  }
+}
+
+/*!
+ * \brief Emit the functions defined in friend declarations of a class,
+ * which belong to the enclosing namespace.
+ */
+void
+ClangAstRewriter::emitIdListsInClass(xmlNodePtr record, xmlNodePtr symbols) {
+  for (auto decl : elementChildren(record, "clangDecl")) {
+    if (propEquals(decl, "class", "Friend")) {
+      xmlNodePtr function = nullptr;
+      for (auto friendDecl : elementChildren(decl, "clangDecl")) {
+        if (propEquals(friendDecl, "class", "Function")) {
+          function = friendDecl;
+          break;
+        }
+      }
+      if (!function) {
+        continue;
+      }
+      xmlNodePtr id = newChild(symbols, "id");
+      xmlNewProp(id, BAD_CAST "sclass", BAD_CAST "__friend__");
+      xmlNewProp(id,
+          BAD_CAST "type",
+          BAD_CAST getProp(function, "xcodemlType").c_str());
+      setText(newChild(id, "name"),
+          getText(firstElementChild(function, "name")));
+    } else if (propEquals(decl, "class", "CXXRecord")) {
+      emitIdListsInClass(decl, symbols);
+    }
+  }
+}
+
+xmlNodePtr
+ClangAstRewriter::handleName(xmlNodePtr node) {
+  if (isElement(node, "paramTypeName")) {
+    const bool hasType = hasProp(node, "type");
+    const auto type = getProp(node, "type");
+    xmlNodeSetName(node, BAD_CAST "name");
+    removeProps(node);
+    removeChildren(node);
+    if (hasType) {
+      xmlNewProp(node, BAD_CAST "type", BAD_CAST type.c_str());
+    }
+    return node;
+  }
+  if (!isElement(node, "name")) {
+    return node;
+  }
+  const auto kind = getProp(node, "name_kind");
+  bool hasText;
+  if (kind == "name" || kind == "operator") {
+    hasText = true;
+  } else if (kind == "constructor" || kind == "destructor"
+      || kind == "conversion") {
+    hasText = false;
+  } else {
+    removeNode(node);
+    return nullptr;
+  }
+  const auto text = getText(node);
+  xmlNodeSetName(node, BAD_CAST kind.c_str());
+  // The attributes of the name itself take precedence.
+  xmlNodePtr qualified =
+      xmlDocCopyNode(node, node->doc, 2 /* attributes only */);
+  removeProps(node);
+  for (auto nns : elementChildren(node->parent, "clangNestedNameSpecifier")) {
+    copyProps(nns, node);
+  }
+  copyProps(qualified, node);
+  xmlFreeNode(qualified);
+  setText(node, hasText ? text : std::string());
+  return node;
+}
+
+/*
+ * The element children of a node being rebuilt, detached from it on
+ * construction (its other children are freed) and freed on
+ * destruction unless they were attached somewhere in the meantime.
+ */
+class DetachedChildren {
+public:
+  explicit DetachedChildren(xmlNodePtr);
+  DetachedChildren(const DetachedChildren &) = delete;
+  DetachedChildren &operator=(const DetachedChildren &) = delete;
+  ~DetachedChildren();
+  xmlNodePtr at(size_t) const;
+  std::vector<xmlNodePtr> from(size_t) const;
+  std::vector<xmlNodePtr> named(const char *) const;
+  std::vector<xmlNodePtr> named(const char *, const char *) const;
+  std::vector<xmlNodePtr> withProp(const char *, const char *) const;
+
+private:
+  std::vector<xmlNodePtr> elements;
+};
+
+DetachedChildren::DetachedChildren(xmlNodePtr parent) {
+  while (xmlNodePtr child = parent->children) {
+    if (child->type == XML_ELEMENT_NODE) {
+      xmlUnlinkNode(child);
+      elements.push_back(child);
+    } else {
+      removeNode(child);
+    }
+  }
+}
+
+DetachedChildren::~DetachedChildren() {
+  for (auto element : elements) {
+    if (!element->parent) {
+      xmlFreeNode(element);
+    }
+  }
+}
+
+/*!
+ * \brief Return the element at \c position (1-origin, as in `*[n]`),
+ * or nullptr.
+ */
+xmlNodePtr
+DetachedChildren::at(size_t position) const {
+  return position - 1 < elements.size() ? elements[position - 1] : nullptr;
+}
+
+/*!
+ * \brief Return the elements from \c position on (1-origin, as in
+ * `*[position() >= n]`).
+ */
+std::vector<xmlNodePtr>
+DetachedChildren::from(size_t position) const {
+  if (position - 1 >= elements.size()) {
+    return {};
+  }
+  return std::vector<xmlNodePtr>(elements.begin() + (position - 1),
+      elements.end());
+}
+
+std::vector<xmlNodePtr>
+DetachedChildren::named(const char *name) const {
+  std::vector<xmlNodePtr> result;
+  for (auto element : elements) {
+    if (isElement(element, name)) {
+      result.push_back(element);
+    }
+  }
+  return result;
+}
+
+std::vector<xmlNodePtr>
+DetachedChildren::named(const char *name, const char *className) const {
+  std::vector<xmlNodePtr> result;
+  for (auto element : elements) {
+    if (isClass(element, name, className)) {
+      result.push_back(element);
+    }
+  }
+  return result;
+}
+
+std::vector<xmlNodePtr>
+DetachedChildren::withProp(const char *name, const char *value) const {
+  std::vector<xmlNodePtr> result;
+  for (auto element : elements) {
+    if (propEquals(element, name, value)) {
+      result.push_back(element);
+    }
+  }
+  return result;
+}
+
+using Worklist = std::vector<xmlNodePtr>;
+
+/*!
+ * \brief Append \c child to \c parent and schedule it for rewriting,
+ * unless it is null or already attached (when two selections of a
+ * rule overlap).
+ */
+void
+append(xmlNodePtr parent, xmlNodePtr child, Worklist &next) {
+  if (!child || child->parent) {
+    return;
+  }
+  xmlAddChild(parent, child);
+  next.push_back(child);
+}
+
+void
+append(xmlNodePtr parent, const std::vector<xmlNodePtr> &children,
+    Worklist &next) {
+  for (auto child : children) {
+    append(parent, child, next);
+  }
+}
+
+void
+appendGrandchildren(xmlNodePtr parent, const std::vector<xmlNodePtr> &children,
+    Worklist &next) {
+  for (auto child : children) {
+    for (auto grandchild : elementChildren(child)) {
+      xmlUnlinkNode(grandchild);
+      append(parent, grandchild, next);
+    }
+  }
+}
+
+/*
+ * Program2XcodeProgram: turn the clangAST document into an
+ * XcodeProgram one. Every rule selects the children of the node it
+ * matches by element name and position, so it runs as a separate
+ * pre-order walk after the passes of ClangAstRewriter. Nodes built
+ * by a rule are final; only the original children it keeps are
+ * rewritten in turn.
+ */
+class XcodeProgramBuilder {
+public:
+  void run(xmlNodePtr root);
+
+private:
+  Worklist rewrite(xmlNodePtr);
+  Worklist rewriteDecl(xmlNodePtr);
+  Worklist rewriteStmt(xmlNodePtr);
+  void rewriteName(xmlNodePtr);
+  static void renameProps(xmlNodePtr);
+};
+
+void
+XcodeProgramBuilder::run(xmlNodePtr root) {
+  Worklist pending(1, root);
+  while (!pending.empty()) {
+    xmlNodePtr node = pending.back();
+    pending.pop_back();
+    const auto next =
+        takeRewrittenMark(node) ? elementChildren(node) : rewrite(node);
+    pending.insert(pending.end(), next.rbegin(), next.rend());
+  }
+}
+
+/*!
+ * \brief Rename \c xcodemlType to \c type and \c valueCategory to
+ * \c reference. When that clashes with another attribute, the one
+ * coming later wins.
+ */
+void
+XcodeProgramBuilder::renameProps(xmlNodePtr node) {
+  if (!hasProp(node, "xcodemlType") && !hasProp(node, "valueCategory")) {
+    return;
+  }
+  std::vector<std::pair<std::string, std::string>> props;
+  for (xmlAttrPtr attr = node->properties; attr; attr = attr->next) {
+    std::string name(reinterpret_cast<const char *>(attr->name));
+    auto value = getProp(node, name.c_str());
+    if (name == "xcodemlType") {
+      name = "type";
+    } else if (name == "valueCategory") {
+      name = "reference";
+      value = value == "lvalue" ? "lvalue" : "rvalue";
+    }
+    props.emplace_back(name, value);
+  }
+  removeProps(node);
+  for (const auto &prop : props) {
+    xmlSetProp(node,
+        BAD_CAST prop.first.c_str(),
+        BAD_CAST prop.second.c_str());
+  }
+}
+
+/*!
+ * \brief Rewrite a \c name, which takes the attributes of the
+ * nested name specifiers next to it. Done as soon as its parent is
+ * reached, before the parent's rule moves it away from them.
+ */
+void
+XcodeProgramBuilder::rewriteName(xmlNodePtr name) {
+  renameProps(name);
+  std::map<std::string, std::string> qualifier;
+  for (auto nns : elementChildren(name->parent, "clangNestedNameSpecifier")) {
+    for (xmlAttrPtr attr = nns->properties; attr; attr = attr->next) {
+      const auto key = reinterpret_cast<const char *>(attr->name);
+      qualifier[key] = getProp(nns, key);
+    }
+  }
+  for (const auto &attr : qualifier) {
+    if (!hasProp(name, attr.first.c_str())) {
+      xmlNewProp(name,
+          BAD_CAST attr.first.c_str(),
+          BAD_CAST attr.second.c_str());
+    }
+  }
+  setText(name, getText(name));
+  markRewritten(name);
+}
+
+Worklist
+XcodeProgramBuilder::rewrite(xmlNodePtr node) {
+  for (auto child : elementChildren(node, "name")) {
+    if (!isRewritten(child)) {
+      rewriteName(child);
+    }
+  }
+
+  if (isElement(node, "clangDecl")) {
+    return rewriteDecl(node);
+  }
+  if (isElement(node, "clangStmt")) {
+    return rewriteStmt(node);
+  }
+  if (isElement(node, "clangAST")) {
+    xmlNodeSetName(node, BAD_CAST "XcodeProgram");
+    renameProps(node);
+  } else if (isElement(node, "name")) {
+    rewriteName(node);
+    return {};
+  } else if (isElement(node, "enumType")) {
+    Worklist next;
+    std::vector<xmlNodePtr> constants;
+    for (auto symbols : elementChildren(node, "symbols")) {
+      for (auto decl : elementChildren(symbols, "clangDecl")) {
+        if (propEquals(decl, "class", "EnumConstant")) {
+          for (auto name : elementChildren(decl, "name")) {
+            rewriteName(name);
+          }
+          constants.push_back(decl);
+        }
+      }
+    }
+    renameProps(node);
+    xmlNodePtr symbols =
+        xmlNewDocNode(node->doc, nullptr, BAD_CAST "symbols", nullptr);
+    for (auto decl : constants) {
+      xmlNodePtr id = newChild(symbols, "id");
+      for (auto name : elementChildren(decl, "name")) {
+        xmlUnlinkNode(name);
+        append(id, name, next);
+      }
+    }
+    removeChildren(node);
+    xmlAddChild(node, symbols);
+    return next;
+  } else if (isElement(node, "clangConstructorInitializer")) {
+    if (!isTrueProp(node, "is_written")) {
+      removeNode(node);
+      return {};
+    }
+    Worklist next;
+    DetachedChildren children(node);
+    xmlNodeSetName(node, BAD_CAST "constructorInitializer");
+    if (hasProp(node, "xcodemlType")) {
+      xmlSetProp(node,
+          BAD_CAST "type",
+          BAD_CAST getProp(node, "xcodemlType").c_str());
+    }
+    const auto stmts = children.named("clangStmt");
+    if (!stmts.empty()) {
+      append(node, stmts.front(), next);
+    }
+    return next;
+  } else if (isElement(node, "sizeOfExpr")) {
+    Worklist next;
+    DetachedChildren children(node);
+    removeProps(node);
+    append(node, children.at(1), next);
+    return next;
+  } else {
+    renameProps(node);
+  }
+  return elementChildren(node);
+}
+
+Worklist
+XcodeProgramBuilder::rewriteDecl(xmlNodePtr node) {
+  const auto className = getProp(node, "class");
+  if (className == "TranslationUnit") {
+    xmlNodeSetName(node, BAD_CAST "globalDeclarations");
+    removeProps(node);
+    return elementChildren(node);
+  }
+  if (className == "Record"
+      || ((className == "Function" || className == "CXXMethod"
+              || className == "CXXConversion" || className == "CXXConstructor"
+              || className == "CXXDestructor" || className == "Var")
+          && isTrueProp(node, "is_implicit"))) {
+    removeNode(node);
+    return {};
+  }
+
+  Worklist next;
+  if (className == "Function" || className == "CXXMethod"
+      || className == "CXXConversion" || className == "CXXConstructor"
+      || className == "CXXDestructor") {
+    const bool isDefinition = firstElementChild(node, "clangStmt") != nullptr;
+    DetachedChildren children(node);
+    renameProps(node);
+    append(node, children.named("name"), next);
+    if (!isDefinition) {
+      xmlNodeSetName(node, BAD_CAST "functionDecl");
+      return next;
+    }
+    xmlNodeSetName(node, BAD_CAST "functionDefinition");
+    append(node, children.named("clangTypeLoc"), next);
+    if (className == "CXXConstructor") {
+      append(newChild(node, "constructorInitializerList"),
+          children.named("clangConstructorInitializer"),
+          next);
+    }
+    append(newChild(node, "body"), children.named("clangStmt"), next);
+  } else if (className == "Var") {
+    const bool hasInit = getProp(node, "has_init") == "1";
+    DetachedChildren children(node);
+    xmlNodeSetName(node, BAD_CAST "varDecl");
+    renameProps(node);
+    append(node, children.named("name"), next);
+    if (hasInit) {
+      append(newChild(node, "value"), children.named("clangStmt"), next);
+    }
+  } else if (className == "Field" || className == "Using") {
+    DetachedChildren children(node);
+    xmlNodeSetName(node,
+        BAD_CAST(className == "Field" ? "varDecl" : "usingDecl"));
+    renameProps(node);
+    append(node, children.named("name"), next);
+  } else {
+    renameProps(node);
+    return elementChildren(node);
+  }
+  return next;
+}
+
+Worklist
+XcodeProgramBuilder::rewriteStmt(xmlNodePtr node) {
+  const auto className = getProp(node, "class");
+  Worklist next;
+
+  if (className == "DeclStmt") {
+    next = elementChildren(node);
+    while (xmlNodePtr child = node->children) {
+      xmlUnlinkNode(child);
+      xmlAddPrevSibling(node, child);
+    }
+    removeNode(node);
+    return next;
+  }
+  if (className == "DefaultStmt") {
+    next = elementChildren(node);
+    xmlNodeSetName(node, BAD_CAST "defaultLabel");
+    removeProps(node);
+    while (xmlNodePtr child = node->last) {
+      xmlUnlinkNode(child);
+      xmlAddNextSibling(node, child);
+    }
+    return next;
+  }
+  if (className == "CaseStmt") {
+    DetachedChildren children(node);
+    xmlNodeSetName(node, BAD_CAST "caseLabel");
+    removeProps(node);
+    append(newChild(node, "value"), children.at(1), next);
+    const auto rest = children.from(2);
+    for (auto it = rest.rbegin(); it != rest.rend(); ++it) {
+      xmlAddNextSibling(node, *it);
+    }
+    next.insert(next.end(), rest.begin(), rest.end());
+    return next;
+  }
+  if (className == "CompoundStmt" || className == "ReturnStmt"
+      || className == "ArraySubscriptExpr" || className == "InitListExpr") {
+    if (className == "CompoundStmt") {
+      xmlNodeSetName(node, BAD_CAST "compoundStatement");
+      renameProps(node);
+    } else {
+      xmlNodeSetName(node,
+          BAD_CAST(className == "ReturnStmt"
+                  ? "returnStatement"
+                  : className == "ArraySubscriptExpr" ? "arrayRef" : "value"));
+      removeProps(node);
+    }
+    return elementChildren(node);
+  }
+  if (className == "CXXThisExpr") {
+    xmlNodeSetName(node, BAD_CAST "thisExpr");
+    removeProps(node);
+    removeChildren(node);
+    return next;
+  }
+
+  const bool isBinOp =
+      (className == "BinaryOperator" || className == "CompoundAssignOperator")
+      && hasProp(node, "binOpName");
+  const bool isUnaryOp =
+      className == "UnaryOperator" && hasProp(node, "unaryOpName");
+  if (isBinOp || isUnaryOp) {
+    const auto opName = getProp(node, isBinOp ? "binOpName" : "unaryOpName");
+    DetachedChildren children(node);
+    xmlNodeSetName(node, BAD_CAST opName.c_str());
+    renameProps(node);
+    append(node, children.at(1), next);
+    if (isBinOp) {
+      append(node, children.at(2), next);
+    }
+  } else if (className == "IfStmt") {
+    DetachedChildren children(node);
+    xmlNodeSetName(node, BAD_CAST "ifStatement");
+    renameProps(node);
+    append(newChild(node, "condition"), children.at(1), next);
+    append(newChild(node, "then"), children.at(2), next);
+    append(newChild(node, "else"), children.at(3), next);
+  } else if (className == "SwitchStmt") {
+    DetachedChildren children(node);
+    xmlNodeSetName(node, BAD_CAST "switchStatement");
+    removeProps(node);
+    append(newChild(node, "value"), children.at(1), next);
+    append(newChild(node, "body"), children.from(2), next);
+  } else if (className == "WhileStmt" || className == "DoStmt") {
+    const bool isWhile = className == "WhileStmt";
+    DetachedChildren children(node);
+    xmlNodeSetName(node, BAD_CAST(isWhile ? "whileStatement" : "doStatement"));
+    renameProps(node);
+    append(newChild(node, isWhile ? "condition" : "body"),
+        children.at(1),
+        next);
+    append(newChild(node, isWhile ? "body" : "condition"),
+        children.at(2),
+        next);
+  } else if (className == "ForStmt") {
+    DetachedChildren children(node);
+    xmlNodeSetName(node, BAD_CAST "forStatement");
+    removeProps(node);
+    append(newChild(node, "init"),
+        children.withProp("for_stmt_kind", "init"),
+        next);
+    append(newChild(node, "condition"),
+        children.withProp("for_stmt_kind", "cond"),
+        next);
+    append(newChild(node, "iter"),
+        children.withProp("for_stmt_kind", "iter"),
+        next);
+    append(newChild(node, "body"),
+        children.withProp("for_stmt_kind", "body"),
+        next);
+  } else if (className == "ConditionalOperator"
+      || className == "BinaryConditionalOperator") {
+    DetachedChildren children(node);
+    xmlNodeSetName(node, BAD_CAST "condExpr");
+    renameProps(node);
+    append(node, children.at(1), next);
+    append(node, children.at(2), next);
+    if (className == "ConditionalOperator") {
+      append(node, children.at(3), next);
+    }
+  } else if (className == "CallExpr") {
+    DetachedChildren children(node);
+    xmlNodeSetName(node, BAD_CAST "functionCall");
+    renameProps(node);
+    append(newChild(node, "function"), children.at(1), next);
+    append(newChild(node, "arguments"), children.from(2), next);
+  } else if (className == "CXXOperatorCallExpr") {
+    const auto callee = firstElementChild(node, "clangStmt");
+    const auto decl = callee ? firstElementChild(callee, "clangStmt") : nullptr;
+    const bool isMember = decl && propEquals(decl, "declkind", "CXXMethod");
+    const auto opKind = getProp(node, "xcodeml_operator_kind");
+    DetachedChildren children(node);
+    xmlNodeSetName(node, BAD_CAST "functionCall");
+    renameProps(node);
+    if (isMember) {
+      xmlNodePtr member = newChild(newChild(node, "memberFunction"), "memberExpr");
+      const auto stmts = children.named("clangStmt");
+      if (stmts.size() > 1) {
+        append(member, stmts[1], next);
+      }
+      xmlNodePtr name = newChild(member, "name");
+      xmlNewProp(name, BAD_CAST "name_kind", BAD_CAST "operator");
+      setText(name, opKind);
+      append(newChild(node, "arguments"), children.from(3), next);
+    } else {
+      setText(newChild(node, "operator"), opKind);
+      append(newChild(node, "arguments"), children.from(2), next);
+    }
+  } else if (className == "CXXNewExpr") {
+    const bool isArray = isTrueProp(node, "is_new_array");
+    DetachedChildren children(node);
+    renameProps(node);
+    const auto stmts = children.named("clangStmt");
+    if (isArray) {
+      xmlNodeSetName(node, BAD_CAST "newArrayExpr");
+      xmlNodePtr size = newChild(node, "size");
+      if (!stmts.empty()) {
+        append(size, stmts.front(), next);
+      }
+      if (stmts.size() > 1) {
+        appendGrandchildren(newChild(node, "arguments"),
+            children.named("clangStmt", "InitListExpr"),
+            next);
+      }
+    } else {
+      xmlNodeSetName(node, BAD_CAST "newExpr");
+      if (!stmts.empty()) {
+        xmlNodePtr arguments = newChild(node, "arguments");
+        const auto constructs = children.named("clangStmt", "CXXConstructExpr");
+        if (constructs.empty()) {
+          append(arguments, stmts, next);
+        } else {
+          appendGrandchildren(arguments, constructs, next);
+        }
+      }
+    }
+  } else if (className == "ImplicitCastExpr" || className == "CStyleCastExpr") {
+    const bool isImplicit = className == "ImplicitCastExpr";
+    DetachedChildren children(node);
+    xmlNodeSetName(node, BAD_CAST(isImplicit ? "implicitCastExpr" : "castExpr"));
+    renameProps(node);
+    append(node, children.at(isImplicit ? 1 : 2), next);
+  } else if (className == "StringLiteral") {
+    xmlNodeSetName(node, BAD_CAST "stringConstant");
+    renameProps(node);
+    setText(node, getProp(node, "stringLiteral"));
+  } else if (className == "CXXMemberCallExpr") {
+    DetachedChildren children(node);
+    xmlNodeSetName(node, BAD_CAST "functionCall");
+    removeProps(node);
+    const auto stmts = children.named("clangStmt");
+    xmlNodePtr function = newChild(node, "memberFunction");
+    xmlNodePtr arguments = newChild(node, "arguments");
+    for (size_t i = 0; i < stmts.size(); ++i) {
+      append(i == 0 ? function : arguments, stmts[i], next);
+    }
+  } else if (className == "MemberExpr") {
+    const bool isAnon = isTrueProp(node, "is_access_to_anon_record");
+    const bool isArrow = isTrueProp(node, "is_arrow");
+    DetachedChildren children(node);
+    xmlNodeSetName(node,
+        BAD_CAST(isAnon ? "xcodemlAccessToAnonRecordExpr"
+                        : isArrow ? "memberRef" : "memberExpr"));
+    renameProps(node);
+    if (!isAnon) {
+      append(node, children.named("clangStmt"), next);
+    }
+    append(node, children.named("name"), next);
+  } else {
+    renameProps(node);
+    return elementChildren(node);
+  }
+  return next;
+}
+
+} // namespace
+
+void
+runXcodeMlPasses(xmlNodePtr root, unsigned passes) {
+  if (passes & ~(1u << ToXcodeProgramPass)) {
+    ClangAstRewriter(passes).run(root);
+  }
+  if (passes & (1u << ToXcodeProgramPass)) {
+    XcodeProgramBuilder().run(root);
+  }
+}
@@ -0,0 +1,24 @@
+#ifndef XCODEMLPASSES_H
+#define XCODEMLPASSES_H
+
+#include <libxml/tree.h>
+
+// Post-processing passes over the tree built by DeclarationsVisitor.
+// Each one replaces the stylesheet of the same name in XSLTs/;
+// they run in the order listed here.
+enum XcodeMlPass {
+  DropColumnPass,       // drop_prop_column.xsl
+  DropFilePass,         // drop_prop_file.xsl
+  DropLinenoPass,       // drop_prop_lineno.xsl
+  ReorderDeclPass,      // reorder_decl.xsl
+  AddSymbolsPass,       // add_symbols_elem.xsl
+  AddGlobalSymbolsPass, // add_globalsymbols_elem.xsl
+  HandleNamePass,       // handle_name_elem.xsl
+  ToXcodeProgramPass,   // Program2XcodeProgram.xsl
+};
+
+// Rewrite the tree rooted at `root` in place, running every pass
+// whose bit (1 << XcodeMlPass) is set in `passes`.
+void runXcodeMlPasses(xmlNodePtr root, unsigned passes);
+
+#endif /* !XCODEMLPASSES_H */
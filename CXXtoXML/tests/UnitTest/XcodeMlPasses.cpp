@@ -0,0 +1,117 @@
+#define BOOST_TEST_MODULE XcodeMlPasses
+#include <boost/test/included/unit_test.hpp>
+#include <memory>
+#include <string>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include <libxslt/transform.h>
+#include <libxslt/xsltInternals.h>
+
+#include "XcodeMlPasses.h"
+
+namespace {
+
+const char *const sample = "XcodeMlPasses_sample.xml";
+const std::string xsltDir = "../../src/XSLTs/";
+
+// The stylesheets replaced by the passes, in the order of XcodeMlPass.
+const char *const stylesheets[] = {
+    "drop_prop_column.xsl",
+    "drop_prop_file.xsl",
+    "drop_prop_lineno.xsl",
+    "reorder_decl.xsl",
+    "add_symbols_elem.xsl",
+    "add_globalsymbols_elem.xsl",
+    "handle_name_elem.xsl",
+    "Program2XcodeProgram.xsl",
+};
+const unsigned numPasses = sizeof(stylesheets) / sizeof(stylesheets[0]);
+
+using DocPtr = std::unique_ptr<xmlDoc, decltype(&xmlFreeDoc)>;
+
+DocPtr
+readSample() {
+  DocPtr doc(xmlReadFile(sample, nullptr, XML_PARSE_NOBLANKS), xmlFreeDoc);
+  BOOST_REQUIRE(doc);
+  return doc;
+}
+
+std::string
+dump(xmlDocPtr doc) {
+  xmlBufferPtr buffer = xmlBufferCreate();
+  xmlNodeDump(buffer, doc, xmlDocGetRootElement(doc), 0, 1);
+  const std::string result(reinterpret_cast<const char *>(buffer->content));
+  xmlBufferFree(buffer);
+  return result;
+}
+
+std::string
+replaceAll(std::string str, const std::string &from, const std::string &to) {
+  for (auto pos = str.find(from); pos != std::string::npos;
+       pos = str.find(from, pos + to.size())) {
+    str.replace(pos, from.size(), to);
+  }
+  return str;
+}
+
+size_t
+count(const std::string &str, const std::string &pattern) {
+  size_t n = 0;
+  for (auto pos = str.find(pattern); pos != std::string::npos;
+       pos = str.find(pattern, pos + pattern.size())) {
+    ++n;
+  }
+  return n;
+}
+
+// Returns the sample as the first `n` stylesheets leave it.
+std::string
+runStylesheets(unsigned n) {
+  auto doc = readSample();
+  for (unsigned i = 0; i < n; ++i) {
+    const auto path = xsltDir + stylesheets[i];
+    const xsltStylesheetPtr style =
+        xsltParseStylesheetFile(BAD_CAST path.c_str());
+    BOOST_REQUIRE_MESSAGE(style, "cannot read " + path);
+    DocPtr result(xsltApplyStylesheet(style, doc.get(), nullptr), xmlFreeDoc);
+    xsltFreeStylesheet(style);
+    BOOST_REQUIRE(result);
+    doc = std::move(result);
+  }
+  return dump(doc.get());
+}
+
+// Returns the sample as the first `n` passes leave it.
+std::string
+runPasses(unsigned n) {
+  auto doc = readSample();
+  runXcodeMlPasses(xmlDocGetRootElement(doc.get()), (1u << n) - 1);
+  return dump(doc.get());
+}
+
+BOOST_AUTO_TEST_SUITE(xcodeml_passes)
+
+// The sample has no nested for loop, whose init declaration only the
+// reorder_decl pass hoists.
+BOOST_AUTO_TEST_CASE(stylesheet_test) {
+  const auto input = dump(readSample().get());
+  const auto lvalues = count(input, "valueCategory=\"lvalue\"");
+  BOOST_REQUIRE_GT(lvalues, 0);
+
+  for (unsigned n = 1; n <= numPasses; ++n) {
+    BOOST_TEST_CHECKPOINT("Passes up to " << stylesheets[n - 1]);
+    const auto expected = runStylesheets(n);
+    const auto actual = runPasses(n);
+    // The stylesheets map every valueCategory to reference="rvalue";
+    // the passes keep lvalues.
+    BOOST_CHECK_EQUAL(count(actual, "reference=\"lvalue\""),
+        count(expected, "reference=") == 0 ? 0 : lvalues);
+    BOOST_CHECK_EQUAL(
+        replaceAll(actual, "reference=\"lvalue\"", "reference=\"rvalue\""),
+        expected);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace
@@ -2,4 +2,11 @@ extern llvm::cl::OptionCategory CXX2XMLCategory;
 
 namespace CXXtoXML{
   extern bool debug_flag;
+  extern bool iterative_stmt_traversal;
+  extern unsigned literal_list_threshold;
+  extern std::string index_file;
+  extern std::string trace_file;
+  extern unsigned trace_threshold;
+  extern bool hoist_types;
+  extern bool declarations_only;
 }
@@ -1,20 +1,22 @@
 #ifndef HASH_H
 #define HASH_H
 
+#include "llvm/ADT/Hashing.h"
 #include "clang/AST/Type.h"
 #include <unordered_map>
 
 namespace std {
+/*!
+ * \brief Hash a type by its opaque pointer.
+ *
+ * The pointer is mixed since its low bits hold the (mostly zero)
+ * qualifiers and the alignment of the type. Prefer llvm::DenseMap,
+ * which clang/AST/Type.h already provides a key info for.
+ */
 template <>
 struct hash<clang::QualType> {
   size_t operator()(const clang::QualType T) const {
-    union union_for_hash {
-      size_t value;
-      clang::QualType originalT;
-      union_for_hash(clang::QualType T) : originalT(T){};
-    };
-    const union_for_hash tmp(T);
-    return tmp.value;
+    return llvm::hash_value(T.getAsOpaquePtr());
   }
 };
 }
@@ -44,7 +44,7 @@ BaseClass::isVirtual() {
 
 std::vector<BaseClass>
 InheritanceInfo::getInheritance(clang::QualType type) {
-  return inheritance[type];
+  return inheritance.lookup(type);
 }
 
 void
@@ -1,6 +1,7 @@
 #ifndef INHERITANCEINFO_H
 #define INHERITANCEINFO_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "Hash.h"
 #include <vector>
 #include <string>
@@ -28,7 +29,7 @@ public:
 };
 
 class InheritanceInfo {
-  std::unordered_map<clang::QualType, std::vector<BaseClass>> inheritance;
+  llvm::DenseMap<clang::QualType, std::vector<BaseClass>> inheritance;
 
 public:
   InheritanceInfo() = default;
@@ -0,0 +1,55 @@
+#include <libxml/tree.h>
+#include <libxml/dict.h>
+#include <cstdio>
+
+#include "LibXMLUtil.h"
+
+/*!
+ * \brief Return the copy of \c str owned by \c dict, made by the first
+ * call with an equal string.
+ */
+const xmlChar *
+internString(xmlDictPtr dict, const char *str) {
+  return xmlDictLookup(dict, BAD_CAST str, -1);
+}
+
+/*!
+ * \brief Add an attribute whose value is shared with the other
+ * occurrences of it in the document instead of being copied.
+ *
+ * Meant for the values repeated all over the output: type and NNS
+ * names, class names, file names and flags. The name of the attribute
+ * and the value are looked up in the dictionary of the document of
+ * \c node, unless the value is already owned by it. Without a
+ * dictionary (a node not yet in the document), the value is copied.
+ */
+xmlAttrPtr
+newInternedProp(xmlNodePtr node, const char *name, const xmlChar *value) {
+  xmlDocPtr doc = node->doc;
+  if (!doc || !doc->dict || !value) {
+    return xmlNewProp(node, BAD_CAST name, value);
+  }
+  if (!xmlDictOwns(doc->dict, value)) {
+    value = xmlDictLookup(doc->dict, value, -1);
+  }
+  xmlAttrPtr attr = xmlNewProp(node, BAD_CAST name, nullptr);
+  if (!attr) {
+    return nullptr;
+  }
+  xmlNodePtr text = xmlNewDocText(doc, nullptr);
+  if (!text) {
+    return attr;
+  }
+  // xmlFreeNode does not free the content owned by the dictionary
+  text->content = const_cast<xmlChar *>(value);
+  text->parent = reinterpret_cast<xmlNodePtr>(attr);
+  attr->children = attr->last = text;
+  return attr;
+}
+
+xmlAttrPtr
+newIntegerProp(xmlNodePtr node, const char *name, long long value) {
+  char buf[sizeof(long long) * 3 + 2];
+  std::snprintf(buf, sizeof(buf), "%lld", value);
+  return xmlNewProp(node, BAD_CAST name, BAD_CAST buf);
+}
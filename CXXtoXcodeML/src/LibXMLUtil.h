@@ -0,0 +1,11 @@
+#ifndef LIBXMLUTIL_H
+#define LIBXMLUTIL_H
+
+/* Attributes sharing their values with the dictionary of the document */
+const xmlChar *internString(xmlDictPtr, const char *);
+xmlAttrPtr newInternedProp(xmlNodePtr, const char *, const xmlChar *);
+
+/* Attributes formatted without a std::string temporary */
+xmlAttrPtr newIntegerProp(xmlNodePtr, const char *, long long);
+
+#endif /* !LIBXMLUTIL_H */
@@ -1,14 +1,17 @@
 #include <iostream>
 #include <map>
 #include <memory>
-#include <stack>
 #include <string>
+#include <vector>
 #include <libxml/tree.h>
+#include <libxml/dict.h>
 #include "clang/AST/Mangle.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/DeclBase.h"
 #include "clang/AST/DeclCXX.h"
 #include "clang/AST/DeclTemplate.h"
+#include "llvm/Support/CommandLine.h"
+#include "CXXtoXML.h"
 #include "TypeTableInfo.h"
 
 #include "NnsTableInfo.h"
@@ -17,7 +20,8 @@ namespace {
 
 xmlNodePtr getNnsDefElem(const NnsTableInfoImpl &, const std::string &);
 
-void pushNns(NnsTableInfoImpl &, const std::string &);
+void pushNns(
+    NnsTableInfoImpl &, const clang::DeclContext *, const std::string &);
 
 void registerDeclContext(NnsTableInfoImpl &, const clang::DeclContext *DC);
 
@@ -36,7 +40,8 @@ struct NnsTableInfoImpl {
         mapFromNnsIdentToXmlNodePtr(),
         nnsTableStack(),
         seqForOther(0),
-        mapForDC() {
+        mapForDC(),
+        idForDC() {
     assert(typetableinfo);
   }
 
@@ -44,18 +49,21 @@ struct NnsTableInfoImpl {
   TypeTableInfo *typetableinfo;
   std::map<std::string, xmlNodePtr> mapFromNnsIdentToXmlNodePtr;
 
-  /*! stack of node-NNSs pairs.
+  /*! stack of node-NNSs pairs, from the outermost scope.
    *  Each node-NNSs pair consists
    *  - an XML <nnsTable> element (`xmlNodePtr`)
    *  - and a list of NNSs that belong to the NNS-scope
    *    defined by the <nnsTable> element (`std::vector<std::string>`)
    */
-  std::stack<std::tuple<xmlNodePtr, std::vector<std::string>>> nnsTableStack;
+  std::vector<std::tuple<xmlNodePtr, std::vector<std::string>>> nnsTableStack;
 
   /*! counter for others */
   size_t seqForOther;
 
   std::map<const clang::DeclContext *, std::string> mapForDC;
+
+  /*! NNS names interned in the dictionary of the type table */
+  std::map<const clang::DeclContext *, const xmlChar *> idForDC;
 };
 
 NnsTableInfo::NnsTableInfo(clang::MangleContext *MC, TypeTableInfo *TTI)
@@ -88,30 +96,65 @@ NnsTableInfo::getNnsName(const clang::DeclContext *DC) {
   return getOrRegisterNnsName(*pimpl, DC);
 }
 
+/*!
+ * \brief Return the NNS name of \c DC interned in the dictionary of
+ * the type table, to be shared by the attributes referring to it.
+ */
+const xmlChar *
+NnsTableInfo::getNnsId(const clang::DeclContext *DC) {
+  const auto iter = pimpl->idForDC.find(DC);
+  if (iter != pimpl->idForDC.end()) {
+    return iter->second;
+  }
+  const auto name = getOrRegisterNnsName(*pimpl, DC);
+  const auto id = xmlDictLookup(
+      pimpl->typetableinfo->getDictionary(), BAD_CAST name.c_str(), -1);
+  pimpl->idForDC[DC] = id;
+  return id;
+}
+
 namespace {
 
+/*!
+ * \brief Returns true if \c DC can only be named in the scope it is
+ * used in, like the types that isScopeLocalType accepts.
+ */
+bool
+isScopeLocalDeclContext(const clang::DeclContext *DC) {
+  if (const auto RD = llvm::dyn_cast<clang::CXXRecordDecl>(DC)) {
+    return isScopeLocalType(clang::QualType(RD->getTypeForDecl(), 0));
+  }
+  return DC->isDependentContext() || DC->isFunctionOrMethod()
+      || clang::Decl::castFromDeclContext(DC)->getParentFunctionOrMethod();
+}
+
 void
-pushNns(NnsTableInfoImpl &info, const std::string &nns) {
-  std::get<1>(info.nnsTableStack.top()).push_back(nns);
+pushNns(NnsTableInfoImpl &info,
+    const clang::DeclContext *DC,
+    const std::string &nns) {
+  auto &scope = CXXtoXML::hoist_types && !isScopeLocalDeclContext(DC)
+      ? info.nnsTableStack.front()
+      : info.nnsTableStack.back();
+  std::get<1>(scope).push_back(nns);
 }
 
 } // namespace
 
 void
 NnsTableInfo::pushNnsTableStack(xmlNodePtr nnsTableNode) {
-  pimpl->nnsTableStack.push(
+  pimpl->nnsTableStack.push_back(
       std::make_tuple(nnsTableNode, std::vector<std::string>()));
 }
 
 void
 NnsTableInfo::popNnsTableStack() {
   assert(!pimpl->nnsTableStack.empty());
-  const auto nnsTableNode = std::get<0>(pimpl->nnsTableStack.top());
-  const auto nnssInCurScope = std::get<1>(pimpl->nnsTableStack.top());
+  const auto nnsTableNode = std::get<0>(pimpl->nnsTableStack.back());
+  const auto nnssInCurScope = std::get<1>(pimpl->nnsTableStack.back());
   for (auto &nns : nnssInCurScope) {
     xmlAddChild(nnsTableNode, getNnsDefElem(*pimpl, nns));
   }
-  pimpl->nnsTableStack.pop();
+  pimpl->nnsTableStack.pop_back();
 }
 
 namespace {
@@ -199,7 +242,7 @@ registerDeclContext(NnsTableInfoImpl &info, const clang::DeclContext *DC) {
   info.mapForDC[DC] = name;
   info.mapFromNnsIdentToXmlNodePtr[name] = makeNnsDefNodeForDeclContext(
       *(info.mangleContext), info, *info.typetableinfo, DC);
-  pushNns(info, name);
+  pushNns(info, DC, name);
 }
 
 xmlNodePtr
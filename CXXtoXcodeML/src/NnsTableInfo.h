@@ -16,6 +16,7 @@ public:
 
   explicit NnsTableInfo(clang::MangleContext *, TypeTableInfo *);
   std::string getNnsName(const clang::DeclContext *);
+  const xmlChar *getNnsId(const clang::DeclContext *);
   void popNnsTableStack();
   void pushNnsTableStack(xmlNodePtr);
 
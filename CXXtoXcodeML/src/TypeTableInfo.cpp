@@ -1,4 +1,5 @@
 #include <libxml/tree.h>
+#include <libxml/dict.h>
 #include "clang/AST/AST.h"
 #include "clang/Tooling/Tooling.h"
 
@@ -44,12 +45,17 @@ static bool map_is_already_set = false;
 static std::map<std::string, std::string> typenamemap;
 
 // constructor
-TypeTableInfo::TypeTableInfo(
-    MangleContext *MC, InheritanceInfo *II, NnsTableInfo *NTI)
-    : mangleContext(MC), inheritanceinfo(II), nnstableinfo(NTI) {
-  mapFromNameToQualType.clear();
-  mapFromQualTypeToName.clear();
-  mapFromQualTypeToXmlNodePtr.clear();
+TypeTableInfo::TypeTableInfo(MangleContext *MC,
+    InheritanceInfo *II,
+    NnsTableInfo *NTI,
+    xmlDictPtr dict)
+    : mangleContext(MC),
+      inheritanceinfo(II),
+      nnstableinfo(NTI),
+      dict(dict ? dict : xmlDictCreate()) {
+  if (dict) {
+    xmlDictReference(dict);
+  }
   seqForBasicType = 0;
   seqForPointerType = 0;
   seqForFunctionType = 0;
@@ -65,34 +71,37 @@ TypeTableInfo::TypeTableInfo(
   seqForDependentNameType = 0;
   seqForOtherType = 0;
 
-  TypeElements.clear();
   useLabelType = false;
 }
 
+TypeTableInfo::~TypeTableInfo() {
+  xmlDictFree(dict);
+}
+
 std::string
 TypeTableInfo::registerBasicType(QualType T) {
-  std::string name = mapFromQualTypeToName[T];
-  assert(name.empty());
+  assert(!isRegistered(T));
+  std::string name;
 
   raw_string_ostream OS(name);
   OS << "Basic" << seqForBasicType++;
-  return mapFromQualTypeToName[T] = OS.str();
+  return types[T].name = OS.str();
 }
 
 std::string
 TypeTableInfo::registerTemplateSpecializationType(QualType T) {
-  std::string name = mapFromQualTypeToName[T];
-  assert(name.empty());
+  assert(!isRegistered(T));
+  std::string name;
 
   raw_string_ostream OS(name);
   OS << "TemplateSpecialization" << seqForTemplateSpecializationType++;
-  return mapFromQualTypeToName[T] = OS.str();
+  return types[T].name = OS.str();
 }
 
 std::string
 TypeTableInfo::registerPointerType(QualType T) {
-  std::string name = mapFromQualTypeToName[T];
-  assert(name.empty());
+  assert(!isRegistered(T));
+  std::string name;
   using clang::Type;
 
   raw_string_ostream OS(name);
@@ -103,7 +112,7 @@ TypeTableInfo::registerPointerType(QualType T) {
   case Type::RValueReference: OS << "Pointer" << seqForPointerType++; break;
   default: abort();
   }
-  return mapFromQualTypeToName[T] = OS.str();
+  return types[T].name = OS.str();
 }
 
 std::string
@@ -111,19 +120,19 @@ TypeTableInfo::registerFunctionType(QualType T) {
   using clang::Type;
   assert(T->getTypeClass() == Type::FunctionProto
       || T->getTypeClass() == Type::FunctionNoProto);
-  std::string name = mapFromQualTypeToName[T];
-  assert(name.empty());
+  assert(!isRegistered(T));
+  std::string name;
 
   raw_string_ostream OS(name);
   OS << "Function" << seqForFunctionType++;
-  return mapFromQualTypeToName[T] = OS.str();
+  return types[T].name = OS.str();
 }
 
 std::string
 TypeTableInfo::registerArrayType(QualType T) {
-  std::string name = mapFromQualTypeToName[T];
+  assert(!isRegistered(T));
+  std::string name;
   using clang::Type;
-  assert(name.empty());
 
   raw_string_ostream OS(name);
   switch (T->getTypeClass()) {
@@ -137,14 +146,14 @@ TypeTableInfo::registerArrayType(QualType T) {
     break;
   default: abort();
   }
-  return mapFromQualTypeToName[T] = OS.str();
+  return types[T].name = OS.str();
 }
 
 std::string
 TypeTableInfo::registerRecordType(QualType T) {
   assert(T->getTypeClass() == clang::Type::Record);
-  std::string name = mapFromQualTypeToName[T];
-  assert(name.empty());
+  assert(!isRegistered(T));
+  std::string name;
 
   raw_string_ostream OS(name);
   if (T->getAsCXXRecordDecl()) {
@@ -157,70 +166,70 @@ TypeTableInfo::registerRecordType(QualType T) {
   } else {
     abort();
   }
-  return mapFromQualTypeToName[T] = OS.str();
+  return types[T].name = OS.str();
 }
 
 std::string
 TypeTableInfo::registerEnumType(QualType T) {
   assert(T->getTypeClass() == clang::Type::Enum);
-  std::string name = mapFromQualTypeToName[T];
-  assert(name.empty());
+  assert(!isRegistered(T));
+  std::string name;
 
   raw_string_ostream OS(name);
   OS << "Enum" << seqForEnumType++;
-  return mapFromQualTypeToName[T] = OS.str();
+  return types[T].name = OS.str();
 }
 
 std::string
 TypeTableInfo::registerTemplateTypeParmType(QualType T) {
   assert(T->getTypeClass() == clang::Type::TemplateTypeParm);
-  std::string name = mapFromQualTypeToName[T];
-  assert(name.empty());
+  assert(!isRegistered(T));
+  std::string name;
 
   raw_string_ostream OS(name);
   OS << "TemplateTypeParm" << seqForTemplateTypeParmType++;
-  return mapFromQualTypeToName[T] = OS.str();
+  return types[T].name = OS.str();
 }
 
 std::string
 TypeTableInfo::registerInjectedClassNameType(QualType T) {
   assert(T->getTypeClass() == clang::Type::InjectedClassName);
-  std::string name = mapFromQualTypeToName[T];
-  assert(name.empty());
+  assert(!isRegistered(T));
+  std::string name;
 
   raw_string_ostream OS(name);
   OS << "InjectedClassName" << seqForInjectedClassNameType++;
-  return mapFromQualTypeToName[T] = OS.str();
+  return types[T].name = OS.str();
 }
 
 std::string
 TypeTableInfo::registerMemberPointerType(QualType T) {
   assert(T->getTypeClass() == clang::Type::MemberPointer);
-  std::string name = mapFromQualTypeToName[T];
-  assert(name.empty());
+  assert(!isRegistered(T));
+  std::string name;
 
   raw_string_ostream OS(name);
   OS << "MemberPointer" << seqForMemberPointerType++;
-  return mapFromQualTypeToName[T] = OS.str();
+  return types[T].name = OS.str();
 }
 std::string
 TypeTableInfo::registerDependentNameType(QualType T){
   assert(T->getTypeClass() == clang::Type::DependentName);
-  std::string name = mapFromQualTypeToName[T];
-  assert(name.empty());
+  assert(!isRegistered(T));
+  std::string name;
 
   raw_string_ostream OS(name);
   OS << "DependentName" << seqForDependentNameType++;
-  return mapFromQualTypeToName[T] = OS.str();
+  return types[T].name = OS.str();
 }
 std::string
 TypeTableInfo::registerOtherType(QualType T) {
-  std::string name = mapFromQualTypeToName[T];
-  assert(name.empty());
+  assert(!isRegistered(T));
+  std::string name;
 
   raw_string_ostream OS(name);
   OS << "Other" << seqForOtherType++;
-  return mapFromQualTypeToName[T] = OS.str();
+  return types[T].name = OS.str();
 }
 
 xmlNodePtr
@@ -232,8 +241,70 @@ TypeTableInfo::createNode(QualType T, const char *fieldname, xmlNodePtr) {
 
 void
 TypeTableInfo::pushType(const QualType &T, xmlNodePtr node) {
-  std::get<1>(typeTableStack.top()).push_back(T);
-  TypeElements[T] = node;
+  // A hoisted type is never unregistered by popTypeTableStack,
+  // so that later scopes share its definition.
+  auto &scope = CXXtoXML::hoist_types && !isScopeLocalType(T)
+      ? typeTableStack.front()
+      : typeTableStack.back();
+  std::get<1>(scope).push_back(T);
+  types[T].element = node;
+}
+
+bool
+TypeTableInfo::isRegistered(QualType T) const {
+  const auto iter = types.find(T);
+  return iter != types.end() && !iter->second.name.empty();
+}
+
+bool
+isScopeLocalType(QualType T) {
+  if (T.isNull()) {
+    return false;
+  }
+  if (T->isDependentType() || T->isVariablyModifiedType()) {
+    return true;
+  }
+  const auto CT = T.getCanonicalType().getTypePtr();
+  if (const auto PT = dyn_cast<clang::PointerType>(CT)) {
+    return isScopeLocalType(PT->getPointeeType());
+  }
+  if (const auto RT = dyn_cast<ReferenceType>(CT)) {
+    return isScopeLocalType(RT->getPointeeType());
+  }
+  if (const auto MPT = dyn_cast<MemberPointerType>(CT)) {
+    return isScopeLocalType(MPT->getPointeeType())
+        || isScopeLocalType(QualType(MPT->getClass(), 0));
+  }
+  if (const auto AT = dyn_cast<clang::ArrayType>(CT)) {
+    return isScopeLocalType(AT->getElementType());
+  }
+  if (const auto FT = dyn_cast<FunctionType>(CT)) {
+    if (isScopeLocalType(FT->getReturnType())) {
+      return true;
+    }
+    if (const auto FPT = dyn_cast<FunctionProtoType>(FT)) {
+      for (auto paramT : FPT->param_types()) {
+        if (isScopeLocalType(paramT)) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+  if (const auto TD = CT->getAsTagDecl()) {
+    if (TD->getParentFunctionOrMethod()) {
+      return true;
+    }
+    if (const auto CTSD = dyn_cast<ClassTemplateSpecializationDecl>(TD)) {
+      for (const auto &arg : CTSD->getTemplateArgs().asArray()) {
+        if (arg.getKind() == TemplateArgument::Type
+            && isScopeLocalType(arg.getAsType())) {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
 }
 
 static const char *
@@ -419,13 +490,18 @@ TypeTableInfo::registerType(QualType T, xmlNodePtr *retNode, xmlNodePtr) {
 
   if (!T.isCanonical()) {
     registerType(T.getCanonicalType(), retNode, nullptr);
-    mapFromQualTypeToName[T] = mapFromQualTypeToName[T.getCanonicalType()];
+    // look up before inserting, which may move the records
+    auto name = types.lookup(T.getCanonicalType()).name;
+    auto &record = types[T];
+    record.name = std::move(name);
+    record.id = nullptr;
     return;
   }
 
-  if (mapFromQualTypeToName.find(T) != mapFromQualTypeToName.end()) {
+  const auto iter = types.find(T);
+  if (iter != types.end() && !iter->second.name.empty()) {
     if (retNode != nullptr) {
-      *retNode = mapFromQualTypeToXmlNodePtr[T];
+      *retNode = iter->second.node;
     }
     return;
   }
@@ -476,7 +552,7 @@ TypeTableInfo::registerType(QualType T, xmlNodePtr *retNode, xmlNodePtr) {
           *I = '_';
         }
       }
-      mapFromQualTypeToName[T] = rawname;
+      types[T].name = rawname;
       break;
     }
 
@@ -575,7 +651,7 @@ TypeTableInfo::registerType(QualType T, xmlNodePtr *retNode, xmlNodePtr) {
       const auto *FT = dyn_cast<const clang::FunctionType>(T.getTypePtr());
       if (FT) {
         registerType(FT->getReturnType(), nullptr, nullptr);
-        if(mapFromQualTypeToName.find(T) != mapFromQualTypeToName.end())
+        if (isRegistered(T))
             break;
       }
       rawname = registerFunctionType(T);
@@ -950,7 +1026,7 @@ TypeTableInfo::registerType(QualType T, xmlNodePtr *retNode, xmlNodePtr) {
     *retNode = Node;
   }
   mapFromNameToQualType[rawname] = T;
-  mapFromQualTypeToXmlNodePtr[T] = Node;
+  types[T].node = Node;
 }
 
 void
@@ -964,13 +1040,13 @@ TypeTableInfo::getTypeName(QualType T) {
     return "nullType";
   };
 
-  const auto iter = mapFromQualTypeToName.find(T);
+  const auto iter = types.find(T);
   std::string name;
-  if (iter != mapFromQualTypeToName.end()) {
-    name = iter->second;
+  if (iter != types.end() && !iter->second.name.empty()) {
+    name = iter->second.name;
   } else {
     registerType(T, nullptr, nullptr);
-    name = mapFromQualTypeToName[T];
+    name = types[T].name;
   }
 
   if (!map_is_already_set) {
@@ -1009,6 +1085,30 @@ TypeTableInfo::getTypeName(QualType T) {
   return name;
 }
 
+/*!
+ * \brief Return the name of \c T interned in the dictionary, which the
+ * attributes referring to \c T can share instead of copying it.
+ */
+const xmlChar *
+TypeTableInfo::getTypeId(QualType T) {
+  if (T.isNull()) {
+    return xmlDictLookup(dict, BAD_CAST "nullType", -1);
+  }
+  const auto iter = types.find(T);
+  if (iter != types.end() && iter->second.id && !iter->second.name.empty()) {
+    return iter->second.id;
+  }
+  const auto name = getTypeName(T);
+  const auto id = xmlDictLookup(dict, BAD_CAST name.c_str(), -1);
+  types[T].id = id;
+  return id;
+}
+
+xmlDictPtr
+TypeTableInfo::getDictionary() const {
+  return dict;
+}
+
 std::string
 TypeTableInfo::getTypeNameForLabel(void) {
   if (!typenamemap["Label"].empty()) {
@@ -1035,47 +1135,51 @@ TypeTableInfo::hasBaseClass(clang::QualType type) {
 
 void
 TypeTableInfo::setNormalizability(clang::QualType T, bool b) {
-  normalizability[T] = b;
+  types[T].normalizability = b;
 }
 
 bool TypeTableInfo::isNormalizable(clang::QualType) {
-  // return normalizability[T];
+  // return types.lookup(T).normalizability;
   return false;
 }
 
 void
 TypeTableInfo::pushTypeTableStack(xmlNodePtr typeTableNode) {
-  typeTableStack.push(std::make_tuple(typeTableNode, std::vector<QualType>()));
+  typeTableStack.push_back(
+      std::make_tuple(typeTableNode, std::vector<QualType>()));
 }
 
 void
 TypeTableInfo::popTypeTableStack() {
   assert(!typeTableStack.empty());
-  const auto typeTableNode = std::get<0>(typeTableStack.top());
-  const auto latestTypes = std::get<1>(typeTableStack.top());
+  const auto typeTableNode = std::get<0>(typeTableStack.back());
+  const auto latestTypes = std::get<1>(typeTableStack.back());
   for (auto T : latestTypes) {
-    if (TypeElements.find(T) != TypeElements.end()) {
+    const auto iter = types.find(T);
+    assert(iter != types.end());
+    auto &record = iter->second;
+    if (record.element) {
       /*
        * If data type definition element exists,
        * add it to current typeTable.
        * Fundamental types do not have data type definition elements.
        * (Example: `int`)
        */
-      xmlAddChild(typeTableNode, TypeElements[T]);
-      TypeElements.erase(T);
+      xmlAddChild(typeTableNode, record.element);
+      record.element = nullptr;
     }
-    const auto name = mapFromQualTypeToName.at(T);
-    mapFromNameToQualType.erase(name);
-    mapFromQualTypeToName.erase(T);
+    mapFromNameToQualType.erase(record.name);
+    record.name.clear();
+    record.id = nullptr;
   }
-  typeTableStack.pop();
+  typeTableStack.pop_back();
 }
 
 void
 TypeTableInfo::dump() {
-  for (auto &pair : mapFromNameToQualType) {
-    auto name = pair.first;
-    auto type = pair.second;
+  for (auto &entry : mapFromNameToQualType) {
+    auto name = entry.getKey().str();
+    auto type = entry.getValue();
     std::cerr << name << ": " << type.getAsString() << std::endl;
   }
 }
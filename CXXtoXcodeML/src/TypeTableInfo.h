@@ -1,13 +1,14 @@
 #ifndef TYPETABLEVISITOR_H
 #define TYPETABLEVISITOR_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "clang/AST/Mangle.h"
 
 #include "InheritanceInfo.h"
-#include <stack>
 #include <tuple>
-#include <unordered_map>
+#include <vector>
 
 class NnsTableInfo;
 
@@ -15,11 +16,23 @@ class TypeTableInfo {
   clang::MangleContext *mangleContext;
   InheritanceInfo *inheritanceinfo;
   NnsTableInfo *nnstableinfo;
-  std::unordered_map<std::string, clang::QualType> mapFromNameToQualType;
-  std::unordered_map<clang::QualType, std::string> mapFromQualTypeToName;
-  std::unordered_map<clang::QualType, xmlNodePtr> mapFromQualTypeToXmlNodePtr;
-  std::unordered_map<clang::QualType, bool> normalizability;
-  std::stack<std::tuple<xmlNodePtr, std::vector<clang::QualType>>>
+  xmlDictPtr dict;
+  /*! \brief Everything registered about a type, looked up at once. */
+  struct TypeRecord {
+    // empty unless the type is registered in the current scope
+    std::string name;
+    // name interned in dict, once it has been asked for
+    const xmlChar *id = nullptr;
+    xmlNodePtr node = nullptr;
+    // the data type definition element not yet added to a typeTable
+    xmlNodePtr element = nullptr;
+    bool normalizability = false;
+  };
+  llvm::DenseMap<clang::QualType, TypeRecord> types;
+  llvm::StringMap<clang::QualType> mapFromNameToQualType;
+  /*! typeTable elements from the outermost to the innermost scope,
+   *  each with the types to be defined in it */
+  std::vector<std::tuple<xmlNodePtr, std::vector<clang::QualType>>>
       typeTableStack;
 
   int seqForBasicType;
@@ -37,8 +50,6 @@ class TypeTableInfo {
   int seqForTemplateSpecializationType;
   int seqForOtherType;
 
-  std::unordered_map<clang::QualType, xmlNodePtr> TypeElements;
-
   bool useLabelType;
 
   xmlNodePtr createNode(
@@ -56,6 +67,7 @@ class TypeTableInfo {
   std::string registerTemplateSpecializationType(clang::QualType T);
   std::string registerOtherType(clang::QualType T); // "O*"
   void pushType(const clang::QualType &, xmlNodePtr);
+  bool isRegistered(clang::QualType) const;
 
 public:
   TypeTableInfo() = delete;
@@ -66,12 +78,16 @@ public:
 
   explicit TypeTableInfo(clang::MangleContext *MC,
       InheritanceInfo *II,
-      NnsTableInfo *NTI); // default constructor
+      NnsTableInfo *NTI,
+      xmlDictPtr dict = nullptr); // default constructor
+  ~TypeTableInfo();
 
   void registerType(
       clang::QualType T, xmlNodePtr *retNode, xmlNodePtr traversingNode);
   void registerLabelType(void);
   std::string getTypeName(clang::QualType T);
+  const xmlChar *getTypeId(clang::QualType T);
+  xmlDictPtr getDictionary() const;
   std::string getTypeNameForLabel(void);
   std::vector<BaseClass> getBaseClasses(clang::QualType type);
   void addInheritance(clang::QualType derived, BaseClass base);
@@ -83,6 +99,14 @@ public:
   void dump();
 };
 
+/*!
+ * \brief Returns true if \c T can only be named in the scope it is
+ * used in: a dependent or variably modified type, or a type built from
+ * a local class. With --hoist-types, every other type is defined in
+ * the outermost typeTable.
+ */
+bool isScopeLocalType(clang::QualType T);
+
 #endif /* !TYPETABLEVISITOR_H */
 
 ///
@@ -2,6 +2,7 @@
 #include "clang/Tooling/Tooling.h"
 #include "clang/Driver/Options.h"
 #include "clang/Lex/Lexer.h"
+#include <cstring>
 #include <sstream>
 #include <string>
 #include <type_traits>
@@ -9,11 +10,64 @@
 #include <iostream>
 
 #include "CXXtoXML.h"
+#include "LibXMLUtil.h"
 #include "XMLRecursiveASTVisitor.h"
 
 using namespace clang;
 using namespace llvm;
 
+static cl::opt<unsigned, true> OptLiteralListThreshold(
+    "pack-literal-lists",
+    cl::desc("emit initializer lists of at least N integer or floating"
+             " literals as one <xcodemlLiteralList> (default: 0, never)"),
+    cl::value_desc("N"),
+    cl::location(CXXtoXML::literal_list_threshold),
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<std::string, true> OptIndexFile(
+    "index",
+    cl::desc("write an index of the declarations in the output to <file>"),
+    cl::value_desc("file"),
+    cl::location(CXXtoXML::index_file),
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<std::string, true> OptTraceFile(
+    "trace-out",
+    cl::desc("write the time spent on each declaration to <file>"
+             " in the Chrome trace-event format"),
+    cl::value_desc("file"),
+    cl::location(CXXtoXML::trace_file),
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<unsigned, true> OptTraceThreshold(
+    "trace-threshold",
+    cl::desc("omit the trace events shorter than <us> microseconds"
+             " (default: 100)"),
+    cl::value_desc("us"),
+    cl::location(CXXtoXML::trace_threshold),
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<bool, true> OptHoistTypes(
+    "hoist-types",
+    cl::desc("define the types that do not depend on a template scope"
+             " once, in the outermost type and NNS tables"),
+    cl::location(CXXtoXML::hoist_types),
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<bool, true> OptDeclarationsOnly(
+    "declarations-only",
+    cl::desc("skip function bodies and emit only the declarations,"
+             " types and NNS tables"),
+    cl::location(CXXtoXML::declarations_only),
+    cl::cat(CXX2XMLCategory));
+
+static cl::opt<bool, true> OptIterativeStmtTraversal(
+    "iterative-stmt-traversal",
+    cl::desc("traverse statements and expressions with an explicit stack"
+             " (default: true)"),
+    cl::location(CXXtoXML::iterative_stmt_traversal),
+    cl::cat(CXX2XMLCategory));
+
 namespace {
 
 std::string
@@ -25,6 +79,64 @@ getSpelling(clang::Expr *E, const clang::ASTContext &CXT) {
   return spelling.str();
 }
 
+std::string
+getIntegerLiteralSpelling(
+    const clang::IntegerLiteral *IL, const clang::ASTContext &CXT) {
+  const unsigned INIT_BUFFER_SIZE = 32;
+  SmallVector<char, INIT_BUFFER_SIZE> buffer;
+  const auto &SM = CXT.getSourceManager();
+  const auto location = SM.getSpellingLoc(IL->getLocation());
+  return clang::Lexer::getSpelling(location, buffer, SM, CXT.getLangOpts())
+      .str();
+}
+
+std::string
+getFloatingLiteralSpelling(
+    const clang::FloatingLiteral *FL, const clang::ASTContext &CXT) {
+  const unsigned INIT_BUFFER_SIZE = 32;
+  SmallVector<char, INIT_BUFFER_SIZE> buffer;
+  return clang::Lexer::getSpelling(FL->getLocation(),
+      buffer,
+      CXT.getSourceManager(),
+      CXT.getLangOpts())
+      .str();
+}
+
+/*!
+ * \brief Spell an element of a packable initializer list: an integer
+ * or floating literal, possibly negated and implicitly converted.
+ * \return false if \c E is anything else.
+ */
+bool
+spellPackableLiteral(const clang::Expr *E,
+    const clang::ASTContext &CXT,
+    const char *&className,
+    std::string &token) {
+  E = E->IgnoreImpCasts();
+  std::string sign;
+  if (const auto UO = dyn_cast<clang::UnaryOperator>(E)) {
+    if (UO->getOpcode() != UO_Minus) {
+      return false;
+    }
+    sign = "-";
+    E = UO->getSubExpr()->IgnoreImpCasts();
+  }
+  if (const auto IL = dyn_cast<clang::IntegerLiteral>(E)) {
+    className = "IntegerLiteral";
+    token = getIntegerLiteralSpelling(IL, CXT);
+    if (token.empty()) {
+      token = IL->getValue().toString(10, true);
+    }
+  } else if (const auto FL = dyn_cast<clang::FloatingLiteral>(E)) {
+    className = "FloatingLiteral";
+    token = getFloatingLiteralSpelling(FL, CXT);
+  } else {
+    return false;
+  }
+  token = sign + token;
+  return true;
+}
+
 std::string
 unsignedToHexString(unsigned u) {
   std::stringstream ss;
@@ -47,7 +159,7 @@ XMLRecursiveASTVisitor::VisitStmt(Stmt *S) {
   }
 #endif
   newChild("clangStmt");
-  newProp("class", S->getStmtClassName());
+  newInternedProp("class", S->getStmtClassName());
   setLocation(S->getBeginLoc());
 
   const BinaryOperator *BO = dyn_cast<const BinaryOperator>(S);
@@ -76,7 +188,7 @@ XMLRecursiveASTVisitor::VisitStmt(Stmt *S) {
     newProp("valueCategory",
         E->isXValue() ? "xvalue" : E->isRValue() ? "prvalue" : "lvalue");
     auto T = E->getType();
-    newProp("xcodemlType", typetableinfo.getTypeName(T).c_str());
+    newInternedProp("xcodemlType", typetableinfo.getTypeId(T));
   }
 
   if (auto CE = dyn_cast<clang::CastExpr>(S)) {
@@ -129,11 +241,9 @@ XMLRecursiveASTVisitor::VisitStmt(Stmt *S) {
     auto nameNode = makeNameNode(typetableinfo, DRE);
     const auto parent = DRE->getFoundDecl()->getDeclContext();
     assert(parent);
-    xmlNewProp(nameNode,
-        BAD_CAST "nns",
-        BAD_CAST(nnstableinfo.getNnsName(parent).c_str()));
-
+    // add it first, so that its attributes can be interned
     xmlAddChild(curNode, nameNode);
+    newInternedProp("nns", nnstableinfo.getNnsId(parent), nameNode);
   }
   if (auto LE = dyn_cast<LambdaExpr>(S)){
       for(const auto & cap: LE->captures()){
@@ -151,25 +261,15 @@ XMLRecursiveASTVisitor::VisitStmt(Stmt *S) {
   }
 
   if (auto IL = dyn_cast<IntegerLiteral>(S)) {
-    const unsigned INIT_BUFFER_SIZE = 32;
-    SmallVector<char, INIT_BUFFER_SIZE> buffer;
     const auto &CXT = mangleContext->getASTContext();
-    const auto &SM = CXT.getSourceManager();
-    const auto location = SM.getSpellingLoc(IL->getLocation());
-    const auto spelling =
-        clang::Lexer::getSpelling(location, buffer, SM, CXT.getLangOpts());
-    newProp("token", spelling.str().c_str());
+    newProp("token", getIntegerLiteralSpelling(IL, CXT).c_str());
     std::string decimalNotation = IL->getValue().toString(10, true);
     newProp("decimalNotation", decimalNotation.c_str());
   }
 
   if (auto FL = dyn_cast<FloatingLiteral>(S)) {
-    const unsigned INIT_BUFFER_SIZE = 32;
-    SmallVector<char, INIT_BUFFER_SIZE> buffer;
-    auto &CXT = mangleContext->getASTContext();
-    auto spelling = clang::Lexer::getSpelling(
-        FL->getLocation(), buffer, CXT.getSourceManager(), CXT.getLangOpts());
-    newProp("token", spelling.str().c_str());
+    const auto &CXT = mangleContext->getASTContext();
+    newProp("token", getFloatingLiteralSpelling(FL, CXT).c_str());
   }
   if (auto SL = dyn_cast<clang::StringLiteral>(S)) {
     StringRef Data = SL->getString();
@@ -227,7 +327,7 @@ XMLRecursiveASTVisitor::VisitType(QualType T) {
     return true;
   }
   if (!xmlHasProp(curNode, BAD_CAST "type")) {
-    newProp("type", typetableinfo.getTypeName(T).c_str());
+    newInternedProp("type", typetableinfo.getTypeId(T));
   }
 
   
@@ -238,9 +338,9 @@ XMLRecursiveASTVisitor::VisitType(QualType T) {
 bool
 XMLRecursiveASTVisitor::VisitTypeLoc(TypeLoc TL) {
   newChild("clangTypeLoc");
-  newProp("class", NameForTypeLoc(TL));
+  newInternedProp("class", NameForTypeLoc(TL));
   const auto T = TL.getType();
-  newProp("type", typetableinfo.getTypeName(T).c_str());
+  newInternedProp("type", typetableinfo.getTypeId(T));
   return true;
 }
 
@@ -291,8 +391,11 @@ XMLRecursiveASTVisitor::PreVisitDecl(Decl *D) {
 
   // default: use the AST name simply.
   newChild("clangDecl");
-  newProp("class", D->getDeclKindName());
+  newInternedProp("class", D->getDeclKindName());
   setLocation(D->getLocation());
+  if (index) {
+    index->addDecl(curNode, D, *mangleContext);
+  }
 
   auto &CXT = mangleContext->getASTContext();
   auto &SM = CXT.getSourceManager();
@@ -333,14 +436,11 @@ XMLRecursiveASTVisitor::PreVisitDecl(Decl *D) {
     /* experimental */
     const auto parent = ND->getDeclContext();
     assert(parent);
-    xmlNewProp(nameNode,
-        BAD_CAST "test_nns_decl_kind",
-        BAD_CAST(parent->getDeclKindName()));
-    xmlNewProp(nameNode,
-        BAD_CAST "nns",
-        BAD_CAST(nnstableinfo.getNnsName(parent).c_str()));
-
+    // add it first, so that its attributes can be interned
     xmlAddChild(curNode, nameNode);
+    newInternedProp(
+        "test_nns_decl_kind", parent->getDeclKindName(), nameNode);
+    newInternedProp("nns", nnstableinfo.getNnsId(parent), nameNode);
   }
 
   if (auto UD = dyn_cast<UsingDecl>(D)) {
@@ -349,18 +449,17 @@ XMLRecursiveASTVisitor::PreVisitDecl(Decl *D) {
 
   if (auto VD = dyn_cast<ValueDecl>(D)) {
     const auto T = VD->getType();
-    newProp("xcodemlType", typetableinfo.getTypeName(T).c_str());
+    newInternedProp("xcodemlType", typetableinfo.getTypeId(T));
   }
 
   if (auto TD = dyn_cast<TypeDecl>(D)) {
     const auto T = QualType(TD->getTypeForDecl(), 0);
-    newProp("xcodemlType", typetableinfo.getTypeName(T).c_str());
+    newInternedProp("xcodemlType", typetableinfo.getTypeId(T));
   }
 
   if (auto TND = dyn_cast<TypedefNameDecl>(D)) {
     const auto T = TND->getUnderlyingType();
-    newProp("xcodemlTypedefType",
-	    typetableinfo.getTypeName(T).c_str());
+    newInternedProp("xcodemlTypedefType", typetableinfo.getTypeId(T));
   }
 
   if (const auto RD = dyn_cast<RecordDecl>(D)) {
@@ -406,10 +505,15 @@ XMLRecursiveASTVisitor::PreVisitDecl(Decl *D) {
     }
     newBoolProp("is_function_template_specialization",
         FD->isFunctionTemplateSpecialization());
+    newBoolProp("is_inline", FD->isInlineSpecified() || FD->isConstexpr());
     newBoolProp("is_defaulted", FD->isDefaulted());
     newBoolProp("is_deleted", FD->isDeletedAsWritten());
     newBoolProp("is_pure", FD->isPure());
     newBoolProp("is_variadic", FD->isVariadic());
+    newBoolProp("is_out_of_line", FD->isOutOfLine());
+    if (FD->hasSkippedBody()) {
+      newBoolProp("has_skipped_body", true);
+    }
   }
 
   if (auto MD = dyn_cast<CXXMethodDecl>(D)) {
@@ -419,8 +523,7 @@ XMLRecursiveASTVisitor::PreVisitDecl(Decl *D) {
     if (auto RD = MD->getParent()) {
       assert(mangleContext);
       const auto T = mangleContext->getASTContext().getRecordType(RD);
-      newProp(
-          "parent_class", typetableinfo.getTypeName(T).c_str());
+      newInternedProp("parent_class", typetableinfo.getTypeId(T));
     } else {
       newBoolProp("clang_parent_class_not_found", true);
     }
@@ -455,14 +558,13 @@ XMLRecursiveASTVisitor::VisitDeclarationNameInfo(DeclarationNameInfo NI) {
 
   const auto name = NI.getAsString();
   newChild("clangDeclarationNameInfo", name.c_str());
-  newProp("class", NameForDeclarationName(DN));
+  newInternedProp("class", NameForDeclarationName(DN));
   newBoolProp("is_empty", DN.isEmpty());
 
   // FIXME: not MECE
   const auto T = DN.getCXXNameType();
   if (!T.isNull()) {
-    newProp(
-        "clang_name_type", typetableinfo.getTypeName(T).c_str());
+    newInternedProp("clang_name_type", typetableinfo.getTypeId(T));
   }
   return true;
 }
@@ -522,8 +624,7 @@ XMLRecursiveASTVisitor::TraverseNestedNameSpecifierLoc(NestedNameSpecifierLoc N)
   case NestedNameSpecifier::TypeSpec: {
     const auto T = Spec->getAsType();
     assert(T);
-    const auto dtident = typetableinfo.getTypeName(QualType(T, 0));
-    newProp("xcodemlType", dtident.c_str());
+    newInternedProp("xcodemlType", typetableinfo.getTypeId(QualType(T, 0)));
     TraverseTypeLoc(N.getTypeLoc());
     break;
   }
@@ -547,13 +648,59 @@ XMLRecursiveASTVisitor::VisitConstructorInitializer(CXXCtorInitializer *CI) {
     newProp("member", member->getNameAsString().c_str());
   } else if (auto base = CI->getBaseClass()) {
     const auto T = QualType(base, 0);
-    newProp("xcodemlType", typetableinfo.getTypeName(T).c_str());
+    newInternedProp("xcodemlType", typetableinfo.getTypeId(T));
   } else {
     newBoolProp("clang_unknown_ctor_init", true);
   }
   return true;
 }
 
+/*!
+ * \brief Emit the elements of \c ILE as one <xcodemlLiteralList> if
+ * there are at least CXXtoXML::literal_list_threshold of them and they
+ * are literals of the same class and type.
+ *
+ * The values are separated by spaces in the content of the element:
+ * <xcodemlLiteralList class="IntegerLiteral" type="int" count="3">
+ *   1 -2 0x3</xcodemlLiteralList>
+ * \return true if the list was packed.
+ */
+bool
+XMLRecursiveASTVisitor::newLiteralList(InitListExpr *ILE) {
+  const auto count = ILE->getNumInits();
+  if (CXXtoXML::literal_list_threshold == 0
+      || count < CXXtoXML::literal_list_threshold) {
+    return false;
+  }
+  const auto &CXT = mangleContext->getASTContext();
+  const char *listClass = nullptr;
+  QualType listType;
+  std::string values;
+  for (const auto init : ILE->inits()) {
+    const char *className;
+    std::string token;
+    if (!init || !spellPackableLiteral(init, CXT, className, token)) {
+      return false;
+    }
+    if (!listClass) {
+      listClass = className;
+      listType = init->getType();
+    } else if (std::strcmp(listClass, className) != 0
+        || init->getType() != listType) {
+      return false;
+    }
+    if (!values.empty()) {
+      values += ' ';
+    }
+    values += token;
+  }
+  newChild("xcodemlLiteralList", values.c_str());
+  newInternedProp("class", listClass);
+  newInternedProp("type", typetableinfo.getTypeId(listType));
+  newProp("count", static_cast<int>(count));
+  return true;
+}
+
 //
 // Functions for XML
 //
@@ -573,8 +720,7 @@ void
 XMLRecursiveASTVisitor::newProp(const char *Name, int Val, xmlNodePtr N) {
   if (!N)
     N = curNode;
-  const auto buf = std::to_string(Val);
-  xmlNewProp(N, BAD_CAST Name, BAD_CAST(buf.c_str()));
+  newIntegerProp(N, Name, Val);
 }
 
 void
@@ -584,10 +730,29 @@ XMLRecursiveASTVisitor::newProp(const char *Name, const char *Val, xmlNodePtr N)
   xmlNewProp(N, BAD_CAST Name, BAD_CAST Val);
 }
 
+/*!
+ * \brief Add an attribute whose value is repeated all over the output
+ * (a type or NNS name, a class name, a file name or a flag), sharing it
+ * with the dictionary of the document.
+ */
+void
+XMLRecursiveASTVisitor::newInternedProp(
+    const char *Name, const xmlChar *Val, xmlNodePtr N) {
+  if (!N)
+    N = curNode;
+  ::newInternedProp(N, Name, Val);
+}
+
+void
+XMLRecursiveASTVisitor::newInternedProp(
+    const char *Name, const char *Val, xmlNodePtr N) {
+  newInternedProp(Name, BAD_CAST Val, N);
+}
+
 void
 XMLRecursiveASTVisitor::newBoolProp(const char *Name, bool Val, xmlNodePtr N) {
   if (Val)
-    newProp(Name, "1", N);
+    newInternedProp(Name, "1", N);
 }
 
 void
@@ -635,9 +800,9 @@ XMLRecursiveASTVisitor::setLocation(SourceLocation Loc, xmlNodePtr N) {
         cwdlen = strlen(cwd);
       }
       if (strncmp(filename, cwd, cwdlen) == 0 && filename[cwdlen] == '/') {
-        newProp("file", filename + cwdlen + 1, N);
+        newInternedProp("file", filename + cwdlen + 1, N);
       } else {
-        newProp("file", filename, N);
+        newInternedProp("file", filename, N);
       }
     }
   }
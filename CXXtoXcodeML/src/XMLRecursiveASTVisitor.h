@@ -10,8 +10,12 @@
 #include "clang/AST/Mangle.h"
 
 #include <libxml/tree.h>
+#include <cstdio>
 #include <functional>
+#include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "CXXtoXML.h"
 #include "NnsTableInfo.h"
@@ -19,6 +23,8 @@
 
 #include "InheritanceInfo.h"
 #include "XcodeMlNameElem.h"
+#include "XcodeMlIndex.h"
+#include "TraceEvent.h"
 
 #include "clang/Basic/Builtins.h"
 #include "clang/Lex/Lexer.h"
@@ -35,15 +41,20 @@ class ExtendedRecursiveASTVisitor : public RecursiveASTVisitor<Derived> {
   using BASE = RecursiveASTVisitor<Derived>;
 protected:
   xmlNodePtr curNode; // a candidate of the new chlid.
+  /*!
+   * \brief The values of curNode saved at the beginning of the Stmt
+   * subtrees being traversed.
+   */
+  std::vector<xmlNodePtr> savedStmtCurNodes;
 public:
   /// \brief Return a reference to the derived class.
   Derived &getDerived() { return *static_cast<Derived *>(this); }
 
-  bool shouldUseDataRecursionFor(Stmt *S) const { return false; }
   bool shouldVisitTemplateInstantiations() const {return false;}
 #define DISPATCHER(NAME, TYPE)					\
 public:                                                         \
   bool Traverse##NAME(TYPE S) {                                 \
+    TraceEvent::Scope trace("Traverse", #NAME);                 \
     xmlNodePtr save = curNode; \
     if(CXXtoXML::debug_flag) printf("*** push curNode=%p\n",(void *)curNode); \
     bool ret = RecursiveASTVisitor<Derived>::Traverse##NAME(S); \
@@ -57,7 +68,50 @@ public:                                                         \
     return true;                                                \
   }
 
-  DISPATCHER(Stmt, clang::Stmt *);
+  /*!
+   * \brief Traverse a Stmt subtree.
+   *
+   * In the iterative mode (CXXtoXML::iterative_stmt_traversal), the
+   * child statements are pushed to the explicit stack of
+   * RecursiveASTVisitor instead of being traversed recursively, so that
+   * deeply nested expressions like `a+b+c+...` do not overflow the
+   * native stack.  curNode is saved and restored in
+   * dataTraverseStmtPre/dataTraverseStmtPost in both modes, so both
+   * modes emit the same XML.
+   */
+  bool TraverseStmt(
+      Stmt *S, typename BASE::DataRecursionQueue *Queue = nullptr) {
+    if (Queue && CXXtoXML::iterative_stmt_traversal) {
+      return BASE::TraverseStmt(S, Queue);
+    }
+    return BASE::TraverseStmt(S, nullptr);
+  }
+  bool dataTraverseStmtPre(Stmt *S) {
+    savedStmtCurNodes.push_back(curNode);
+    if(CXXtoXML::debug_flag) printf("*** push curNode=%p\n",(void *)curNode);
+    return true;
+  }
+  bool dataTraverseStmtPost(Stmt *S) {
+    bool ret = getDerived().PostVisitStmt(S);
+    curNode = savedStmtCurNodes.back();
+    savedStmtCurNodes.pop_back();
+    if(CXXtoXML::debug_flag) printf("*** pop curNode=%p\n",(void *)curNode);
+    return ret;
+  }
+  bool PostVisitStmt(Stmt *S) {
+    (void) S;
+    return true;
+  }
+  /*!
+   * \brief Traverse a GenericSelectionExpr without the explicit stack.
+   *
+   * RecursiveASTVisitor interleaves the association types and the
+   * association expressions; enqueuing the latter would change the
+   * order of the XML elements.
+   */
+  bool TraverseGenericSelectionExpr(GenericSelectionExpr *S) {
+    return BASE::TraverseGenericSelectionExpr(S, nullptr);
+  }
   DISPATCHER(TypeLoc, clang::TypeLoc);
   DISPATCHER(Attr, clang::Attr *);
     // DISPATCHER(Decl, clang::Decl *);
@@ -66,6 +120,10 @@ public:                                                         \
     return true;
   }
   bool TraverseDecl(clang::Decl *S) {
+    TraceEvent::Scope trace("Decl", S ? S->getDeclKindName() : "NULL");
+    if (trace.isActive() && S) {
+      describeDecl(trace, S);
+    }
         xmlNodePtr save = curNode;
     if(CXXtoXML::debug_flag) printf("*** push curNode=%p\n",(void *)curNode);
     getDerived().PreVisitDecl(S);
@@ -79,6 +137,19 @@ public:                                                         \
     (void) S;
     return true;
   }
+  /*!
+   * \brief Show the name of \c D and where it is declared with its
+   * trace event.
+   */
+  void describeDecl(TraceEvent::Scope &trace, clang::Decl *D) {
+    std::string detail;
+    llvm::raw_string_ostream OS(detail);
+    if (const auto ND = dyn_cast<NamedDecl>(D)) {
+      OS << ND->getQualifiedNameAsString() << " ";
+    }
+    D->getLocation().print(OS, D->getASTContext().getSourceManager());
+    trace.setDetail(OS.str());
+  }
   DISPATCHER(NestedNameSpecifier, clang::NestedNameSpecifier *);
     //  DISPATCHER(NestedNameSpecifierLoc, clang::NestedNameSpecifierLoc);
     //DISPATCHER(DeclarationNameInfo, clang::DeclarationNameInfo);
@@ -169,6 +240,7 @@ class XMLRecursiveASTVisitor : public ExtendedRecursiveASTVisitor<XMLRecursiveAS
   clang::MangleContext *mangleContext;
   TypeTableInfo typetableinfo;
   NnsTableInfo nnstableinfo;
+  XcodeMlIndex *index;
 
  public:
     // constructor
@@ -177,8 +249,10 @@ class XMLRecursiveASTVisitor : public ExtendedRecursiveASTVisitor<XMLRecursiveAS
 				  const char *ChildName,
 				  InheritanceInfo *II)
     : mangleContext(MC),
-      typetableinfo(MC, II, &nnstableinfo),
-      nnstableinfo(MC, &typetableinfo) {
+      typetableinfo(
+          MC, II, &nnstableinfo, Parent->doc ? Parent->doc->dict : nullptr),
+      nnstableinfo(MC, &typetableinfo),
+      index(nullptr) {
       curNode = ChildName ? xmlNewTextChild(Parent, nullptr, BAD_CAST ChildName, nullptr)
       : Parent;
   }
@@ -188,6 +262,10 @@ class XMLRecursiveASTVisitor : public ExtendedRecursiveASTVisitor<XMLRecursiveAS
   void newChild(const char *Name, const char *Content = nullptr);
   void newProp(const char *Name, int Val, xmlNodePtr N = nullptr);
   void newProp(const char *Name, const char *Val, xmlNodePtr N = nullptr);
+  void newInternedProp(
+      const char *Name, const xmlChar *Val, xmlNodePtr N = nullptr);
+  void newInternedProp(
+      const char *Name, const char *Val, xmlNodePtr N = nullptr);
   void newBoolProp(const char *Name, bool Val, xmlNodePtr N = nullptr);
   void newComment(const xmlChar *str, xmlNodePtr RN = nullptr);
   void newComment(const char *str, xmlNodePtr RN = nullptr);
@@ -195,6 +273,8 @@ class XMLRecursiveASTVisitor : public ExtendedRecursiveASTVisitor<XMLRecursiveAS
   void setLocation(clang::SourceLocation Loc, xmlNodePtr N = nullptr);
   std::string contentBySource(
       clang::SourceLocation LocStart, clang::SourceLocation LocEnd);
+  bool newLiteralList(clang::InitListExpr *ILE);
+  void setIndex(XcodeMlIndex *I) { index = I; }
 
   const char *NameForStmt(clang::Stmt *S);
   const char *NameForType(clang::QualType QT);
@@ -262,13 +342,20 @@ public:                                                         \
   bool Visit##NAME(TYPE S) {                                    \
     (void) S;                                                   \
     newChild(#NAME);                                            \
-    newProp("class", NameFor##NAME(S));                         \
+    newInternedProp("class", NameFor##NAME(S));                 \
     clang::SourceLocation SL;                                   \
     if (SourceLocFor##NAME(S, SL)) {                            \
       setLocation(SL);                                          \
     }                                                           \
     return true;   						\
   }
+  /*!
+   * \brief Traverse a ForStmt, marking the element of each child with
+   * its role.
+   *
+   * The children are traversed recursively since the role is set on
+   * the element right after it is made.
+   */
   bool TraverseForStmt(ForStmt *S)
   {
         xmlNodePtr  save = curNode;
@@ -294,21 +381,39 @@ public:                                                         \
         if(CXXtoXML::debug_flag) printf("*** pop curNode=%p\n",(void *)curNode);
         return true;
     }
-  bool TraverseInitListExpr(InitListExpr *ILE)
+  /*!
+   * \brief Traverse an InitListExpr.
+   *
+   * Taking \c Queue makes RecursiveASTVisitor pass its explicit stack,
+   * so that in the iterative mode the elements are pushed to it and
+   * deeply nested initializers do not overflow the native stack.
+   */
+  bool TraverseInitListExpr(
+      InitListExpr *ILE, DataRecursionQueue *Queue = nullptr)
   {
     WalkUpFromInitListExpr(ILE);
+    if (newLiteralList(ILE)) {
+      return true;
+    }
     for (auto& range : ILE->children()) {
-          TraverseStmt(range);
+          TraverseStmt(range, Queue);
     }
     return true;
   }
-  bool TraverseCXXDefaultArgExpr(CXXDefaultArgExpr *CDAE)
+  bool TraverseCXXDefaultArgExpr(
+      CXXDefaultArgExpr *CDAE, DataRecursionQueue *Queue = nullptr)
   {
     WalkUpFromCXXDefaultArgExpr(CDAE);
     const auto E = CDAE->getExpr();
-    TraverseStmt(E);
+    TraverseStmt(E, Queue);
     return true;
   }
+  /*!
+   * \brief Traverse a UnaryExprOrTypeTraitExpr.
+   *
+   * The operand is traversed recursively; queuing it would put its
+   * element after that of the type location traversed next.
+   */
   bool TraverseUnaryExprOrTypeTraitExpr(UnaryExprOrTypeTraitExpr *UEOTTE)
   {
     WalkUpFromUnaryExprOrTypeTraitExpr(UEOTTE);
@@ -0,0 +1,145 @@
+#include "clang/AST/ASTConsumer.h"
+#include "clang/AST/AST.h"
+#include "clang/Frontend/CompilerInstance.h"
+
+#include "CXXtoXML.h"
+#include "XMLRecursiveASTVisitor.h"
+
+#include "TypeTableInfo.h"
+#include "NnsTableInfo.h"
+#include "XcodeMlConverter.h"
+
+#include <libxml/dict.h>
+#include <libxml/xmlsave.h>
+#include <time.h>
+#include <cassert>
+#include <string>
+
+using namespace clang;
+using namespace llvm;
+
+cl::OptionCategory CXX2XMLCategory("CXXtoXML options");
+
+namespace CXXtoXML{
+
+    bool debug_flag = false;
+    bool iterative_stmt_traversal = true;
+    unsigned literal_list_threshold = 0;
+    std::string index_file;
+    std::string trace_file;
+    unsigned trace_threshold = 100;
+    bool hoist_types = false;
+    bool declarations_only = false;
+
+bool
+isSupportedLanguage(const LangOptions &Opts) {
+  return Opts.CPlusPlus || Opts.C99 || Opts.C11;
+}
+
+/*!
+ * \brief Returns the value of the language attribute of XcodeML.
+ *
+ * \pre isSupportedLanguage(Opts)
+ */
+const char *
+getLanguageString(const LangOptions &Opts) {
+  assert(isSupportedLanguage(Opts));
+  return Opts.CPlusPlus ? "C++" : "C";
+}
+
+} // namespace
+
+namespace {
+
+class XMLASTConsumer : public ASTConsumer {
+  CXXtoXML::DocumentHandler handler;
+  std::string source;
+  const char *language;
+
+public:
+  explicit XMLASTConsumer(
+      CXXtoXML::DocumentHandler H, StringRef file, const LangOptions &Opts)
+      : handler(std::move(H)),
+        source(file.str()),
+        language(CXXtoXML::getLanguageString(Opts)){};
+
+  virtual void
+  HandleTranslationUnit(ASTContext &CXT) override {
+    xmlDocPtr xmlDoc = xmlNewDoc(BAD_CAST "1.0");
+    // element and attribute names and repeated values are interned in it
+    xmlDoc->dict = xmlDictCreate();
+    xmlNodePtr rootnode =
+        xmlNewDocNode(xmlDoc, nullptr, BAD_CAST "clangAST", nullptr);
+    xmlDocSetRootElement(xmlDoc, rootnode);
+
+    char strftimebuf[BUFSIZ];
+    time_t t = time(nullptr);
+
+    strftime(strftimebuf, sizeof strftimebuf, "%F %T", localtime(&t));
+
+    xmlNewProp(rootnode, BAD_CAST "source", BAD_CAST source.c_str());
+    xmlNewProp(rootnode, BAD_CAST "language", BAD_CAST language);
+    xmlNewProp(rootnode, BAD_CAST "time", BAD_CAST strftimebuf);
+
+    XcodeMlIndex index;
+    XcodeMlIndex *I = CXXtoXML::index_file.empty() ? nullptr : &index;
+    MangleContext *MC = CXT.createMangleContext();
+    InheritanceInfo inheritanceinfo;
+    InheritanceInfo *II = &inheritanceinfo;
+    XMLRecursiveASTVisitor XDV(MC, rootnode, nullptr, II);
+    XDV.setIndex(I);
+
+    XDV.TraverseDecl(CXT.getTranslationUnitDecl());
+    handler(xmlDoc, I);
+  }
+};
+
+int
+writeChunk(void *context, const char *buffer, int len) {
+  const auto &write = *static_cast<const CXXtoXML::ChunkWriter *>(context);
+  return write(buffer, len) ? len : -1;
+}
+
+} // namespace
+
+namespace CXXtoXML {
+
+std::unique_ptr<ASTConsumer>
+newXcodeMlConsumer(
+    CompilerInstance &CI, StringRef file, DocumentHandler handler) {
+  if (!isSupportedLanguage(CI.getLangOpts())) {
+    auto &diags = CI.getDiagnostics();
+    diags.Report(diags.getCustomDiagID(DiagnosticsEngine::Error,
+        "cannot convert '%0' to XcodeML: only C99, C11 and C++ are "
+        "supported"))
+        << file;
+    return std::unique_ptr<ASTConsumer>(new ASTConsumer);
+  }
+  return std::unique_ptr<ASTConsumer>(
+      new XMLASTConsumer(std::move(handler), file, CI.getLangOpts()));
+}
+
+bool
+writeXcodeMl(xmlDocPtr doc, const ChunkWriter &write) {
+  // int saveopt = XML_SAVE_FORMAT | XML_SAVE_NO_EMPTY;
+  int saveopt = XML_SAVE_FORMAT;
+  xmlSaveCtxtPtr ctxt = xmlSaveToIO(writeChunk,
+      nullptr,
+      const_cast<ChunkWriter *>(&write),
+      "UTF-8",
+      saveopt);
+  if (!ctxt) {
+    return false;
+  }
+  xmlSaveDoc(ctxt, doc);
+  return xmlSaveClose(ctxt) != -1;
+}
+
+} // namespace CXXtoXML
+
+///
+/// Local Variables:
+/// indent-tabs-mode: nil
+/// c-basic-offset: 4
+/// End:
+///
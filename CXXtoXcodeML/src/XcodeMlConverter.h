@@ -0,0 +1,107 @@
+#ifndef XCODEMLCONVERTER_H
+#define XCODEMLCONVERTER_H
+
+#include <libxml/tree.h>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class XcodeMlIndex;
+
+namespace clang {
+class ASTConsumer;
+class CompilerInstance;
+class LangOptions;
+namespace tooling {
+class FrontendActionFactory;
+} // namespace tooling
+} // namespace clang
+
+namespace llvm {
+class StringRef;
+} // namespace llvm
+
+/*!
+ * In-process interface of CXXtoXcodeML, for tools that link it as a
+ * library (libCXXtoXcodeML.a) instead of running the command and
+ * parsing its output.
+ *
+ * The options of CXXtoXcodeML are the globals in CXXtoXML.h.
+ */
+namespace CXXtoXML {
+
+/*!
+ * \brief Receives the XcodeML document of a translation unit, and
+ * takes ownership of it.
+ *
+ * \c index is the index of the document if CXXtoXML::index_file is
+ * set, or nullptr otherwise.
+ */
+using DocumentHandler =
+    std::function<void(xmlDocPtr doc, const XcodeMlIndex *index)>;
+
+/*!
+ * \brief Receives the serialized XcodeML one chunk at a time.
+ * Returns false to stop writing.
+ */
+using ChunkWriter = std::function<bool(const char *chunk, size_t length)>;
+
+/*!
+ * \brief Determine if XcodeML can be written for the language of
+ * \c Opts (C99, C11 or C++).
+ */
+bool isSupportedLanguage(const clang::LangOptions &Opts);
+
+/*!
+ * \brief Returns an AST consumer that builds the XcodeML document of
+ * the translation unit \c file and passes it to \c handler.
+ *
+ * If the language of \c CI is not supported, it reports an error
+ * through the diagnostics of \c CI and returns a consumer that does
+ * nothing, so the compile fails instead of the process.
+ */
+std::unique_ptr<clang::ASTConsumer> newXcodeMlConsumer(
+    clang::CompilerInstance &CI,
+    llvm::StringRef file,
+    DocumentHandler handler);
+
+/*!
+ * \brief Returns a factory of frontend actions, each of which builds
+ * the XcodeML document of its translation unit and passes it to
+ * \c handler.
+ */
+std::unique_ptr<clang::tooling::FrontendActionFactory>
+newXcodeMlActionFactory(DocumentHandler handler);
+
+/*!
+ * \brief Convert \c code, compiled as \c filename with \c args, to
+ * XcodeML.
+ *
+ * \return The document, to be freed with xmlFreeDoc, or nullptr if
+ * \c code does not compile or is not in a supported language.
+ */
+xmlDocPtr convertCodeToXcodeMl(const std::string &code,
+    const std::vector<std::string> &args,
+    const std::string &filename = "input.cc");
+
+/*!
+ * \brief Convert the source file \c filename, compiled with \c args,
+ * to XcodeML.
+ *
+ * \return The document, to be freed with xmlFreeDoc, or nullptr if
+ * the file does not compile or is not in a supported language.
+ */
+xmlDocPtr convertFileToXcodeMl(
+    const std::string &filename, const std::vector<std::string> &args);
+
+/*!
+ * \brief Serialize \c doc the way CXXtoXcodeML prints it, without
+ * building the whole text in memory.
+ */
+bool writeXcodeMl(xmlDocPtr doc, const ChunkWriter &write);
+
+} // namespace CXXtoXML
+
+#endif /* !XCODEMLCONVERTER_H */
@@ -0,0 +1,381 @@
+#include "clang/AST/AST.h"
+#include "clang/AST/Mangle.h"
+#include "llvm/Support/raw_ostream.h"
+#include <libxml/tree.h>
+#include <libxml/xmlIO.h>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "XcodeMlIndex.h"
+
+using namespace clang;
+using namespace llvm;
+
+namespace {
+
+using NameMap = std::map<xmlNodePtr, std::pair<std::string, std::string>>;
+
+bool
+isContainer(const DeclContext *DC) {
+  return isa<NamespaceDecl>(DC) || isa<LinkageSpecDecl>(DC);
+}
+
+/*!
+ * \brief Return true if \c D is declared at namespace scope, with
+ * only namespaces and linkage specifications around it.
+ */
+bool
+isIndexed(const Decl *D) {
+  const DeclContext *DC = D->getLexicalDeclContext();
+  while (DC && isContainer(DC)) {
+    DC = DC->getLexicalParent();
+  }
+  return DC && isa<TranslationUnitDecl>(DC);
+}
+
+bool
+isMangleable(const NamedDecl *ND) {
+  if (const auto FD = dyn_cast<FunctionDecl>(ND)) {
+    return !isa<CXXConstructorDecl>(FD) && !isa<CXXDestructorDecl>(FD)
+        && !FD->isDependentContext();
+  }
+  if (const auto VD = dyn_cast<VarDecl>(ND)) {
+    return !VD->getDescribedVarTemplate()
+        && !isa<VarTemplatePartialSpecializationDecl>(VD)
+        && !VD->getDeclContext()->isDependentContext()
+        && !VD->getType()->isDependentType();
+  }
+  return false;
+}
+
+bool
+isElement(xmlNodePtr node, const char *name) {
+  return node->type == XML_ELEMENT_NODE
+      && xmlStrEqual(node->name, BAD_CAST name);
+}
+
+bool
+isDecl(xmlNodePtr node, const char *className) {
+  if (!isElement(node, "clangDecl")) {
+    return false;
+  }
+  xmlChar *value = xmlGetProp(node, BAD_CAST "class");
+  const bool result = value && xmlStrEqual(value, BAD_CAST className);
+  xmlFree(value);
+  return result;
+}
+
+bool
+isContainer(xmlNodePtr node) {
+  return isDecl(node, "Namespace") || isDecl(node, "LinkageSpec");
+}
+
+void
+copyProp(xmlNodePtr from, const char *name, xmlNodePtr to, const char *as) {
+  if (xmlChar *value = xmlGetProp(from, BAD_CAST name)) {
+    xmlNewProp(to, BAD_CAST as, value);
+    xmlFree(value);
+  }
+}
+
+bool
+hasSection(xmlNodePtr entries, const char *name) {
+  for (xmlNodePtr entry = entries->children; entry; entry = entry->next) {
+    if (isElement(entry, name)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void
+newNumberProp(xmlNodePtr node, const char *name, unsigned long long value) {
+  xmlNewProp(node, BAD_CAST name, BAD_CAST std::to_string(value).c_str());
+}
+
+void
+setRange(xmlNodePtr entry, unsigned long long begin, unsigned long long end) {
+  newNumberProp(entry, "offset", begin);
+  newNumberProp(entry, "length", end - begin);
+}
+
+/*!
+ * \brief Serialize an XcodeML document one declaration at a time,
+ * recording where each of them lands in the output.
+ *
+ * The bytes are counted here rather than with xmlOutputBuffer::written,
+ * which is an int and overflows on large documents.
+ */
+class DocumentWriter {
+public:
+  DocumentWriter(xmlDocPtr, std::FILE *, const NameMap &);
+  DocumentWriter(const DocumentWriter &) = delete;
+  DocumentWriter &operator=(const DocumentWriter &) = delete;
+  ~DocumentWriter();
+  void write(xmlNodePtr index);
+  bool close();
+
+private:
+  static int writeCallback(void *, const char *, int);
+  static int closeCallback(void *);
+  unsigned long long offset();
+  void writeString(const char *);
+  void writeIndent(int);
+  void writeStartTag(xmlNodePtr);
+  void writeEndTag(xmlNodePtr);
+  std::pair<unsigned long long, unsigned long long> writeDecls(
+      xmlNodePtr, int, xmlNodePtr);
+  xmlNodePtr newEntry(xmlNodePtr, xmlNodePtr);
+
+  xmlDocPtr doc;
+  std::FILE *file;
+  const NameMap &names;
+  unsigned long long written;
+  bool failed;
+  xmlOutputBufferPtr buffer;
+};
+
+DocumentWriter::DocumentWriter(
+    xmlDocPtr doc, std::FILE *file, const NameMap &names)
+    : doc(doc), file(file), names(names), written(0), failed(false) {
+  buffer = xmlOutputBufferCreateIO(writeCallback, closeCallback, this, nullptr);
+}
+
+DocumentWriter::~DocumentWriter() {
+  if (buffer) {
+    xmlOutputBufferClose(buffer);
+  }
+}
+
+int
+DocumentWriter::writeCallback(void *context, const char *data, int len) {
+  auto writer = static_cast<DocumentWriter *>(context);
+  if (std::fwrite(data, 1, len, writer->file) != static_cast<size_t>(len)) {
+    writer->failed = true;
+    return -1;
+  }
+  writer->written += len;
+  return len;
+}
+
+int
+DocumentWriter::closeCallback(void *context) {
+  auto writer = static_cast<DocumentWriter *>(context);
+  return std::fflush(writer->file) == 0 ? 0 : -1;
+}
+
+unsigned long long
+DocumentWriter::offset() {
+  xmlOutputBufferFlush(buffer);
+  return written;
+}
+
+bool
+DocumentWriter::close() {
+  const int result = xmlOutputBufferClose(buffer);
+  buffer = nullptr;
+  return result >= 0 && !failed;
+}
+
+void
+DocumentWriter::writeString(const char *str) {
+  xmlOutputBufferWriteString(buffer, str);
+}
+
+void
+DocumentWriter::writeIndent(int level) {
+  for (int i = 0; i < level; ++i) {
+    writeString("  ");
+  }
+}
+
+void
+DocumentWriter::writeStartTag(xmlNodePtr node) {
+  writeString("<");
+  writeString(reinterpret_cast<const char *>(node->name));
+  xmlBufferPtr value = xmlBufferCreate();
+  for (xmlAttrPtr attr = node->properties; attr; attr = attr->next) {
+    xmlChar *content = xmlNodeListGetString(doc, attr->children, 1);
+    xmlBufferEmpty(value);
+    xmlAttrSerializeTxtContent(value, doc, attr, content);
+    xmlFree(content);
+    writeString(" ");
+    writeString(reinterpret_cast<const char *>(attr->name));
+    writeString("=\"");
+    writeString(reinterpret_cast<const char *>(xmlBufferContent(value)));
+    writeString("\"");
+  }
+  xmlBufferFree(value);
+  writeString(">");
+}
+
+void
+DocumentWriter::writeEndTag(xmlNodePtr node) {
+  writeString("</");
+  writeString(reinterpret_cast<const char *>(node->name));
+  writeString(">");
+}
+
+void
+DocumentWriter::write(xmlNodePtr index) {
+  xmlNodePtr root = xmlDocGetRootElement(doc);
+  copyProp(root, "source", index, "source");
+  writeString("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+  writeStartTag(root);
+  writeString("\n");
+  unsigned long long footer = 0;
+  for (xmlNodePtr child = root->children; child; child = child->next) {
+    writeIndent(1);
+    if (isDecl(child, "TranslationUnit")) {
+      writeStartTag(child);
+      writeString("\n");
+      setRange(xmlNewChild(index, nullptr, BAD_CAST "header", nullptr),
+          0,
+          offset());
+      writeDecls(child, 2, index);
+      footer = offset();
+      writeIndent(1);
+      writeEndTag(child);
+    } else {
+      xmlNodeDumpOutput(buffer, doc, child, 1, 1, nullptr);
+    }
+    writeString("\n");
+  }
+  writeEndTag(root);
+  writeString("\n");
+  const auto length = offset();
+  setRange(xmlNewChild(index, nullptr, BAD_CAST "footer", nullptr),
+      footer,
+      length);
+  newNumberProp(index, "length", length);
+}
+
+/*!
+ * \brief Write the children of a translation unit, namespace or
+ * linkage specification and add their entries to \c entries.
+ * \return The offsets where its first declaration begins and its
+ * last one ends.
+ */
+std::pair<unsigned long long, unsigned long long>
+DocumentWriter::writeDecls(xmlNodePtr parent, int level, xmlNodePtr entries) {
+  const bool isTranslationUnit = isDecl(parent, "TranslationUnit");
+  unsigned long long firstDecl = 0;
+  unsigned long long lastDecl = 0;
+  bool hasDecl = false;
+  for (xmlNodePtr child = parent->children; child; child = child->next) {
+    writeIndent(level);
+    const auto begin = offset();
+    xmlNodePtr entry = nullptr;
+    if (isContainer(child)) {
+      entry = newEntry(entries, child);
+      writeStartTag(child);
+      writeString("\n");
+      const auto body = writeDecls(child, level + 1, entry);
+      writeIndent(level);
+      writeEndTag(child);
+      const auto end = offset();
+      newNumberProp(entry, "head_length", body.first - begin);
+      newNumberProp(entry, "tail_length", end - body.second);
+    } else {
+      xmlNodeDumpOutput(buffer, doc, child, level, 1, nullptr);
+    }
+    const auto end = offset();
+    writeString("\n");
+
+    const char *section = nullptr;
+    if (isElement(child, "clangDecl")) {
+      if (!entry) {
+        entry = newEntry(entries, child);
+      }
+      if (!hasDecl) {
+        firstDecl = begin;
+        hasDecl = true;
+      }
+      lastDecl = end;
+    } else if (isTranslationUnit && isElement(child, "xcodemlTypeTable")) {
+      section = "typeTable";
+    } else if (isTranslationUnit && isElement(child, "xcodemlNnsTable")) {
+      section = "nnsTable";
+    }
+    if (section && !hasSection(entries, section)) {
+      entry = xmlNewChild(entries, nullptr, BAD_CAST section, nullptr);
+    }
+    if (entry) {
+      setRange(entry, begin, end);
+    }
+  }
+  if (!hasDecl) {
+    firstDecl = lastDecl = offset();
+  }
+  return std::make_pair(firstDecl, lastDecl);
+}
+
+xmlNodePtr
+DocumentWriter::newEntry(xmlNodePtr entries, xmlNodePtr decl) {
+  xmlNodePtr entry = xmlNewChild(entries, nullptr, BAD_CAST "decl", nullptr);
+  copyProp(decl, "class", entry, "kind");
+  const auto names = this->names.find(decl);
+  if (names != this->names.end()) {
+    xmlNewProp(entry, BAD_CAST "name", BAD_CAST names->second.first.c_str());
+    if (!names->second.second.empty()) {
+      xmlNewProp(entry,
+          BAD_CAST "mangled_name",
+          BAD_CAST names->second.second.c_str());
+    }
+  } else {
+    for (xmlNodePtr child = decl->children; child; child = child->next) {
+      if (isElement(child, "name")) {
+        xmlChar *name = xmlNodeGetContent(child);
+        xmlNewProp(entry, BAD_CAST "name", name);
+        xmlFree(name);
+        break;
+      }
+    }
+  }
+  copyProp(decl, "file", entry, "file");
+  copyProp(decl, "lineno", entry, "line");
+  return entry;
+}
+
+} // namespace
+
+/*!
+ * \brief Remember the names of \c D, whose element is \c node, if it is
+ * declared at namespace scope.
+ */
+void
+XcodeMlIndex::addDecl(
+    xmlNodePtr node, const clang::Decl *D, clang::MangleContext &MC) {
+  const auto ND = dyn_cast<NamedDecl>(D);
+  if (!ND || !isIndexed(ND)) {
+    return;
+  }
+  auto &entry = names[node];
+  entry.first = ND->getQualifiedNameAsString();
+  if (isMangleable(ND) && MC.shouldMangleDeclName(ND)) {
+    raw_string_ostream OS(entry.second);
+    MC.mangleName(ND, OS);
+    OS.flush();
+  }
+}
+
+/*!
+ * \brief Write \c doc to \c output and its index to \c indexFile.
+ * \return false if either of them could not be written.
+ */
+bool
+XcodeMlIndex::write(
+    xmlDocPtr doc, std::FILE *output, const std::string &indexFile) const {
+  xmlDocPtr index = xmlNewDoc(BAD_CAST "1.0");
+  xmlNodePtr root = xmlNewNode(nullptr, BAD_CAST "xcodemlIndex");
+  xmlDocSetRootElement(index, root);
+
+  DocumentWriter writer(doc, output, names);
+  writer.write(root);
+  bool ok = writer.close();
+  ok = xmlSaveFormatFileEnc(indexFile.c_str(), index, "UTF-8", 1) >= 0 && ok;
+  xmlFreeDoc(index);
+  return ok;
+}
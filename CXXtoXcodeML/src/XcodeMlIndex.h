@@ -0,0 +1,36 @@
+#ifndef XCODEMLINDEX_H
+#define XCODEMLINDEX_H
+
+/*!
+ * \brief Index sidecar of an XcodeML document.
+ *
+ * It gives the byte ranges of the type and NNS tables and of each
+ * declaration at namespace scope, so that a reader can parse only
+ * the declarations it needs (XcodeMLtoCXX --only):
+ *
+ * <xcodemlIndex source="a.cpp" length="...">
+ *   <header offset="0" length="..."/>
+ *   <typeTable offset="..." length="..."/>
+ *   <nnsTable offset="..." length="..."/>
+ *   <decl kind="Namespace" name="ns" offset="..." length="..."
+ *       head_length="..." tail_length="...">
+ *     <decl kind="Function" name="ns::f" mangled_name="_ZN2ns1fEv"
+ *         file="a.cpp" line="3" offset="..." length="..."/>
+ *   </decl>
+ *   <footer offset="..." length="..."/>
+ * </xcodemlIndex>
+ *
+ * The head and the tail of a namespace or a linkage specification
+ * are what comes before its first and after its last declaration.
+ */
+class XcodeMlIndex {
+public:
+  void addDecl(xmlNodePtr, const clang::Decl *, clang::MangleContext &);
+  bool write(xmlDocPtr, std::FILE *, const std::string &) const;
+
+private:
+  // the qualified and mangled names of the declarations
+  std::map<xmlNodePtr, std::pair<std::string, std::string>> names;
+};
+
+#endif /* !XCODEMLINDEX_H */
@@ -0,0 +1,117 @@
+#include "clang/AST/ASTConsumer.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/FrontendPluginRegistry.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "CXXtoXML.h"
+#include "XcodeMlConverter.h"
+
+#include <libxml/tree.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace clang;
+using namespace llvm;
+
+namespace {
+
+/*!
+ * \brief Emits XcodeML as a side effect of a regular compile:
+ *
+ *   clang++ -c a.cpp -o a.o -fplugin=XcodeMlPlugin.so
+ *
+ * writes a.xcodeml next to a.o, from the AST the compile has already
+ * built. The plugin arguments (-Xclang -plugin-arg-xcodeml -Xclang ARG)
+ * are
+ * - out=FILE: write the XcodeML to FILE instead
+ * - hoist-types: same as the --hoist-types option of CXXtoXcodeML
+ *
+ * Translation units in languages other than C99, C11 and C++ (e.g.,
+ * C89 or OpenCL) are compiled as usual with a warning, and get no
+ * XcodeML.
+ */
+class XcodeMlPluginAction : public PluginASTAction {
+  std::string outputFile;
+
+  static std::string
+  getDefaultOutputFile(const CompilerInstance &CI, StringRef InFile) {
+    SmallString<128> path(CI.getFrontendOpts().OutputFile);
+    if (path.empty() || path == "-") {
+      path = sys::path::filename(InFile);
+    }
+    sys::path::replace_extension(path, "xcodeml");
+    return path.str().str();
+  }
+
+protected:
+  std::unique_ptr<ASTConsumer>
+  CreateASTConsumer(CompilerInstance &CI, StringRef InFile) override {
+    auto &diags = CI.getDiagnostics();
+    if (!CXXtoXML::isSupportedLanguage(CI.getLangOpts())) {
+      // the compile itself is fine, so skip the file instead of failing
+      diags.Report(diags.getCustomDiagID(DiagnosticsEngine::Warning,
+          "XcodeML is not written for '%0': unsupported language"))
+          << InFile;
+      return std::unique_ptr<ASTConsumer>(new ASTConsumer);
+    }
+    const auto output =
+        outputFile.empty() ? getDefaultOutputFile(CI, InFile) : outputFile;
+    return CXXtoXML::newXcodeMlConsumer(
+        CI, InFile, [output, &diags](xmlDocPtr doc, const XcodeMlIndex *) {
+          bool written = false;
+          if (std::FILE *file = std::fopen(output.c_str(), "w")) {
+            written = CXXtoXML::writeXcodeMl(
+                doc, [file](const char *chunk, size_t length) {
+                  return std::fwrite(chunk, 1, length, file) == length;
+                });
+            written = std::fclose(file) == 0 && written;
+          }
+          if (!written) {
+            diags.Report(diags.getCustomDiagID(
+                DiagnosticsEngine::Error, "cannot write XcodeML to '%0'"))
+                << output;
+          }
+          xmlFreeDoc(doc);
+        });
+  }
+
+  bool
+  ParseArgs(const CompilerInstance &CI,
+      const std::vector<std::string> &args) override {
+    for (const auto &arg : args) {
+      if (arg.compare(0, 4, "out=") == 0) {
+        outputFile = arg.substr(4);
+      } else if (arg == "hoist-types") {
+        CXXtoXML::hoist_types = true;
+      } else {
+        auto &diags = CI.getDiagnostics();
+        diags.Report(diags.getCustomDiagID(DiagnosticsEngine::Error,
+            "unknown argument '%0' to the xcodeml plugin"))
+            << arg;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  ActionType
+  getActionType() override {
+    // run along with the compile, without being named by -plugin
+    return AddAfterMainAction;
+  }
+};
+
+} // namespace
+
+static FrontendPluginRegistry::Add<XcodeMlPluginAction> XcodeMlPlugin(
+    "xcodeml", "write the XcodeML of the translation unit");
+
+///
+/// Local Variables:
+/// indent-tabs-mode: nil
+/// c-basic-offset: 4
+/// End:
+///
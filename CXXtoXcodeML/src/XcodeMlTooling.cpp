@@ -0,0 +1,118 @@
+#include "clang/AST/ASTConsumer.h"
+#include "clang/Frontend/FrontendActions.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/Support/CommandLine.h"
+
+#include "CXXtoXML.h"
+#include "XcodeMlConverter.h"
+
+#include <libxml/tree.h>
+#include <string>
+#include <vector>
+
+// The parts of the interface that run clang themselves, apart from
+// XcodeMlConverter.cpp so that the plugin does not depend on
+// libclangTooling.
+
+using namespace clang;
+using namespace clang::tooling;
+using namespace llvm;
+
+namespace {
+
+/* */
+class XMLASTDumpAction : public ASTFrontendAction {
+private:
+  CXXtoXML::DocumentHandler handler;
+
+public:
+  explicit XMLASTDumpAction(CXXtoXML::DocumentHandler H)
+      : handler(std::move(H)) {
+  }
+
+  virtual std::unique_ptr<ASTConsumer>
+  CreateASTConsumer(CompilerInstance &CI, StringRef file) override {
+    return CXXtoXML::newXcodeMlConsumer(CI, file, handler);
+  }
+
+  virtual bool
+  BeginInvocation(CompilerInstance &CI) override {
+    // Sema then leaves the bodies unparsed (FunctionDecl::hasSkippedBody)
+    // and the visitor finds no statements to emit.
+    CI.getFrontendOpts().SkipFunctionBodies = CXXtoXML::declarations_only;
+    return true;
+  }
+};
+
+class XMLASTDumpActionFactory : public FrontendActionFactory {
+  CXXtoXML::DocumentHandler handler;
+
+public:
+  explicit XMLASTDumpActionFactory(CXXtoXML::DocumentHandler H)
+      : handler(std::move(H)) {
+  }
+
+  FrontendAction *
+  create() override {
+    return new XMLASTDumpAction(handler);
+  }
+};
+
+} // namespace
+
+namespace CXXtoXML {
+
+std::unique_ptr<FrontendActionFactory>
+newXcodeMlActionFactory(DocumentHandler handler) {
+  return std::unique_ptr<FrontendActionFactory>(
+      new XMLASTDumpActionFactory(std::move(handler)));
+}
+
+xmlDocPtr
+convertCodeToXcodeMl(const std::string &code,
+    const std::vector<std::string> &args,
+    const std::string &filename) {
+  xmlDocPtr result = nullptr;
+  const auto keep = [&result](xmlDocPtr doc, const XcodeMlIndex *) {
+    xmlFreeDoc(result);
+    result = doc;
+  };
+  // runToolOnCodeWithArgs takes the ownership of the action
+  if (!runToolOnCodeWithArgs(
+          new XMLASTDumpAction(keep), code, args, filename)) {
+    xmlFreeDoc(result);
+    return nullptr;
+  }
+  return result;
+}
+
+xmlDocPtr
+convertFileToXcodeMl(
+    const std::string &filename, const std::vector<std::string> &args) {
+  FixedCompilationDatabase compilations(".", args);
+  ClangTool tool(compilations, {filename});
+  tool.appendArgumentsAdjuster(getClangSyntaxOnlyAdjuster());
+
+  xmlDocPtr result = nullptr;
+  const auto factory =
+      newXcodeMlActionFactory([&result](xmlDocPtr doc, const XcodeMlIndex *) {
+        xmlFreeDoc(result);
+        result = doc;
+      });
+  if (tool.run(factory.get()) != 0) {
+    xmlFreeDoc(result);
+    return nullptr;
+  }
+  return result;
+}
+
+} // namespace CXXtoXML
+
+///
+/// Local Variables:
+/// indent-tabs-mode: nil
+/// c-basic-offset: 4
+/// End:
+///
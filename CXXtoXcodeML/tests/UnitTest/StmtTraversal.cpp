@@ -0,0 +1,106 @@
+#define BOOST_TEST_MODULE StmtTraversal
+#include <boost/test/included/unit_test.hpp>
+#include <string>
+#include <vector>
+#include <libxml/tree.h>
+#include "llvm/Support/CommandLine.h"
+
+#include "CXXtoXML.h"
+#include "XcodeMlConverter.h"
+
+namespace {
+
+/*!
+ * \brief Returns the XcodeML of \c code converted in the iterative
+ * mode if \c iterative, or in the recursive mode otherwise, without
+ * the time of the conversion.
+ */
+std::string
+convert(const std::string &code, bool iterative) {
+  CXXtoXML::iterative_stmt_traversal = iterative;
+  const auto doc = CXXtoXML::convertCodeToXcodeMl(
+      code, {"-std=c++11"}, "t.cpp");
+  CXXtoXML::iterative_stmt_traversal = true;
+  BOOST_REQUIRE(doc);
+  const auto root = xmlDocGetRootElement(doc);
+  xmlUnsetProp(root, BAD_CAST "time");
+  xmlBufferPtr buffer = xmlBufferCreate();
+  xmlNodeDump(buffer, doc, root, 0, 1);
+  const std::string result(reinterpret_cast<const char *>(buffer->content));
+  xmlBufferFree(buffer);
+  xmlFreeDoc(doc);
+  return result;
+}
+
+size_t
+count(const std::string &str, const std::string &pattern) {
+  size_t n = 0;
+  for (auto pos = str.find(pattern); pos != std::string::npos;
+       pos = str.find(pattern, pos + pattern.size())) {
+    ++n;
+  }
+  return n;
+}
+
+/*!
+ * \brief Returns the definition of an array of \c depth dimensions
+ * initialized with as deeply nested initializer lists.
+ */
+std::string
+nestedInitializer(size_t depth) {
+  std::string dims, open, close;
+  for (size_t i = 0; i < depth; ++i) {
+    dims += "[1]";
+    open += "{";
+    close += "}";
+  }
+  return "int a" + dims + " = " + open + "1" + close + ";\n";
+}
+
+const std::string statements =
+    "struct P { int x; int y[2]; };\n"
+    "P ps[] = {{1, {2, 3}}, {4, {5, 6}}};\n"
+    "int f(int n = 1 + 2 * 3);\n"
+    "int g(int m) {\n"
+    "  int s = 0;\n"
+    "  for (int i = 0; i < m; ++i) {\n"
+    "    for (int j = sizeof(int); j < (int)sizeof s; j++)\n"
+    "      s += f() + ps[i % 2].y[j % 2];\n"
+    "  }\n"
+    "  int t[] = {m, -m, (m + 1) * 2, sizeof(P)};\n"
+    "  return s + t[0];\n"
+    "}\n";
+
+BOOST_AUTO_TEST_SUITE(stmt_traversal)
+
+BOOST_AUTO_TEST_CASE(same_output_test) {
+  BOOST_TEST_CHECKPOINT("Both modes emit the same XcodeML");
+  const auto iterative = convert(statements, true);
+  BOOST_CHECK_EQUAL(iterative, convert(statements, false));
+  BOOST_CHECK_EQUAL(count(iterative, "class=\"ForStmt\""), 2);
+  BOOST_CHECK_EQUAL(count(iterative, "for_stmt_kind=\"body\""), 2);
+  BOOST_CHECK_EQUAL(count(iterative, "class=\"CXXDefaultArgExpr\""), 1);
+
+  BOOST_TEST_CHECKPOINT("Nested initializer lists keep their order");
+  const auto nested = nestedInitializer(32) + statements;
+  BOOST_CHECK_EQUAL(convert(nested, true), convert(nested, false));
+}
+
+BOOST_AUTO_TEST_CASE(deep_nesting_test) {
+  BOOST_TEST_CHECKPOINT(
+      "Initializer lists as deeply nested as clang allows by default");
+  const auto nested = convert(nestedInitializer(250), true);
+  BOOST_CHECK_EQUAL(count(nested, "class=\"InitListExpr\""), 250);
+
+  BOOST_TEST_CHECKPOINT("Deeply nested expressions");
+  std::string sum = "int s = 1";
+  for (int i = 0; i < 20000; ++i) {
+    sum += " + 1";
+  }
+  const auto deep = convert(sum + ";\n", true);
+  BOOST_CHECK_EQUAL(count(deep, "class=\"BinaryOperator\""), 20000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace
@@ -1,6 +1,8 @@
 #ifndef ATTRPROC_H
 #define ATTRPROC_H
 
+#include "TraceEvent.h"
+
 template <typename ReturnT, typename... T>
 class AttrProc {
 public:
@@ -23,16 +25,27 @@ public:
 
   ReturnT
   walk(xmlNodePtr node, T... args) const {
-    std::string getProp(xmlNodePtr, const std::string &);
+    llvm::StringRef getPropRef(xmlNodePtr, const char *);
     assert(node && node->type == XML_ELEMENT_NODE);
-    std::string prop(getProp(node, attr));
+    const std::string prop(getPropRef(node, attr.c_str()));
     auto iter = map.find(prop);
+    TraceEvent::Scope trace(
+        reinterpret_cast<const char *>(node->name), prop.c_str());
     if (iter != map.end()) {
       return (iter->second)(node, args...);
     }
     return defaultProc(node, args...);
   }
 
+  /*!
+   * \brief Returns true if a procedure other than the default one
+   * is registered for \c key.
+   */
+  bool
+  hasProc(const std::string &key) const {
+    return map.find(key) != map.end();
+  }
+
   std::vector<ReturnT>
   walkAll(xmlNodePtr node, T... args) const {
     if (!node) {
@@ -72,9 +85,14 @@ public:
 
   void
   walk(xmlNodePtr node, T... args) const {
+    llvm::Optional<llvm::StringRef> getPropRefOrNull(
+        xmlNodePtr, const char *);
     assert(node && node->type == XML_ELEMENT_NODE);
-    XMLString prop(xmlGetProp(node, BAD_CAST attr.c_str()));
-    auto iter = map.find(prop);
+    const auto prop = getPropRefOrNull(node, attr.c_str());
+    if (!prop.hasValue()) {
+      return;
+    }
+    auto iter = map.find(prop->str());
     if (iter != map.end()) {
       (iter->second)(node, args...);
     }
@@ -0,0 +1,62 @@
+#include <libxml/tree.h>
+#include <libxml/parser.h>
+#include <libxml/xpath.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "llvm/ADT/Optional.h"
+#include "StringTree.h"
+#include "XMLString.h"
+#include "XcodeMlNns.h"
+#include "XcodeMlType.h"
+#include "XcodeMlTypeTable.h"
+#include "XMLWalker.h"
+#include "TypeAnalyzer.h"
+#include "SourceInfo.h"
+#include "CodeBuilder.h"
+#include "CXXConverter.h"
+
+namespace {
+
+struct XPathContextReleaser {
+  void
+  operator()(xmlXPathContextPtr ctxt) {
+    xmlXPathFreeContext(ctxt);
+  }
+};
+
+struct DocReleaser {
+  void
+  operator()(xmlDocPtr doc) {
+    xmlFreeDoc(doc);
+  }
+};
+
+} // namespace
+
+void
+convertXcodeMlToCXX(xmlDocPtr doc, std::ostream &out) {
+  std::unique_ptr<xmlXPathContext, XPathContextReleaser> ctxt(
+      xmlXPathNewContext(doc));
+  std::stringstream ss;
+  buildCode(xmlDocGetRootElement(doc), ctxt.get(), ss);
+  out << ss.str() << std::endl;
+}
+
+void
+convertXcodeMlToCXX(const char *buffer, size_t size, std::ostream &out) {
+  std::unique_ptr<xmlDoc, DocReleaser> doc(xmlReadMemory(buffer,
+      size,
+      nullptr,
+      nullptr,
+      XML_PARSE_BIG_LINES | XML_PARSE_HUGE));
+  if (!doc) {
+    throw std::runtime_error("Cannot parse the XcodeML document");
+  }
+  convertXcodeMlToCXX(doc.get(), out);
+}
@@ -0,0 +1,29 @@
+#ifndef CXXCONVERTER_H
+#define CXXCONVERTER_H
+
+/*!
+ * \brief Generate the C++ code of the XcodeML document \c doc into
+ * \c out, as XcodeMLtoCXX prints it.
+ *
+ * This is the in-process interface of XcodeMLtoCXX, for tools that
+ * link libXcodeMLtoCXX.a instead of running the command.
+ *
+ * \throw std::runtime_error or std::out_of_range if \c doc refers to
+ * a missing attribute, element, type or NNS, or uses an unknown
+ * operator or element.
+ *
+ * The remaining consistency checks (e.g., that a type referred to as a
+ * class is a class) are assertions, which terminate the process on
+ * invalid input unless \c NDEBUG is defined.
+ */
+void convertXcodeMlToCXX(xmlDocPtr doc, std::ostream &out);
+
+/*!
+ * \brief Parse the XcodeML document in \c buffer and generate its C++
+ * code into \c out.
+ *
+ * \throw std::runtime_error if \c buffer is not well-formed XML.
+ */
+void convertXcodeMlToCXX(const char *buffer, size_t size, std::ostream &out);
+
+#endif /* !CXXCONVERTER_H */
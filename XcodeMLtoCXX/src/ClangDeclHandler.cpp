@@ -2,12 +2,15 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <set>
 #include <vector>
 #include <string>
 #include <exception>
+#include <stdexcept>
 #include <libxml/tree.h>
 #include <libxml/xpath.h>
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Casting.h"
 
 #include "LibXMLUtil.h"
@@ -28,6 +31,10 @@
 #include "XMLWalker.h"
 
 #include "CodeBuilder.h"
+#include "DependencyGraph.h"
+#include "FragmentCache.h"
+#include "OutputSplitter.h"
+#include "TraceEvent.h"
 
 #include "ClangDeclHandler.h"
 
@@ -56,6 +63,119 @@ createNodes(xmlNodePtr node,
   return vec;
 }
 
+/*!
+ * \brief Returns true if \c node is a namespace-scope definition that
+ * may go into any of the translation units of \c src.outputSplitter.
+ *
+ * Inline functions, constants and the members of unnamed namespaces
+ * are needed by every translation unit and stay in the shared header.
+ */
+bool
+isSplittableDefinition(xmlNodePtr node, const SourceInfo &src) {
+  if (!src.outputSplitter || src.outputSplitter->isInAnonymousNamespace()) {
+    return false;
+  }
+  const auto declClass = getProp(node, "class");
+  const std::vector<std::string> fnDecls = {
+      "Function",
+      "CXXConstructor",
+      "CXXConversion",
+      "CXXDestructor",
+      "CXXMethod",
+  };
+  if (std::find(fnDecls.begin(), fnDecls.end(), declClass) != fnDecls.end()) {
+    return findFirst(node, "clangStmt", src.ctxt)
+        && !isTrueProp(node, "is_inline", false);
+  }
+  if (declClass != "Var" || isTrueProp(node, "has_external_storage", false)
+      || isTrueProp(node, "is_constexpr", false)) {
+    return false;
+  }
+  if (src.language != Language::CPlusPlus
+      || isTrueProp(node, "is_static_data_member", false)) {
+    return true;
+  }
+  /* A const variable has internal linkage in C++ */
+  auto T = src.typeTable.at(getType(node));
+  while (!T->isConst()) {
+    if (const auto arrayT = llvm::dyn_cast<XcodeMl::Array>(T.get())) {
+      T = arrayT->getElemType(src.typeTable);
+    } else if (const auto QT = llvm::dyn_cast<XcodeMl::QualifiedType>(
+                   T.get())) {
+      if (QT->isConstQualified()) {
+        return false;
+      }
+      T = src.typeTable.at(QT->getUnderlyingType());
+    } else {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*!
+ * \brief Returns the declaration to leave in the shared header in place
+ * of a definition moved by \c src.outputSplitter.
+ */
+CodeFragment
+makeHeaderDeclaration(xmlNodePtr node, const SourceInfo &src) {
+  if (xmlHasProp(node, BAD_CAST "parent_class")
+      || isTrueProp(node, "is_static_data_member", false)
+      || findFirst(node, "clangNestedNameSpecifier", src.ctxt)) {
+    /* Members are declared in their class or namespace. */
+    return CXXCodeGen::makeVoidNode();
+  }
+  if (getProp(node, "class") != "Var") {
+    const auto paramNames = getParamNames(node, src);
+    const auto head = makeFunctionDeclHead(node, paramNames, src, true);
+    return wrapWithLangLink(head + makeTokenNode(";"), node, src);
+  }
+  const auto name =
+      getQualifiedName(node, src).toString(src.typeTable, src.nnsTable);
+  const auto T = src.typeTable.at(getType(node));
+  auto decl = makeTokenNode("extern");
+  if (isTrueProp(node, "is_thread_local", false)) {
+    decl = decl + makeTokenNode("thread_local");
+  }
+  decl = decl + T->makeDeclaration(name, src.typeTable, src.nnsTable);
+  return wrapWithLangLink(decl, node, src) + makeTokenNode(";");
+}
+
+/*!
+ * \brief Name the trace event of the declaration \c node after it and
+ * where it comes from.
+ */
+void
+describeDecl(TraceEvent::Scope &trace, xmlNodePtr node, SourceInfo &src) {
+  const auto className = getProp(node, "class");
+  const auto nameNode = findFirst(node, "name", src.ctxt);
+  trace.setName(nameNode ? getContent(nameNode) : className);
+  auto detail = className;
+  const auto file = getPropOrNull(node, "file");
+  const auto line = getPropOrNull(node, "lineno");
+  if (file.hasValue() && line.hasValue()) {
+    detail += " at " + *file + ":" + *line;
+  }
+  trace.setDetail(detail);
+}
+
+/*!
+ * \brief Returns the mark of the position of the declaration \c node in
+ * the original source, if SourceInfo::sourcePositions is set.
+ */
+CodeFragment
+makeSourcePosition(xmlNodePtr node, const SourceInfo &src) {
+  if (!src.sourcePositions) {
+    return CXXCodeGen::makeVoidNode();
+  }
+  const auto file = getPropOrNull(node, "file");
+  const auto line = getPropOrNull(node, "lineno");
+  if (!file.hasValue() || !line.hasValue()) {
+    return CXXCodeGen::makeVoidNode();
+  }
+  return CXXCodeGen::makeSourcePosNode(*file, std::stoul(*line));
+}
+
 CodeFragment
 foldDecls(xmlNodePtr node, const CodeBuilder &w, SourceInfo &src) {
   const auto declNodes = findNodes(node, "clangDecl", src.ctxt);
@@ -64,13 +184,24 @@ foldDecls(xmlNodePtr node, const CodeBuilder &w, SourceInfo &src) {
     if (isTrueProp(declNode, "is_implicit", false)) {
       continue;
     }
-    const auto decl = w.walk(declNode, src);
-
+    TraceEvent::Scope trace("declaration", "clangDecl");
+    if (trace.isActive()) {
+      describeDecl(trace, declNode, src);
+    }
+    const auto position = makeSourcePosition(declNode, src);
+    auto decl = position + walkWithFragmentCache(w, declNode, src);
     if (requiresSemicolon(declNode, src)) {
-      decls.push_back(decl + makeTokenNode(";"));
-    } else {
-      decls.push_back(decl);
+      decl = decl + makeTokenNode(";");
     }
+    if (src.dependencyGraph) {
+      src.dependencyGraph->addDeclaration(declNode, src);
+    }
+
+    if (isSplittableDefinition(declNode, src)) {
+      src.outputSplitter->addDefinition(decl);
+      decl = position + makeHeaderDeclaration(declNode, src);
+    }
+    decls.push_back(decl);
   }
   return insertNewLines(decls);
 }
@@ -304,8 +435,10 @@ DEFINE_DECLHANDLER(CXXRecordProc) {
 
   const auto T = src.typeTable.at(getType(node));
   auto classT = llvm::dyn_cast<XcodeMl::ClassType>(T.get());
-  //std::cerr <<getType(node)<<classT<<std::endl;
-  assert(classT);
+  if (!classT) {
+    throw std::runtime_error(
+        "CXXRecord of '" + getType(node) + "' which is not a class");
+  }
   setClassName(*classT, src);
   const auto nameSpelling = classT->name(); // now class name must exist
 
@@ -365,8 +498,8 @@ DEFINE_DECLHANDLER(EnumProc) {
 
 DEFINE_DECLHANDLER(EnumConstantProc) {
   const auto nameNode = findFirst(node, "name", src.ctxt);
-  const auto name =
-      getUnqualIdFromNameNode(nameNode)->toString(src.typeTable, src.nnsTable);
+  const auto name = getUnqualIdFromNameNode(nameNode, src)->toString(
+      src.typeTable, src.nnsTable);
 
   const auto exprNode = findFirst(node, "clangStmt", src.ctxt);
   if (!exprNode) {
@@ -389,7 +522,7 @@ DEFINE_DECLHANDLER(FieldDeclProc) {
   }
   if (!isTrueProp(node, "is_unnamed_bit_field", false)) {
     const auto nameNode = findFirst(node, "name", src.ctxt);
-    name = getUnqualIdFromNameNode(nameNode)->toString(
+    name = getUnqualIdFromNameNode(nameNode, src)->toString(
         src.typeTable, src.nnsTable);
   }
   return makeDecl(T, name, src.typeTable, src.nnsTable) + bits;
@@ -410,6 +543,13 @@ DEFINE_DECLHANDLER(FunctionProc) {
   if (isTrueProp(node, "is_implicit", 0)) {
     return CXXCodeGen::makeVoidNode();
   }
+  if (isTrueProp(node, "has_skipped_body", false)
+      && isTrueProp(node, "is_out_of_line", false)) {
+    /* The body was skipped (CXXtoXcodeML --declarations-only), and
+     * an out-of-line member cannot be redeclared without it.
+     */
+    return CXXCodeGen::makeVoidNode();
+  }
   const auto type = getProp(node, "xcodemlType");
   const auto paramNames = getParamNames(node, src);
   auto acc = makeFunctionDeclHead(node, paramNames, src, true);
@@ -458,10 +598,17 @@ DEFINE_DECLHANDLER(LinkageSpecProc) {
 
 DEFINE_DECLHANDLER(NamespaceProc) {
   const auto nameNode = findFirst(node, "name", src.ctxt);
-  const auto name =
-      getUnqualIdFromNameNode(nameNode)->toString(src.typeTable, src.nnsTable);
+  const auto name = getUnqualIdFromNameNode(nameNode, src)->toString(
+      src.typeTable, src.nnsTable);
   const auto head = makeTokenNode("namespace") + name;
+  if (src.outputSplitter) {
+    src.outputSplitter->enterNamespace(
+        head, isTrueProp(node, "is_anonymous", false));
+  }
   const auto decls = foldDecls(node, w, src);
+  if (src.outputSplitter) {
+    src.outputSplitter->exitNamespace();
+  }
   return head + wrapWithBrace(decls);
 }
 
@@ -472,7 +619,7 @@ setStructName(XcodeMl::Struct &s, xmlNodePtr node, SourceInfo &src) {
     s.setTagName(makeTokenNode(src.getUniqueName()));
     return;
   }
-  const auto name = getUnqualIdFromNameNode(nameNode);
+  const auto name = getUnqualIdFromNameNode(nameNode, src);
   const auto nameSpelling = name->toString(src.typeTable, src.nnsTable);
   s.setTagName(nameSpelling);
 }
@@ -483,7 +630,10 @@ DEFINE_DECLHANDLER(RecordProc) {
   }
   const auto T = src.typeTable.at(getType(node));
   auto structT = llvm::dyn_cast<XcodeMl::Struct>(T.get());
-  assert(structT);
+  if (!structT) {
+    throw std::runtime_error(
+        "Record of '" + getType(node) + "' which is not a struct");
+  }
   setStructName(*structT, node, src);
   const auto tagName = structT->tagName();
 
@@ -546,7 +696,7 @@ DEFINE_DECLHANDLER(TypeAliasProc) {
 
   const auto dtident = getProp(node, "xcodemlTypedefType");
   const auto T = src.typeTable.at(dtident);
-  const auto name = getUnqualIdFromIdNode(node, src.ctxt);
+  const auto name = getUnqualIdFromIdNode(node, src);
   const auto nameSpelling = name->toString(src.typeTable, src.nnsTable);
   return makeTokenNode("using") + nameSpelling + makeTokenNode("=")
       + makeDecl(T, CXXCodeGen::makeVoidNode(), src.typeTable, src.nnsTable);
@@ -560,8 +710,8 @@ DEFINE_DECLHANDLER(TypedefProc) {
   const auto T = src.typeTable.at(dtident);
 
   const auto nameNode = findFirst(node, "name", src.ctxt);
-  const auto typedefName =
-      getUnqualIdFromNameNode(nameNode)->toString(src.typeTable, src.nnsTable);
+  const auto typedefName = getUnqualIdFromNameNode(nameNode, src)->toString(
+      src.typeTable, src.nnsTable);
 
   return makeTokenNode("typedef")
       + makeDecl(T, typedefName, src.typeTable, src.nnsTable);
@@ -627,7 +777,7 @@ emitVarDecl(xmlNodePtr node,
     // does not have initalizer: `int x;`
     return decl;
   }
-  const auto astClass = getProp(initializerNode, "class");
+  const auto astClass = getPropRef(initializerNode, "class");
   if (std::equal(astClass.begin(), astClass.end(), "CXXConstructExpr")) {
     // has initalizer and the variable is of class type
     const auto init = declareClassTypeInit(w, initializerNode, src);
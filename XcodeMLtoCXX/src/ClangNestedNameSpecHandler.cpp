@@ -7,6 +7,7 @@
 #include <libxml/tree.h>
 #include <libxml/xpath.h>
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Casting.h"
 
 #include "LibXMLUtil.h"
@@ -47,8 +48,8 @@ DEFINE_NAMESPECHANDLER(globalSpecProc) {
 
 DEFINE_NAMESPECHANDLER(NamespaceSpecProc) {
   const auto nameNode = findFirst(node, "name", src.ctxt);
-  const auto name =
-      getUnqualIdFromNameNode(nameNode)->toString(src.typeTable, src.nnsTable);
+  const auto name = getUnqualIdFromNameNode(nameNode, src)->toString(
+      src.typeTable, src.nnsTable);
   if (const auto parent =
           findFirst(node, "clangNestedNameSpecifier", src.ctxt)) {
     const auto prefix = ClangNestedNameSpecHandler.walk(parent, src);
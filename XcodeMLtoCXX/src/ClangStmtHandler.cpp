@@ -1,13 +1,16 @@
 #include <algorithm>
+#include <cctype>
 #include <functional>
 #include <memory>
 #include <map>
 #include <cassert>
 #include <vector>
+#include <stdexcept>
 #include <string>
 #include <libxml/tree.h>
 #include <libxml/xpath.h>
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Casting.h"
 #include "LibXMLUtil.h"
 #include "StringTree.h"
@@ -38,6 +41,7 @@ namespace cxxgen = CXXCodeGen;
 
 using cxxgen::makeInnerNode;
 using cxxgen::makeTokenNode;
+using cxxgen::Precedence;
 using XcodeMl::CodeFragment;
 
 namespace {
@@ -95,6 +99,10 @@ DEFINE_STMTHANDLER(callCodeBuilder) {
 DEFINE_STMTHANDLER(ArraySubscriptExprProc) {
   const auto array = createNode(node, "clangStmt[1]", w, src);
   const auto index = createNode(node, "clangStmt[2]", w, src);
+  if (src.minimalParens) {
+    return cxxgen::makeEnclosedOperand(array, Precedence::Postfix)
+        + wrapWithSquareBracket(cxxgen::makeOperand(index, Precedence::Comma));
+  }
   return wrapWithParen(array) + wrapWithSquareBracket(index);
 }
 
@@ -104,19 +112,31 @@ DEFINE_STMTHANDLER(BinaryConditionalOperatorProc) {
   return wrapWithParen(lhs + makeTokenNode("?:") + rhs);
 }
 
+CodeFragment
+makeBinaryOperator(xmlNodePtr node,
+    const CodeFragment &lhs,
+    const CodeFragment &rhs,
+    bool minimalParens) {
+  const auto opName = getProp(node, "binOpName");
+  const auto opSpelling = XcodeMl::OperatorNameToSpelling(opName);
+  if (!opSpelling.hasValue()) {
+    throw std::runtime_error("Unknown binary operator name: '" + opName
+        + "' at line " + std::to_string(xmlGetLineNo(node)));
+  }
+  const auto prec = XcodeMl::OperatorNameToPrecedence(opName);
+  if (!prec.hasValue()) {
+    return wrapWithParen(lhs + makeTokenNode(*opSpelling) + rhs);
+  }
+  return XcodeMl::makeBinaryOperation(
+      lhs, makeTokenNode(*opSpelling), rhs, *prec, minimalParens);
+}
+
 DEFINE_STMTHANDLER(BinaryOperatorProc) {
   const auto lhsNode = findFirst(node, "clangStmt[1]", src.ctxt);
   const auto lhs = w.walk(lhsNode, src);
   const auto rhsNode = findFirst(node, "clangStmt[2]", src.ctxt);
   const auto rhs = w.walk(rhsNode, src);
-
-  const auto opName = getProp(node, "binOpName");
-  const auto opSpelling = XcodeMl::OperatorNameToSpelling(opName);
-  if (!opSpelling.hasValue()) {
-    std::cerr << "Unknown Binary operator name: '" << opName << "'" << xmlGetLineNo(node)<< std::endl;
-    std::abort();
-  }
-  return wrapWithParen(lhs + makeTokenNode(*opSpelling) + rhs);
+  return makeBinaryOperator(node, lhs, rhs, src.minimalParens);
 }
 
 DEFINE_STMTHANDLER(BreakStmtProc) {
@@ -159,8 +179,16 @@ DEFINE_STMTHANDLER(ConditionalOperatorProc) {
   const auto cond = createNode(node, "clangStmt[1]", w, src);
   const auto yes = createNode(node, "clangStmt[2]", w, src);
   const auto no = createNode(node, "clangStmt[3]", w, src);
-  return wrapWithParen(
-      cond + makeTokenNode("?") + yes + makeTokenNode(":") + no);
+  if (!src.minimalParens) {
+    return cxxgen::makeOperationNode(
+        cond + makeTokenNode("?") + yes + makeTokenNode(":") + no,
+        Precedence::Assignment);
+  }
+  return cxxgen::makeOperationNode(
+      cxxgen::makeOperand(cond, Precedence::LogOr) + makeTokenNode("?")
+          + cxxgen::makeOperand(yes, Precedence::Comma) + makeTokenNode(":")
+          + cxxgen::makeOperand(no, Precedence::Assignment),
+      Precedence::Assignment);
 }
 
 DEFINE_STMTHANDLER(ContinueStmtProc) {
@@ -202,6 +230,24 @@ DEFINE_STMTHANDLER(CXXConstCastExprProc) {
       + makeTokenNode(">") + wrapWithParen(expr);
 }
 
+/*!
+ * \brief Returns the type of the functional cast `T(args)`, wrapped in
+ * __xcodeml_identity only if it has no simple-type-specifier or the
+ * name of the class is also the name of a variable or function.
+ */
+CodeFragment
+makeFunctionalCastType(const XcodeMl::TypeRef &T, SourceInfo &src) {
+  if (const auto spec =
+          XcodeMl::makeSimpleTypeSpecifier(T, src.typeTable, src.nnsTable)) {
+    const auto classT = llvm::dyn_cast<XcodeMl::ClassType>(T.get());
+    if (!classT || !src.isNonTypeName(CXXCodeGen::to_string(classT->name()))) {
+      return *spec;
+    }
+  }
+  return wrapWithXcodeMlIdentity(makeDecl(
+      T, CXXCodeGen::makeVoidNode(), src.typeTable, src.nnsTable));
+}
+
 DEFINE_STMTHANDLER(CXXCtorExprProc) {
   auto materializeExpr = findFirst(
       node, "clangStmt[@class='MaterializeTemporaryExpr']", src.ctxt);
@@ -215,12 +261,9 @@ DEFINE_STMTHANDLER(CXXCtorExprProc) {
     return w.walk(child, src);
   }
 
-  const auto T = makeDecl(src.typeTable.at(getType(node)),
-      CXXCodeGen::makeVoidNode(),
-      src.typeTable,
-      src.nnsTable);
+  const auto T = makeFunctionalCastType(src.typeTable.at(getType(node)), src);
   const auto exprs = createNodes(node, "clangStmt", w, src);
-  return wrapWithXcodeMlIdentity(T) + wrapWithParen(join(",", exprs));
+  return T + wrapWithParen(join(",", exprs));
 }
 
 DEFINE_STMTHANDLER(CXXDeleteExprProc) {
@@ -246,7 +289,9 @@ DEFINE_STMTHANDLER(emitNewArrayExpr) {
       llvm::cast<XcodeMl::Pointer>(T.get())->getPointee(src.typeTable);
   const auto NewTypeId = pointeeT->makeDeclaration(
       CXXCodeGen::makeVoidNode(), src.typeTable, src.nnsTable);
-  const auto type = wrapWithXcodeMlIdentity(NewTypeId);
+  const auto type = XcodeMl::isPlainTypeId(pointeeT, src.typeTable)
+      ? NewTypeId
+      : wrapWithXcodeMlIdentity(NewTypeId);
 
   const auto size = createNode(node, "clangStmt[1]", w, src);
 
@@ -296,7 +341,11 @@ DEFINE_STMTHANDLER(CXXNewExprProc) {
    * new int;            // OK
    * new (int);          // OK
    * new ((int));        // error
+   * so only the new-type-ids with parentheses go in __xcodeml_identity.
    */
+  const auto type = XcodeMl::isPlainTypeId(pointeeT, src.typeTable)
+      ? NewTypeId
+      : wrapWithXcodeMlIdentity(NewTypeId);
   if (isTrueProp(node, "has_initializer", false)) {
     // The first element is initializer
     const auto init = findFirst(node, "clangStmt[1]", src.ctxt);
@@ -308,8 +357,7 @@ DEFINE_STMTHANDLER(CXXNewExprProc) {
         : wrapWithParen(join(",", placementArgs));
 
     return (is_global ? makeTokenNode("::") : CXXCodeGen::makeVoidNode())
-        + makeTokenNode("new") + placementArgSequence
-        + wrapWithXcodeMlIdentity(NewTypeId)
+        + makeTokenNode("new") + placementArgSequence + type
         + wrapWithParen(join(",", w.walkChildren(init, src)));
   } else {
     const auto placementArgs = createNodes(node, "clangStmt", w, src);
@@ -317,8 +365,7 @@ DEFINE_STMTHANDLER(CXXNewExprProc) {
         ? CXXCodeGen::makeVoidNode()
         : wrapWithParen(join(",", placementArgs));
     return (is_global ? makeTokenNode("::") : CXXCodeGen::makeVoidNode())
-        + makeTokenNode("new") + placementArgSequence
-        + wrapWithXcodeMlIdentity(NewTypeId);
+        + makeTokenNode("new") + placementArgSequence + type;
   }
 }
 
@@ -420,10 +467,9 @@ DEFINE_STMTHANDLER(emitIntegerLiteral) {
 
 DEFINE_STMTHANDLER(CXXTemporaryObjectExprProc) {
   const auto resultT = src.typeTable.at(getType(node));
-  const auto name = makeDecl(
-      resultT, CXXCodeGen::makeVoidNode(), src.typeTable, src.nnsTable);
+  const auto name = makeFunctionalCastType(resultT, src);
   const auto args = createNodes(node, "clangStmt", w, src);
-  return wrapWithXcodeMlIdentity(name) + wrapWithParen(join(",", args));
+  return name + wrapWithParen(join(",", args));
 }
 
 DEFINE_STMTHANDLER(CXXOperatorCallExprProc) {
@@ -481,7 +527,35 @@ DEFINE_STMTHANDLER(IfStmtProc) {
   return head;
 }
 
+/*!
+ * \brief Spell the values of a packed <xcodemlLiteralList>, separated
+ * by whitespace, as a comma-separated list.
+ */
+CodeFragment
+makeLiteralList(xmlNodePtr node) {
+  const auto values = getContentRef(node);
+  std::string list;
+  list.reserve(values.size());
+  bool separated = false;
+  for (const char c : values) {
+    if (std::isspace(static_cast<unsigned char>(c))) {
+      separated = !list.empty();
+      continue;
+    }
+    if (separated) {
+      list += ',';
+      separated = false;
+    }
+    list += c;
+  }
+  return makeTokenNode(list);
+}
+
 DEFINE_STMTHANDLER(InitListExprProc) {
+  const auto first = xmlFirstElementChild(node);
+  if (first && xmlStrEqual(first->name, BAD_CAST "xcodemlLiteralList")) {
+    return wrapWithBrace(makeLiteralList(first));
+  }
   const auto members = createNodes(node, "clangStmt", w, src);
   return wrapWithBrace(join(",", members));
 }
@@ -525,7 +599,9 @@ DEFINE_STMTHANDLER(PackExpansionProc) {
 DEFINE_STMTHANDLER(ReturnStmtProc) {
   if (const auto exprNode = findFirst(node, "clangStmt", src.ctxt)) {
     const auto expr = w.walk(exprNode, src);
-    return makeTokenNode("return") + expr;
+    return makeTokenNode("return")
+        + (src.minimalParens ? cxxgen::makeOperand(expr, Precedence::Comma)
+                             : expr);
   }
   return makeTokenNode("return");
 }
@@ -549,19 +625,27 @@ DEFINE_STMTHANDLER(ThisExprProc) {
   return makeTokenNode("this");
 }
 
-DEFINE_STMTHANDLER(UnaryOperatorProc) {
-  const auto expr = createNode(node, "clangStmt", w, src);
-
+CodeFragment
+makeUnaryOperator(
+    xmlNodePtr node, const CodeFragment &expr, bool minimalParens) {
   const auto opName = getProp(node, "unaryOpName");
   const auto opSpelling = XcodeMl::OperatorNameToSpelling(opName);
   if (!opSpelling.hasValue()) {
-    std::cerr << "Unknown operator name: '" << opName << "'" << std::endl;
-    std::abort();
+    throw std::runtime_error("Unknown operator name: '" + opName + "'");
   }
   const auto op = makeTokenNode(*opSpelling);
   const auto postfix = std::equal(opName.begin(), opName.end(), "postDecrExpr")
       || std::equal(opName.begin(), opName.end(), "postIncrExpr");
-  return wrapWithParen(postfix ? expr + op : op + expr);
+  const auto prec = postfix ? Precedence::Postfix : Precedence::Unary;
+  const auto operand =
+      minimalParens ? cxxgen::makeOperand(expr, prec) : expr;
+  return cxxgen::makeOperationNode(
+      postfix ? operand + op : op + operand, prec);
+}
+
+DEFINE_STMTHANDLER(UnaryOperatorProc) {
+  const auto expr = createNode(node, "clangStmt", w, src);
+  return makeUnaryOperator(node, expr, src.minimalParens);
 }
 
 DEFINE_STMTHANDLER(WhileStmtProc) {
@@ -628,3 +712,57 @@ const ClangStmtHandlerType ClangStmtHandler("class",
         std::make_tuple("UnaryOperator", UnaryOperatorProc),
         std::make_tuple("WhileStmt", WhileStmtProc),
     });
+
+bool
+stageClangStmt(const CodeBuilder &w,
+    xmlNodePtr node,
+    CodeBuilder::Continuation &k,
+    SourceInfo &src) {
+  const auto className = getPropRefOrNull(node, "class");
+  if (!className.hasValue()) {
+    return false;
+  }
+  if (*className == "BinaryOperator"
+      || *className == "CompoundAssignOperator") {
+    k.operands = {findFirst(node, "clangStmt[1]", src.ctxt),
+        findFirst(node, "clangStmt[2]", src.ctxt)};
+    const bool minimalParens = src.minimalParens;
+    k.combine = [node, minimalParens](
+                    const std::vector<CodeFragment> &operands) {
+      return makeBinaryOperator(
+          node, operands[0], operands[1], minimalParens);
+    };
+    return true;
+  }
+  if (*className == "UnaryOperator") {
+    const auto exprNode = findFirst(node, "clangStmt", src.ctxt);
+    if (!exprNode) {
+      // let UnaryOperatorProc report the error
+      return false;
+    }
+    k.operands = {exprNode};
+    const bool minimalParens = src.minimalParens;
+    k.combine = [node, minimalParens](
+                    const std::vector<CodeFragment> &operands) {
+      return makeUnaryOperator(node, operands[0], minimalParens);
+    };
+    return true;
+  }
+  if (*className == "CompoundStmt") {
+    k.operands = findNodes(node, "clangStmt", src.ctxt);
+    k.combine = [](const std::vector<CodeFragment> &stmts) {
+      return wrapWithBrace(foldWithSemicolon(stmts));
+    };
+    return true;
+  }
+  if (&w == &ProgramBuilder && !ClangStmtHandler.hasProc(className->str())) {
+    // same as callCodeBuilder
+    for (xmlNodePtr cur = xmlFirstElementChild(node); cur;
+         cur = xmlNextElementSibling(cur)) {
+      k.operands.push_back(cur);
+    }
+    k.combine = cxxgen::makeInnerNode;
+    return true;
+  }
+  return false;
+}
@@ -6,4 +6,15 @@ using ClangStmtHandlerType =
 
 extern const ClangStmtHandlerType ClangStmtHandler;
 
+/*!
+ * \brief CodeBuilder::StagedProcedure for clangStmt elements.
+ *
+ * It handles operators, compound statements and statements left to
+ * the default procedure of ClangStmtHandler.
+ */
+bool stageClangStmt(const CodeBuilder &w,
+    xmlNodePtr node,
+    CodeBuilder::Continuation &k,
+    SourceInfo &src);
+
 #endif /* !CLANGCLASSHANDLER_H */
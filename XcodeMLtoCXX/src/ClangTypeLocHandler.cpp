@@ -7,6 +7,7 @@
 #include <libxml/tree.h>
 #include <libxml/xpath.h>
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
 
 #include "StringTree.h"
 #include "XcodeMlNns.h"
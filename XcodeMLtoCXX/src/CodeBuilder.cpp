@@ -2,6 +2,7 @@
 #include <functional>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <memory>
 #include <map>
 #include <cassert>
@@ -9,6 +10,7 @@
 #include <libxml/tree.h>
 #include <libxml/xpath.h>
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Casting.h"
 #include "XMLString.h"
 #include "XMLWalker.h"
@@ -31,6 +33,8 @@
 #include "ClangStmtHandler.h"
 #include "ClangTypeLocHandler.h"
 #include "LibXMLUtil.h"
+#include "FragmentCache.h"
+#include "OutputSplitter.h"
 
 namespace cxxgen = CXXCodeGen;
 
@@ -43,6 +47,7 @@ using cxxgen::makeVoidNode;
 using cxxgen::insertNewLines;
 using cxxgen::separateByBlankLines;
 using XcodeMl::makeOpNode;
+using cxxgen::Precedence;
 
 namespace {
 
@@ -53,13 +58,11 @@ makeNestedNameSpec(const XcodeMl::NnsRef &nns, const SourceInfo &src) {
 
 XcodeMl::CodeFragment
 makeNestedNameSpec(const std::string &ident, const SourceInfo &src) {
-  const auto nns = getOrNull(src.nnsTable, ident);
-  if (!nns.hasValue()) {
-    std::cerr << "In makeNestedNameSpec:" << std::endl
-              << "Undefined NNS: '" << ident << "'" << std::endl;
-    std::abort();
+  if (!src.nnsTable.exists(ident)) {
+    throw std::runtime_error("In makeNestedNameSpec: Undefined NNS: '"
+        + ident + "'");
   }
-  return makeNestedNameSpec(*nns, src);
+  return makeNestedNameSpec(src.nnsTable.at(ident), src);
 }
 
 std::vector<XcodeMl::CodeFragment>
@@ -88,6 +91,15 @@ createNodes(xmlNodePtr node,
  */
 #define DEFINE_CB(name) StringTreeRef name(CB_ARGS)
 
+/*!
+ * \brief Arguments to be passed to CodeBuilder::StagedProcedure.
+ */
+#define CB_STAGED_ARGS                                                        \
+  const CodeBuilder &w __attribute__((unused)),                               \
+      xmlNodePtr node __attribute__((unused)),                                \
+      CodeBuilder::Continuation &k __attribute__((unused)),                   \
+      SourceInfo &src __attribute__((unused))
+
 DEFINE_CB(NullProc) {
   return CXXCodeGen::makeVoidNode();
 }
@@ -100,82 +112,203 @@ DEFINE_CB(walkChildrenWithInsertingNewLines) {
   return foldWithSemicolon(w.walkChildren(node, src));
 }
 
-CodeBuilder::Procedure
-handleBrackets(std::string opening,
-    std::string closing,
-    CodeBuilder::Procedure mainProc) {
-  return [opening, closing, mainProc](CB_ARGS) {
-    return makeTokenNode(opening) + mainProc(w, node, src)
-        + makeTokenNode(closing);
-  };
+DEFINE_CB(EmptySNCProc) {
+  return makeTokenNode(getContentRef(node).str());
 }
 
-CodeBuilder::Procedure
-handleBracketsLn(std::string opening,
-    std::string closing,
-    CodeBuilder::Procedure mainProc) {
-  return [opening, closing, mainProc](CB_ARGS) {
-    return makeTokenNode(opening) + mainProc(w, node, src)
-        + makeTokenNode(closing) + makeNewLineNode();
-  };
-}
+/*
+ * The procedures below are composed at compile time: each of them is
+ * a stateless type whose parts are template arguments, and only the
+ * outermost one is type-erased when it is registered in a CodeBuilder.
+ * Their tokens are defined by CXXCODEGEN_DEFINE_TOKEN and interned.
+ */
 
 /*!
- * \brief Make a procedure that handles binary operation.
- * \param Operator Spelling of binary operator.
+ * \brief Procedure that calls the CodeBuilder::Procedure \c proc.
  */
-CodeBuilder::Procedure
-showBinOp(std::string Operator) {
-  return [Operator](CB_ARGS) {
-    xmlNodePtr lhs = findFirst(node, "*[1]", src.ctxt),
-               rhs = findFirst(node, "*[2]", src.ctxt);
-    return makeTokenNode("(") + w.walk(lhs, src) + makeTokenNode(Operator)
-        + w.walk(rhs, src) + makeTokenNode(")");
-  };
-}
+template <StringTreeRef (*proc)(CB_ARGS)>
+struct Call {
+  StringTreeRef
+  operator()(CB_ARGS) const {
+    return proc(w, node, src);
+  }
+};
+
+/*!
+ * \brief Procedure that outputs \c Opening, the code generated by
+ * \c MainProc and \c Closing.
+ */
+template <typename Opening, typename MainProc, typename Closing>
+struct HandleBrackets {
+  StringTreeRef
+  operator()(CB_ARGS) const {
+    return cxxgen::makeInternedTokenNode<Opening>() + MainProc()(w, node, src)
+        + cxxgen::makeInternedTokenNode<Closing>();
+  }
+};
 
-const CodeBuilder::Procedure EmptySNCProc = [](
-    CB_ARGS) { return makeTokenNode(XMLString(xmlNodeGetContent(node))); };
+/*!
+ * \brief HandleBrackets followed by a line break.
+ */
+template <typename Opening, typename MainProc, typename Closing>
+struct HandleBracketsLn {
+  StringTreeRef
+  operator()(CB_ARGS) const {
+    return HandleBrackets<Opening, MainProc, Closing>()(w, node, src)
+        + makeNewLineNode();
+  }
+};
 
 /*!
- * \brief Make a procedure that outputs text content of a given
- * XML element.
- * \param prefix Text to output before text content.
- * \param suffix Text to output after text content.
+ * \brief Make the code of the prefix operation \c Operator \c operand.
+ * \param typeOperand Whether \c operand may be a type, which must stay
+ * in parentheses.
  */
-CodeBuilder::Procedure
-showNodeContent(std::string prefix, std::string suffix) {
-  return handleBrackets(prefix, suffix, EmptySNCProc);
+template <typename Operator, bool typeOperand>
+StringTreeRef
+makePrefixOperation(const StringTreeRef &operand, bool minimalParens) {
+  const auto arg = minimalParens && !typeOperand
+      ? cxxgen::makeEnclosedOperand(operand, Precedence::Unary)
+      : wrapWithParen(operand);
+  return cxxgen::makeOperationNode(
+      cxxgen::makeInternedTokenNode<Operator>() + arg,
+      Precedence::Unary);
 }
 
 /*!
- * \brief Make a procedure that processes the first child element of
+ * \brief Make a staged procedure that handles binary operation.
+ * \param Operator Token of binary operator.
+ * \param prec Precedence of \c Operator.
+ */
+template <typename Operator, Precedence prec>
+struct StageBinOp {
+  bool
+  operator()(CB_STAGED_ARGS) const {
+    k.operands = {findFirst(node, "*[1]", src.ctxt),
+        findFirst(node, "*[2]", src.ctxt)};
+    const bool minimalParens = src.minimalParens;
+    k.combine = [minimalParens](const std::vector<StringTreeRef> &operands) {
+      return XcodeMl::makeBinaryOperation(operands[0],
+          cxxgen::makeInternedTokenNode<Operator>(),
+          operands[1],
+          prec,
+          minimalParens);
+    };
+    return true;
+  }
+};
+
+/*!
+ * \brief Procedure that outputs text content of a given XML element.
+ * \param Prefix Token to output before text content.
+ * \param Suffix Token to output after text content.
+ */
+template <typename Prefix, typename Suffix>
+using ShowNodeContent = HandleBrackets<Prefix, Call<EmptySNCProc>, Suffix>;
+
+/*!
+ * \brief Procedure that processes the first child element of
  * a given XML element (At least one element should exist in it).
- * \param prefix Text to output before traversing descendant elements.
- * \param suffix Text to output after traversing descendant elements.
+ * \param Prefix Token to output before traversing descendant elements.
+ * \param Suffix Token to output after traversing descendant elements.
  */
-CodeBuilder::Procedure
-showChildElem(std::string prefix, std::string suffix) {
-  return handleBrackets(prefix, suffix, EmptyProc);
-}
+template <typename Prefix, typename Suffix>
+using ShowChildElem = HandleBrackets<Prefix, Call<EmptyProc>, Suffix>;
 
 /*!
- * \brief Make a procedure that handles unary operation.
- * \param Operator Spelling of unary operator.
+ * \brief Procedure that handles unary operation.
+ * \param Operator Token of unary operator.
  */
-CodeBuilder::Procedure
-showUnaryOp(std::string Operator) {
-  return showChildElem(std::string("(") + Operator + "(", "))");
+template <typename Operator>
+struct ShowUnaryOp {
+  StringTreeRef
+  operator()(CB_ARGS) const {
+    return makePrefixOperation<Operator, false>(
+        makeInnerNode(w.walkChildren(node, src)), src.minimalParens);
+  }
+};
+
+/*!
+ * \brief Make a staged procedure that handles unary operation.
+ * \param Operator Token of unary operator.
+ * \param typeOperand Whether the operand may be a type.
+ */
+template <typename Operator, bool typeOperand = false>
+struct StageUnaryOp {
+  bool
+  operator()(CB_STAGED_ARGS) const {
+    k.operands = findNodes(node, "*", src.ctxt);
+    const bool minimalParens = src.minimalParens;
+    k.combine = [minimalParens](const std::vector<StringTreeRef> &operands) {
+      return makePrefixOperation<Operator, typeOperand>(
+          makeInnerNode(operands), minimalParens);
+    };
+    return true;
+  }
+};
+
+/* Operator tokens of the expressions in ProgramBuilder */
+CXXCODEGEN_DEFINE_TOKEN(AddrOfExprOp, "&");
+CXXCODEGEN_DEFINE_TOKEN(PointerRefOp, "*");
+CXXCODEGEN_DEFINE_TOKEN(AssignExprOp, " = ");
+CXXCODEGEN_DEFINE_TOKEN(PlusExprOp, " + ");
+CXXCODEGEN_DEFINE_TOKEN(MinusExprOp, " - ");
+CXXCODEGEN_DEFINE_TOKEN(MulExprOp, " * ");
+CXXCODEGEN_DEFINE_TOKEN(DivExprOp, " / ");
+CXXCODEGEN_DEFINE_TOKEN(ModExprOp, " % ");
+CXXCODEGEN_DEFINE_TOKEN(LshiftExprOp, " << ");
+CXXCODEGEN_DEFINE_TOKEN(RshiftExprOp, " >> ");
+CXXCODEGEN_DEFINE_TOKEN(LogLTExprOp, " < ");
+CXXCODEGEN_DEFINE_TOKEN(LogGTExprOp, " > ");
+CXXCODEGEN_DEFINE_TOKEN(LogLEExprOp, " <= ");
+CXXCODEGEN_DEFINE_TOKEN(LogGEExprOp, " >= ");
+CXXCODEGEN_DEFINE_TOKEN(LogEQExprOp, " == ");
+CXXCODEGEN_DEFINE_TOKEN(LogNEQExprOp, " != ");
+CXXCODEGEN_DEFINE_TOKEN(BitAndExprOp, " & ");
+CXXCODEGEN_DEFINE_TOKEN(BitXorExprOp, " ^ ");
+CXXCODEGEN_DEFINE_TOKEN(BitOrExprOp, " | ");
+CXXCODEGEN_DEFINE_TOKEN(LogAndExprOp, " && ");
+CXXCODEGEN_DEFINE_TOKEN(LogOrExprOp, " || ");
+CXXCODEGEN_DEFINE_TOKEN(AsgMulExprOp, " *= ");
+CXXCODEGEN_DEFINE_TOKEN(AsgDivExprOp, " /= ");
+CXXCODEGEN_DEFINE_TOKEN(AsgPlusExprOp, " += ");
+CXXCODEGEN_DEFINE_TOKEN(AsgMinusExprOp, " -= ");
+CXXCODEGEN_DEFINE_TOKEN(AsgLshiftExprOp, " <<= ");
+CXXCODEGEN_DEFINE_TOKEN(AsgRshiftExprOp, " >>= ");
+CXXCODEGEN_DEFINE_TOKEN(AsgBitAndExprOp, " &= ");
+CXXCODEGEN_DEFINE_TOKEN(AsgBitOrExprOp, " |= ");
+CXXCODEGEN_DEFINE_TOKEN(AsgBitXorExprOp, " ^= ");
+CXXCODEGEN_DEFINE_TOKEN(UnaryPlusExprOp, "+");
+CXXCODEGEN_DEFINE_TOKEN(UnaryMinusExprOp, "-");
+CXXCODEGEN_DEFINE_TOKEN(PreIncrExprOp, "++");
+CXXCODEGEN_DEFINE_TOKEN(PreDecrExprOp, "--");
+CXXCODEGEN_DEFINE_TOKEN(BitNotExprOp, "~");
+CXXCODEGEN_DEFINE_TOKEN(LogNotExprOp, "!");
+CXXCODEGEN_DEFINE_TOKEN(SizeOfExprOp, "sizeof");
+CXXCODEGEN_DEFINE_TOKEN(Quote, "\"");
+CXXCODEGEN_DEFINE_TOKEN(VarAddrOpening, "(&");
+
+/*!
+ * \brief Make the code of the postfix operation \c operand \c op.
+ */
+StringTreeRef
+makePostfixOperation(
+    const StringTreeRef &operand, const char *op, const SourceInfo &src) {
+  const auto arg = src.minimalParens
+      ? cxxgen::makeOperand(operand, Precedence::Postfix)
+      : operand;
+  return cxxgen::makeOperationNode(
+      arg + makeTokenNode(op), Precedence::Postfix);
 }
 
 DEFINE_CB(postIncrExprProc) {
-  return makeTokenNode("(") + makeInnerNode(w.walkChildren(node, src))
-      + makeTokenNode("++)");
+  return makePostfixOperation(
+      makeInnerNode(w.walkChildren(node, src)), "++", src);
 }
 
 DEFINE_CB(postDecrExprProc) {
-  return makeTokenNode("(") + makeInnerNode(w.walkChildren(node, src))
-      + makeTokenNode("--)");
+  return makePostfixOperation(
+      makeInnerNode(w.walkChildren(node, src)), "--", src);
 }
 
 DEFINE_CB(castExprProc) {
@@ -183,17 +316,38 @@ DEFINE_CB(castExprProc) {
   const auto Tstr = makeDecl(
       src.typeTable.at(dtident), makeVoidNode(), src.typeTable, src.nnsTable);
   const auto child = makeInnerNode(w.walkChildren(node, src));
-  return wrapWithParen(wrapWithParen(Tstr) + wrapWithParen(child));
+  const auto operand = src.minimalParens
+      ? cxxgen::makeEnclosedOperand(child, Precedence::Unary)
+      : wrapWithParen(child);
+  return cxxgen::makeOperationNode(
+      wrapWithParen(Tstr) + operand, Precedence::Unary);
 }
 
-CodeBuilder::Procedure
-handleIndentation(const CodeBuilder::Procedure mainProc) {
-  return [mainProc](CB_ARGS) { return mainProc(w, node, src); };
+template <typename MainProc>
+struct HandleIndentation {
+  StringTreeRef
+  operator()(CB_ARGS) const {
+    return MainProc()(w, node, src);
+  }
+};
+
+const HandleBracketsLn<cxxgen::token::LBrace,
+    HandleIndentation<Call<walkChildrenWithInsertingNewLines>>,
+    cxxgen::token::RBrace>
+    handleScope = {};
+
+bool
+stageScope(CB_STAGED_ARGS) {
+  k.operands = findNodes(node, "*", src.ctxt);
+  k.combine = [](const std::vector<StringTreeRef> &stmts) {
+    return cxxgen::makeInternedTokenNode<cxxgen::token::LBrace>()
+        + foldWithSemicolon(stmts)
+        + cxxgen::makeInternedTokenNode<cxxgen::token::RBrace>()
+        + makeNewLineNode();
+  };
+  return true;
 }
 
-const CodeBuilder::Procedure handleScope = handleBracketsLn(
-    "{", "}", handleIndentation(walkChildrenWithInsertingNewLines));
-
 DEFINE_CB(functionDefinitionProc) {
   const auto paramNames = getParamNames(node, src);
   auto acc = makeFunctionDeclHead(node, paramNames, src, true);
@@ -204,7 +358,10 @@ DEFINE_CB(functionDefinitionProc) {
   }
 
   auto body = findFirst(node, "body", src.ctxt);
-  assert(body);
+  if (!body) {
+    throw std::runtime_error(
+        "body not found at " + to_string(getXcodeMlPath(node)));
+  }
   acc = acc + makeTokenNode("{") + makeNewLineNode();
   acc = acc + w.walk(body, src);
   acc = acc + makeTokenNode("}");
@@ -246,7 +403,10 @@ DEFINE_CB(emitInlineMemberFunctionDefinition) {
   }
 
   auto body = findFirst(node, "body", src.ctxt);
-  assert(body);
+  if (!body) {
+    throw std::runtime_error(
+        "body not found at " + to_string(getXcodeMlPath(node)));
+  }
   acc = acc + makeTokenNode("{");
   acc = acc + ProgramBuilder.walk(body, src);
   acc = acc + makeTokenNode("}");
@@ -277,7 +437,7 @@ getNameFromMemberRefNode(xmlNodePtr node, const SourceInfo &src) {
   /* If the <memberRef> element has two children, use the second child. */
   const auto memberName = findFirst(node, "name", src.ctxt);
   if (memberName) {
-    const auto name = getUnqualIdFromNameNode(memberName);
+    const auto name = getUnqualIdFromNameNode(memberName, src);
     return name->toString(src.typeTable, src.nnsTable);
   }
   /* Otherwise, it must have `member` attribute. */
@@ -315,8 +475,6 @@ DEFINE_CB(arrayRefExprProc) {
       + makeTokenNode("]");
 }
 
-const auto compoundStatementProc = handleScope;
-
 DEFINE_CB(whileStatementProc) {
   auto cond = findFirst(node, "condition", src.ctxt),
        body = findFirst(node, "body", src.ctxt);
@@ -401,8 +559,8 @@ DEFINE_CB(returnStatementProc) {
 }
 
 DEFINE_CB(exprStatementProc) {
-  const auto showChild = showChildElem("", ";");
-  return showChild(w, node, src);
+  return ShowChildElem<cxxgen::token::Empty, cxxgen::token::Semicolon>()(
+      w, node, src);
 }
 
 DEFINE_CB(functionCallProc) {
@@ -415,9 +573,8 @@ DEFINE_CB(functionCallProc) {
 
   xmlNodePtr function = findFirst(node, "function|memberFunction", src.ctxt);
   if (!function) {
-    std::cerr << "error: callee not found" << getXcodeMlPath(node)
-              << std::endl;
-    std::abort();
+    throw std::runtime_error(
+        "callee not found at " + to_string(getXcodeMlPath(node)));
   }
   const auto callee = findFirst(function, "*", src.ctxt);
   return w.walk(callee, src) + w.walk(arguments, src);
@@ -509,8 +666,7 @@ DEFINE_CB(addrOfExprProc) {
     auto expr = findFirst(node, "*[1]", src.ctxt);
     return w.walk(expr, src);
   }
-  const auto wrap = showUnaryOp("&");
-  return wrap(w, node, src);
+  return ShowUnaryOp<AddrOfExprOp>()(w, node, src);
 }
 
 } // namespace
@@ -540,7 +696,7 @@ namespace {
 
 DEFINE_CB(varDeclProc) {
   const auto nameNode = findFirst(node, "name", src.ctxt);
-  const auto name = getUnqualIdFromNameNode(nameNode);
+  const auto name = getUnqualIdFromNameNode(nameNode, src);
 
   const auto dtident = getProp(node, "type");
   const auto type = src.typeTable.at(dtident);
@@ -569,7 +725,7 @@ DEFINE_CB(varDeclProc) {
 
 DEFINE_CB(emitDataMemberDecl) {
   const auto nameNode = findFirst(node, "name", src.ctxt);
-  const auto name = getUnqualIdFromNameNode(nameNode);
+  const auto name = getUnqualIdFromNameNode(nameNode, src);
 
   const auto dtident = getProp(node, "type");
   const auto type = src.typeTable.at(dtident);
@@ -674,15 +830,13 @@ const CodeBuilder ProgramBuilder("ProgramBuilder",
         std::make_tuple("moeConstant", EmptySNCProc),
         std::make_tuple("booleanConstant", EmptySNCProc),
         std::make_tuple("funcAddr", EmptySNCProc),
-        std::make_tuple("stringConstant", showNodeContent("\"", "\"")),
+        std::make_tuple("stringConstant", ShowNodeContent<Quote, Quote>()),
         std::make_tuple("Var", varProc),
-        std::make_tuple("varAddr", showNodeContent("(&", ")")),
-        std::make_tuple("pointerRef", showUnaryOp("*")),
+        std::make_tuple("varAddr", ShowNodeContent<VarAddrOpening, cxxgen::token::RParen>()),
         std::make_tuple("memberRef", memberRefProc),
         std::make_tuple("memberAddr", memberAddrProc),
         std::make_tuple("memberPointerRef", memberPointerRefProc),
         std::make_tuple("compoundValue", compoundValueProc),
-        std::make_tuple("compoundStatement", compoundStatementProc),
         std::make_tuple("whileStatement", whileStatementProc),
         std::make_tuple("doStatement", doStatementProc),
         std::make_tuple("forStatement", forStatementProc),
@@ -692,46 +846,10 @@ const CodeBuilder ProgramBuilder("ProgramBuilder",
         std::make_tuple("defaultLabel", defaultLabelProc),
         std::make_tuple("thisExpr", thisExprProc),
         std::make_tuple("arrayRef", arrayRefExprProc),
-        std::make_tuple("assignExpr", showBinOp(" = ")),
-        std::make_tuple("plusExpr", showBinOp(" + ")),
-        std::make_tuple("minusExpr", showBinOp(" - ")),
-        std::make_tuple("mulExpr", showBinOp(" * ")),
-        std::make_tuple("divExpr", showBinOp(" / ")),
-        std::make_tuple("modExpr", showBinOp(" % ")),
-        std::make_tuple("LshiftExpr", showBinOp(" << ")),
-        std::make_tuple("RshiftExpr", showBinOp(" >> ")),
-        std::make_tuple("logLTExpr", showBinOp(" < ")),
-        std::make_tuple("logGTExpr", showBinOp(" > ")),
-        std::make_tuple("logLEExpr", showBinOp(" <= ")),
-        std::make_tuple("logGEExpr", showBinOp(" >= ")),
-        std::make_tuple("logEQExpr", showBinOp(" == ")),
-        std::make_tuple("logNEQExpr", showBinOp(" != ")),
-        std::make_tuple("bitAndExpr", showBinOp(" & ")),
-        std::make_tuple("bitXorExpr", showBinOp(" ^ ")),
-        std::make_tuple("bitOrExpr", showBinOp(" | ")),
-        std::make_tuple("logAndExpr", showBinOp(" && ")),
-        std::make_tuple("logOrExpr", showBinOp(" || ")),
-        std::make_tuple("asgMulExpr", showBinOp(" *= ")),
-        std::make_tuple("asgDivExpr", showBinOp(" /= ")),
-        std::make_tuple("asgPlusExpr", showBinOp(" += ")),
-        std::make_tuple("asgMinusExpr", showBinOp(" -= ")),
-        std::make_tuple("asgLshiftExpr", showBinOp(" <<= ")),
-        std::make_tuple("asgRshiftExpr", showBinOp(" >>= ")),
-        std::make_tuple("asgBitAndExpr", showBinOp(" &= ")),
-        std::make_tuple("asgBitOrExpr", showBinOp(" |= ")),
-        std::make_tuple("asgBitXorExpr", showBinOp(" ^= ")),
-        std::make_tuple("unaryPlusExpr", showUnaryOp("+")),
-        std::make_tuple("unaryMinusExpr", showUnaryOp("-")),
-        std::make_tuple("preIncrExpr", showUnaryOp("++")),
-        std::make_tuple("preDecrExpr", showUnaryOp("--")),
         std::make_tuple("postIncrExpr", postIncrExprProc),
         std::make_tuple("postDecrExpr", postDecrExprProc),
         std::make_tuple("castExpr", castExprProc),
         std::make_tuple("AddrOfExpr", addrOfExprProc),
-        std::make_tuple("pointerRef", showUnaryOp("*")),
-        std::make_tuple("bitNotExpr", showUnaryOp("~")),
-        std::make_tuple("logNotExpr", showUnaryOp("!")),
-        std::make_tuple("sizeOfExpr", showUnaryOp("sizeof")),
         std::make_tuple("newExpr", newExprProc),
         std::make_tuple("newArrayExpr", newArrayExprProc),
         std::make_tuple("functionCall", functionCallProc),
@@ -757,6 +875,76 @@ const CodeBuilder ProgramBuilder("ProgramBuilder",
         /* for CtoXcodeML */
         std::make_tuple("Decl_Record", NullProc),
         // Ignore Decl_Record (structs are already emitted)
+    },
+    {
+        std::make_tuple("compoundStatement", stageScope),
+        std::make_tuple("pointerRef", StageUnaryOp<PointerRefOp>()),
+        std::make_tuple("assignExpr",
+            StageBinOp<AssignExprOp, Precedence::Assignment>()),
+        std::make_tuple("plusExpr",
+            StageBinOp<PlusExprOp, Precedence::Additive>()),
+        std::make_tuple("minusExpr",
+            StageBinOp<MinusExprOp, Precedence::Additive>()),
+        std::make_tuple("mulExpr",
+            StageBinOp<MulExprOp, Precedence::Multiplicative>()),
+        std::make_tuple("divExpr",
+            StageBinOp<DivExprOp, Precedence::Multiplicative>()),
+        std::make_tuple("modExpr",
+            StageBinOp<ModExprOp, Precedence::Multiplicative>()),
+        std::make_tuple("LshiftExpr",
+            StageBinOp<LshiftExprOp, Precedence::Shift>()),
+        std::make_tuple("RshiftExpr",
+            StageBinOp<RshiftExprOp, Precedence::Shift>()),
+        std::make_tuple("logLTExpr",
+            StageBinOp<LogLTExprOp, Precedence::Relational>()),
+        std::make_tuple("logGTExpr",
+            StageBinOp<LogGTExprOp, Precedence::Relational>()),
+        std::make_tuple("logLEExpr",
+            StageBinOp<LogLEExprOp, Precedence::Relational>()),
+        std::make_tuple("logGEExpr",
+            StageBinOp<LogGEExprOp, Precedence::Relational>()),
+        std::make_tuple("logEQExpr",
+            StageBinOp<LogEQExprOp, Precedence::Equality>()),
+        std::make_tuple("logNEQExpr",
+            StageBinOp<LogNEQExprOp, Precedence::Equality>()),
+        std::make_tuple("bitAndExpr",
+            StageBinOp<BitAndExprOp, Precedence::BitAnd>()),
+        std::make_tuple("bitXorExpr",
+            StageBinOp<BitXorExprOp, Precedence::BitXor>()),
+        std::make_tuple("bitOrExpr",
+            StageBinOp<BitOrExprOp, Precedence::BitOr>()),
+        std::make_tuple("logAndExpr",
+            StageBinOp<LogAndExprOp, Precedence::LogAnd>()),
+        std::make_tuple("logOrExpr",
+            StageBinOp<LogOrExprOp, Precedence::LogOr>()),
+        std::make_tuple("asgMulExpr",
+            StageBinOp<AsgMulExprOp, Precedence::Assignment>()),
+        std::make_tuple("asgDivExpr",
+            StageBinOp<AsgDivExprOp, Precedence::Assignment>()),
+        std::make_tuple("asgPlusExpr",
+            StageBinOp<AsgPlusExprOp, Precedence::Assignment>()),
+        std::make_tuple("asgMinusExpr",
+            StageBinOp<AsgMinusExprOp, Precedence::Assignment>()),
+        std::make_tuple("asgLshiftExpr",
+            StageBinOp<AsgLshiftExprOp, Precedence::Assignment>()),
+        std::make_tuple("asgRshiftExpr",
+            StageBinOp<AsgRshiftExprOp, Precedence::Assignment>()),
+        std::make_tuple("asgBitAndExpr",
+            StageBinOp<AsgBitAndExprOp, Precedence::Assignment>()),
+        std::make_tuple("asgBitOrExpr",
+            StageBinOp<AsgBitOrExprOp, Precedence::Assignment>()),
+        std::make_tuple("asgBitXorExpr",
+            StageBinOp<AsgBitXorExprOp, Precedence::Assignment>()),
+        std::make_tuple("unaryPlusExpr", StageUnaryOp<UnaryPlusExprOp>()),
+        std::make_tuple("unaryMinusExpr", StageUnaryOp<UnaryMinusExprOp>()),
+        std::make_tuple("preIncrExpr", StageUnaryOp<PreIncrExprOp>()),
+        std::make_tuple("preDecrExpr", StageUnaryOp<PreDecrExprOp>()),
+        std::make_tuple("bitNotExpr", StageUnaryOp<BitNotExprOp>()),
+        std::make_tuple("logNotExpr", StageUnaryOp<LogNotExprOp>()),
+        std::make_tuple("sizeOfExpr", StageUnaryOp<SizeOfExprOp, true>()),
+
+        /* for elements defined by clang */
+        std::make_tuple("clangStmt", stageClangStmt),
     });
 
 namespace {
@@ -798,8 +986,11 @@ const CodeBuilder ClassDefinitionBuilder("ClassDefinitionBuilder",
 namespace {
 
 void
-readXcodeProgram(
-    xmlNodePtr rootNode, xmlXPathContextPtr ctxt, std::stringstream &ss) {
+readXcodeProgram(xmlNodePtr rootNode,
+    xmlXPathContextPtr ctxt,
+    std::stringstream &ss,
+    const FragmentCache *cache,
+    bool minimalParens) {
   xmlNodePtr typeTableNode =
       findFirst(rootNode, "/XcodeProgram/typeTable", ctxt);
   xmlNodePtr nnsTableNode =
@@ -808,19 +999,48 @@ readXcodeProgram(
       parseTypeTable(typeTableNode, ctxt, ss),
       analyzeNnsTable(nnsTableNode, ctxt),
       getSourceLanguage(rootNode, ctxt));
+  src.fragmentCache = cache;
+  src.minimalParens = minimalParens;
 
   cxxgen::Stream out;
   xmlNodePtr globalDeclarations =
       findFirst(rootNode, "/XcodeProgram/globalDeclarations", src.ctxt);
-  separateByBlankLines(ProgramBuilder.walkChildren(globalDeclarations, src))
-      ->flush(out);
+  std::vector<StringTreeRef> decls;
+  for (xmlNodePtr declNode = xmlFirstElementChild(globalDeclarations);
+       declNode;
+       declNode = xmlNextElementSibling(declNode)) {
+    decls.push_back(walkWithFragmentCache(ProgramBuilder, declNode, src));
+  }
+  separateByBlankLines(decls)->flush(out);
 
   ss << out.str();
 }
 
+bool
+usesXcodeMlIdentity(const std::string &code, const OutputSplitter *splitter) {
+  const std::string identity = "__xcodeml_identity<";
+  if (code.find(identity) != std::string::npos) {
+    return true;
+  }
+  if (!splitter) {
+    return false;
+  }
+  const auto &units = splitter->getUnits();
+  return std::any_of(
+      units.begin(), units.end(), [&identity](const std::string &unit) {
+        return unit.find(identity) != std::string::npos;
+      });
+}
+
 void
-readClangAST(
-    xmlNodePtr rootNode, xmlXPathContextPtr ctxt, std::stringstream &ss) {
+readClangAST(xmlNodePtr rootNode,
+    xmlXPathContextPtr ctxt,
+    std::stringstream &ss,
+    const FragmentCache *cache,
+    OutputSplitter *splitter,
+    bool minimalParens,
+    bool sourcePositions,
+    DependencyGraph *dependencyGraph) {
   xmlNodePtr typeTableNode =
       findFirst(rootNode, "/clangAST/clangDecl/xcodemlTypeTable", ctxt);
   xmlNodePtr nnsTableNode =
@@ -829,18 +1049,27 @@ readClangAST(
       parseTypeTable(typeTableNode, ctxt, ss),
       analyzeNnsTable(nnsTableNode, ctxt),
       getSourceLanguage(rootNode, ctxt));
+  src.fragmentCache = cache;
+  src.outputSplitter = splitter;
+  src.minimalParens = minimalParens;
+  src.sourcePositions = sourcePositions;
+  src.dependencyGraph = dependencyGraph;
 
   cxxgen::Stream out;
-  if (src.language == Language::CPlusPlus) {
-    out << "template<typename T>"
-           "struct __xcodeml_identity { typedef T t; };"
-        << CXXCodeGen::newline;
-  }
   xmlNodePtr decl = findFirst(rootNode, "/clangAST/clangDecl", src.ctxt);
   const auto program = ClangDeclHandler.walk(decl, ProgramBuilder, src);
   program->flush(out);
 
-  ss << out.str();
+  // The declarators that cannot be spelled plainly go through
+  // __xcodeml_identity; define it only if some code refers to it.
+  const auto code = out.str();
+  if (src.language == Language::CPlusPlus
+      && usesXcodeMlIdentity(code, splitter)) {
+    ss << "template<typename T>"
+          "struct __xcodeml_identity { typedef T t; };"
+       << std::endl;
+  }
+  ss << code;
 }
 
 } // namespace
@@ -849,18 +1078,49 @@ readClangAST(
  * \brief Traverse an XcodeML document and generate C++ source code.
  * \param[in] doc XcodeML document.
  * \param[out] ss Stringstream to flush C++ source code.
+ * \param[in] cache Cache of generated declarations, or nullptr.
+ * \param[out] splitter Translation units to move the non-inline
+ * definitions into, or nullptr. \c ss receives the rest of the code,
+ * which is to be included by every unit.
+ * \param[in] minimalParens Whether to put operands in parentheses only
+ * where the precedence of the operators requires it.
+ * \param[in] sourcePositions Whether to precede the declarations of a
+ * clangAST document with `#line` directives giving their positions in
+ * the original source.
+ * \param[out] dependencyGraph Graph to record the dependencies of the
+ * declarations of a clangAST document in, or nullptr.
  */
 void
-buildCode(
-    xmlNodePtr rootNode, xmlXPathContextPtr ctxt, std::stringstream &ss) {
+buildCode(xmlNodePtr rootNode,
+    xmlXPathContextPtr ctxt,
+    std::stringstream &ss,
+    const FragmentCache *cache,
+    OutputSplitter *splitter,
+    bool minimalParens,
+    bool sourcePositions,
+    DependencyGraph *dependencyGraph) {
   const auto docType = getName(rootNode);
   if (std::equal(docType.cbegin(), docType.cend(), "XcodeProgram")) {
-    readXcodeProgram(rootNode, ctxt, ss);
+    if (splitter) {
+      throw std::runtime_error(
+          "XcodeProgram documents cannot be split into translation units");
+    }
+    if (dependencyGraph) {
+      throw std::runtime_error(
+          "XcodeProgram documents have no dependency graph");
+    }
+    readXcodeProgram(rootNode, ctxt, ss, cache, minimalParens);
     return;
   } else if (std::equal(docType.cbegin(), docType.cend(), "clangAST")) {
-    readClangAST(rootNode, ctxt, ss);
+    readClangAST(rootNode,
+        ctxt,
+        ss,
+        cache,
+        splitter,
+        minimalParens,
+        sourcePositions,
+        dependencyGraph);
   } else {
-    std::cerr << "error: unknown document type" << std::endl;
-    std::abort();
+    throw std::runtime_error("error: unknown document type");
   }
 }
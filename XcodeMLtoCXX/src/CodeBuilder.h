@@ -1,6 +1,10 @@
 #ifndef CODEBUILDER_H
 #define CODEBUILDER_H
 
+class DependencyGraph;
+class FragmentCache;
+class OutputSplitter;
+
 using CodeBuilder = XMLWalker<CXXCodeGen::StringTreeRef, SourceInfo &>;
 
 extern CodeBuilder const ProgramBuilder;
@@ -10,6 +14,13 @@ extern CodeBuilder const ClassDefinitionBuilder;
 XcodeMl::CodeFragment declareClassTypeInit(
     const CodeBuilder &, xmlNodePtr ctorExpr, SourceInfo &src);
 
-void buildCode(xmlNodePtr, xmlXPathContextPtr, std::stringstream &);
+void buildCode(xmlNodePtr,
+    xmlXPathContextPtr,
+    std::stringstream &,
+    const FragmentCache *cache = nullptr,
+    OutputSplitter *splitter = nullptr,
+    bool minimalParens = false,
+    bool sourcePositions = false,
+    DependencyGraph *dependencyGraph = nullptr);
 
 #endif /* !CODEBUILDER_H */
@@ -0,0 +1,179 @@
+#include <map>
+#include <memory>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+#include <libxml/tree.h>
+#include <libxml/xpath.h>
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
+#include "LibXMLUtil.h"
+#include "StringTree.h"
+#include "XcodeMlNns.h"
+#include "XcodeMlName.h"
+#include "XcodeMlType.h"
+#include "XcodeMlTypeTable.h"
+#include "XcodeMlUtil.h"
+#include "SourceInfo.h"
+#include "DependencyGraph.h"
+
+namespace {
+
+/*!
+ * \brief Returns the names of the namespaces enclosing \c node,
+ * outermost first, each followed by `::`.
+ */
+std::string
+getNamespacePrefix(xmlNodePtr node, xmlXPathContextPtr ctxt) {
+  std::string prefix;
+  for (auto cur = node->parent; cur; cur = cur->parent) {
+    if (cur->type != XML_ELEMENT_NODE || getName(cur) != "clangDecl") {
+      continue;
+    }
+    const auto className = getPropOrNull(cur, "class");
+    if (!className.hasValue() || *className != "Namespace") {
+      continue;
+    }
+    const auto nameNode = findFirst(cur, "name", ctxt);
+    const auto name = nameNode ? getContent(nameNode) : std::string();
+    prefix = (name.empty() ? "(anonymous namespace)" : name) + "::" + prefix;
+  }
+  return prefix;
+}
+
+} // namespace
+
+DependencyGraph::DependencyGraph()
+    : decls(), declsByName(), tableEdges(), indexed(false) {
+}
+
+void
+DependencyGraph::indexTables(xmlNodePtr node, const SourceInfo &src) {
+  if (indexed) {
+    return;
+  }
+  indexed = true;
+  const auto root = xmlDocGetRootElement(node->doc);
+  const auto typeDefs = findNodes(root,
+      "//xcodemlTypeTable/*[@type] | //typeTable/*[@type]",
+      src.ctxt);
+  const auto nnsDefs = findNodes(
+      root, "//xcodemlNnsTable/*[@nns] | //nnsTable/*[@nns]", src.ctxt);
+  for (auto &&def : typeDefs) {
+    tableEdges[getProp(def, "type")];
+  }
+  for (auto &&def : nnsDefs) {
+    tableEdges[getProp(def, "nns")];
+  }
+  const auto addEdges = [&](xmlNodePtr def, const std::string &ident) {
+    auto &uses = tableEdges[ident];
+    forEachAttrValue(def, [&](llvm::StringRef value) {
+      const auto iter = tableEdges.find(value.str());
+      if (iter != tableEdges.end() && iter->first != ident) {
+        uses.insert(iter->first);
+      }
+    });
+  };
+  for (auto &&def : typeDefs) {
+    addEdges(def, getProp(def, "type"));
+  }
+  for (auto &&def : nnsDefs) {
+    addEdges(def, getProp(def, "nns"));
+  }
+}
+
+void
+DependencyGraph::addDeclaration(xmlNodePtr node, const SourceInfo &src) {
+  const auto className = getPropOrNull(node, "class");
+  if (!className.hasValue() || *className == "Namespace"
+      || *className == "LinkageSpec") {
+    return;
+  }
+  indexTables(node, src);
+
+  Declaration decl;
+  decl.id = "D" + std::to_string(decls.size());
+  decl.className = *className;
+  const auto nameNode = findFirst(node, "name", src.ctxt);
+  if (nameNode && !isEmpty(nameNode)) {
+    const auto name = getQualifiedName(node, src);
+    decl.name = getNamespacePrefix(node, src.ctxt)
+        + CXXCodeGen::to_string(name.toString(src.typeTable, src.nnsTable));
+    declsByName[getContent(nameNode)].push_back(decl.id);
+  }
+  // One walk of the subtree, separate from that of the CodeBuilder:
+  // the declarations that the fragment cache holds are not walked there.
+  forEachElement(node, [&](xmlNodePtr cur) {
+    forEachOwnAttrValue(cur, [&](llvm::StringRef value) {
+      const auto iter = tableEdges.find(value.str());
+      if (iter != tableEdges.end()) {
+        decl.idents.insert(iter->first);
+      }
+    });
+    if (cur != nameNode && xmlStrEqual(cur->name, BAD_CAST "name")) {
+      decl.names.insert(getContentRef(cur).str());
+    }
+  });
+
+  // The types that the declaration defines depend on it
+  const std::set<std::string> typeDecls = {"Record",
+      "CXXRecord",
+      "ClassTemplateSpecialization",
+      "ClassTemplatePartialSpecialization",
+      "Enum",
+      "Typedef",
+      "TypeAlias"};
+  if (typeDecls.count(*className)) {
+    for (auto &&attr : {"xcodemlType", "xcodemlTypedefType"}) {
+      const auto type = getPropOrNull(node, attr);
+      if (type.hasValue() && tableEdges.count(*type)) {
+        tableEdges[*type].insert(decl.id);
+      }
+    }
+  }
+  decls.push_back(decl);
+}
+
+void
+DependencyGraph::write(std::ostream &out) const {
+  for (auto &&decl : decls) {
+    out << "decl " << decl.id << " " << decl.className;
+    if (!decl.name.empty()) {
+      out << " " << decl.name;
+    }
+    out << "\n";
+  }
+  for (auto &&decl : decls) {
+    std::vector<std::string> uses(decl.idents.begin(), decl.idents.end());
+    for (auto &&name : decl.names) {
+      const auto iter = declsByName.find(name);
+      if (iter == declsByName.end()) {
+        continue;
+      }
+      for (auto &&id : iter->second) {
+        if (id != decl.id) {
+          uses.push_back(id);
+        }
+      }
+    }
+    if (uses.empty()) {
+      continue;
+    }
+    out << "uses " << decl.id;
+    for (auto &&use : uses) {
+      out << " " << use;
+    }
+    out << "\n";
+  }
+  for (auto &&edges : tableEdges) {
+    if (edges.second.empty()) {
+      continue;
+    }
+    out << "uses " << edges.first;
+    for (auto &&use : edges.second) {
+      out << " " << use;
+    }
+    out << "\n";
+  }
+}
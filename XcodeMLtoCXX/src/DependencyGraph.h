@@ -0,0 +1,60 @@
+#ifndef DEPENDENCYGRAPH_H
+#define DEPENDENCYGRAPH_H
+
+class SourceInfo;
+
+/*!
+ * \brief Dependencies among the namespace-scope declarations of an
+ * XcodeML document and the types and nested name specifiers they use,
+ * recorded while the declarations are converted.
+ *
+ * The graph is written as a list of the declarations followed by
+ * adjacency lists:
+ *
+ *     decl <id> <class> <qualified name>
+ *     uses <id> <id>...
+ *
+ * Declarations get the identifiers D0, D1, ... in document order;
+ * types and NNSs keep their XcodeML identifiers. `uses A B C` means
+ * that the code generated for A depends on B and C: a declaration
+ * uses the types and NNSs that it refers to and the declarations whose
+ * names it mentions, a type or NNS uses those that its definition
+ * refers to, and a class, enum or typedef type uses the declaration
+ * that defines it. Declarations are matched by their unqualified
+ * names, so the graph may contain a few more edges than needed, never
+ * fewer.
+ */
+class DependencyGraph {
+public:
+  DependencyGraph();
+
+  /*!
+   * \brief Record the declaration \c node, which is at namespace scope.
+   * Namespaces and linkage specifications are not recorded themselves;
+   * the declarations in them are.
+   */
+  void addDeclaration(xmlNodePtr node, const SourceInfo &src);
+
+  void write(std::ostream &out) const;
+
+private:
+  struct Declaration {
+    std::string id;
+    std::string className;
+    std::string name;
+    /*! The types and NNSs referred to */
+    std::set<std::string> idents;
+    /*! The unqualified names mentioned */
+    std::set<std::string> names;
+  };
+  void indexTables(xmlNodePtr node, const SourceInfo &src);
+
+  std::vector<Declaration> decls;
+  /*! The unqualified names mapped to the declarations of the name */
+  std::map<std::string, std::vector<std::string>> declsByName;
+  /*! The type and NNS identifiers mapped to what they use */
+  std::map<std::string, std::set<std::string>> tableEdges;
+  bool indexed;
+};
+
+#endif /* !DEPENDENCYGRAPH_H */
@@ -0,0 +1,282 @@
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <libxml/tree.h>
+#include <libxml/xpath.h>
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
+#include "LibXMLUtil.h"
+#include "XMLString.h"
+#include "StringTree.h"
+#include "XMLWalker.h"
+#include "XcodeMlNns.h"
+#include "XcodeMlType.h"
+#include "XcodeMlTypeTable.h"
+#include "SourceInfo.h"
+#include "CodeBuilder.h"
+#include "FragmentCache.h"
+
+namespace {
+
+/*!
+ * \brief 64-bit FNV-1a hash. It is stable across runs and platforms,
+ * which keys of the on-disk cache must be.
+ */
+class Digest {
+public:
+  Digest() : value(14695981039346656037ULL) {
+  }
+
+  void
+  update(const char *data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+      value ^= static_cast<unsigned char>(data[i]);
+      value *= 1099511628211ULL;
+    }
+  }
+
+  void
+  update(const std::string &str) {
+    update(str.data(), str.size());
+    // separate consecutive strings
+    update("", 1);
+  }
+
+  void
+  update(uint64_t n) {
+    update(reinterpret_cast<const char *>(&n), sizeof(n));
+  }
+
+  uint64_t
+  get() const {
+    return value;
+  }
+
+private:
+  uint64_t value;
+};
+
+std::string
+toHex(uint64_t n) {
+  char buf[17];
+  std::snprintf(
+      buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(n));
+  return buf;
+}
+
+std::string
+dumpNode(xmlNodePtr node) {
+  std::unique_ptr<xmlBuffer, decltype(&xmlBufferFree)> buf(
+      xmlBufferCreate(), xmlBufferFree);
+  xmlNodeDump(buf.get(), node->doc, node, 0, 0);
+  const auto content = xmlBufferContent(buf.get());
+  return std::string(reinterpret_cast<const char *>(content),
+      xmlBufferLength(buf.get()));
+}
+
+llvm::Optional<uint64_t>
+digestFile(const std::string &path) {
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs) {
+    return llvm::Optional<uint64_t>();
+  }
+  Digest digest;
+  char buf[65536];
+  while (ifs.read(buf, sizeof(buf)) || ifs.gcount() > 0) {
+    digest.update(buf, ifs.gcount());
+  }
+  return digest.get();
+}
+
+/*!
+ * \brief Returns true if the code generated for \c node can be reused.
+ *
+ * Only function declarations are cached. Functions that contain class
+ * definitions or type tables are excluded, since processing them
+ * renames types or extends \c SourceInfo, which affects the code
+ * generated for later declarations.
+ */
+bool
+isCacheable(xmlNodePtr node, const SourceInfo &src) {
+  const auto name = getName(node);
+  if (name == "clangDecl") {
+    const auto className = getPropOrNull(node, "class");
+    const std::set<std::string> functions = {"Function",
+        "CXXMethod",
+        "CXXConstructor",
+        "CXXDestructor",
+        "CXXConversion"};
+    if (!className.hasValue() || functions.count(*className) == 0) {
+      return false;
+    }
+  } else if (name != "functionDefinition") {
+    return false;
+  }
+  return !findFirst(node,
+      ".//clangDecl[@class='Record' or @class='CXXRecord'"
+      " or starts-with(@class, 'ClassTemplate')"
+      " or @class='TypeAliasTemplate']"
+      " | .//xcodemlTypeTable | .//xcodemlNnsTable",
+      src.ctxt);
+}
+
+} // namespace
+
+FragmentCache::FragmentCache(
+    const std::string &d, const std::string &executable)
+    : dir(d),
+      generator(0),
+      enabled(false),
+      indexed(false),
+      definitions(),
+      digests() {
+  const auto exeDigest = digestFile(executable);
+  if (!exeDigest.hasValue()) {
+    std::cerr << "warning: fragment cache disabled: cannot read '"
+              << executable << "'" << std::endl;
+    return;
+  }
+  if (mkdir(dir.c_str(), 0777) != 0 && errno != EEXIST) {
+    std::cerr << "warning: fragment cache disabled: cannot create '" << dir
+              << "'" << std::endl;
+    return;
+  }
+  generator = *exeDigest;
+  enabled = true;
+}
+
+bool
+FragmentCache::isEnabled() const {
+  return enabled;
+}
+
+void
+FragmentCache::indexDefinitions(xmlNodePtr node, const SourceInfo &src) const {
+  if (indexed) {
+    return;
+  }
+  indexed = true;
+  const auto root = xmlDocGetRootElement(node->doc);
+  for (auto &&def : findNodes(root,
+           "//xcodemlTypeTable/*[@type] | //typeTable/*[@type]",
+           src.ctxt)) {
+    definitions[getProp(def, "type")].push_back(def);
+  }
+  for (auto &&def : findNodes(
+           root, "//xcodemlNnsTable/*[@nns] | //nnsTable/*[@nns]", src.ctxt)) {
+    definitions[getProp(def, "nns")].push_back(def);
+  }
+}
+
+uint64_t
+FragmentCache::definitionDigest(const std::string &ident) const {
+  const auto iter = digests.find(ident);
+  if (iter != digests.end()) {
+    return iter->second;
+  }
+  Digest digest;
+  for (auto &&def : definitions.at(ident)) {
+    digest.update(dumpNode(def));
+  }
+  digests[ident] = digest.get();
+  return digest.get();
+}
+
+llvm::Optional<std::string>
+FragmentCache::makeKey(xmlNodePtr node, const SourceInfo &src) const {
+  if (!enabled || !isCacheable(node, src)) {
+    return llvm::Optional<std::string>();
+  }
+  indexDefinitions(node, src);
+
+  // collect the types and NNSs referenced transitively
+  std::set<std::string> referenced;
+  std::vector<xmlNodePtr> pending(1, node);
+  while (!pending.empty()) {
+    const auto cur = pending.back();
+    pending.pop_back();
+    forEachAttrValue(cur, [&](llvm::StringRef value) {
+      const auto def = definitions.find(value.str());
+      if (def != definitions.end() && referenced.insert(def->first).second) {
+        pending.insert(pending.end(), def->second.begin(), def->second.end());
+      }
+    });
+  }
+
+  Digest digest;
+  digest.update(generator);
+  digest.update(static_cast<uint64_t>(src.language));
+  digest.update(static_cast<uint64_t>(src.minimalParens));
+  digest.update(static_cast<uint64_t>(src.sourcePositions));
+  digest.update(dumpNode(node));
+  for (auto &&ident : referenced) {
+    digest.update(ident);
+    digest.update(definitionDigest(ident));
+  }
+  return toHex(digest.get());
+}
+
+std::string
+FragmentCache::entryPath(const std::string &key) const {
+  return dir + "/" + key + ".cxx";
+}
+
+llvm::Optional<std::string>
+FragmentCache::lookup(const std::string &key) const {
+  std::ifstream ifs(entryPath(key), std::ios::binary);
+  if (!ifs) {
+    return llvm::Optional<std::string>();
+  }
+  std::stringstream ss;
+  ss << ifs.rdbuf();
+  return ss.str();
+}
+
+void
+FragmentCache::store(const std::string &key, const std::string &code) const {
+  // write to a temporary file first so that concurrent runs never see
+  // a partial entry
+  const auto path = entryPath(key);
+  const auto tmpPath = path + "." + std::to_string(getpid());
+  {
+    std::ofstream ofs(tmpPath, std::ios::binary);
+    ofs << code;
+    if (!ofs) {
+      std::remove(tmpPath.c_str());
+      return;
+    }
+  }
+  if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+  }
+}
+
+XcodeMl::CodeFragment
+walkWithFragmentCache(const CodeBuilder &w, xmlNodePtr node, SourceInfo &src) {
+  const auto cache = src.fragmentCache;
+  if (!cache || &w != &ProgramBuilder) {
+    return w.walk(node, src);
+  }
+  const auto key = cache->makeKey(node, src);
+  if (!key.hasValue()) {
+    return w.walk(node, src);
+  }
+  if (const auto code = cache->lookup(*key)) {
+    return CXXCodeGen::makeTokenNode(*code);
+  }
+  const auto fragment = w.walk(node, src);
+  cache->store(*key, CXXCodeGen::to_string(fragment));
+  return fragment;
+}
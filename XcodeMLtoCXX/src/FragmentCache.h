@@ -0,0 +1,64 @@
+#ifndef FRAGMENTCACHE_H
+#define FRAGMENTCACHE_H
+
+class SourceInfo;
+
+/*!
+ * \brief On-disk cache of the C++ code generated for declarations.
+ *
+ * An entry is keyed by a hash of the XML subtree of a declaration,
+ * the definitions of the types and nested name specifiers it
+ * references (transitively), the source language, the parenthesization
+ * mode (SourceInfo::minimalParens), whether source positions are
+ * emitted (SourceInfo::sourcePositions) and the contents of the
+ * XcodeMLtoCXX executable. Rebuilding XcodeMLtoCXX therefore
+ * invalidates every entry.
+ *
+ * An instance indexes the type and NNS tables of the first document it
+ * is given, so it must serve a single document.
+ */
+class FragmentCache {
+public:
+  /*!
+   * \param dir Directory to store entries in. It is created if it does
+   * not exist.
+   * \param executable Path of the running XcodeMLtoCXX executable.
+   */
+  FragmentCache(const std::string &dir, const std::string &executable);
+
+  /*! \brief Returns false if the cache could not be set up. */
+  bool isEnabled() const;
+
+  /*!
+   * \brief Returns the cache key of a declaration, or
+   * \c llvm::Optional<std::string>() if its code cannot be cached.
+   */
+  llvm::Optional<std::string> makeKey(
+      xmlNodePtr node, const SourceInfo &src) const;
+
+  llvm::Optional<std::string> lookup(const std::string &key) const;
+
+  void store(const std::string &key, const std::string &code) const;
+
+private:
+  void indexDefinitions(xmlNodePtr node, const SourceInfo &src) const;
+  uint64_t definitionDigest(const std::string &ident) const;
+  std::string entryPath(const std::string &key) const;
+
+  std::string dir;
+  uint64_t generator;
+  bool enabled;
+  mutable bool indexed;
+  /*! type and NNS identifiers mapped to their definitions */
+  mutable std::map<std::string, std::vector<xmlNodePtr>> definitions;
+  mutable std::map<std::string, uint64_t> digests;
+};
+
+/*!
+ * \brief Walk a namespace-scope declaration, reusing the code cached in
+ * \c src.fragmentCache if any.
+ */
+XcodeMl::CodeFragment walkWithFragmentCache(
+    const CodeBuilder &w, xmlNodePtr node, SourceInfo &src);
+
+#endif /* !FRAGMENTCACHE_H */
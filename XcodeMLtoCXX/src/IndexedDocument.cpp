@@ -0,0 +1,205 @@
+#include <libxml/tree.h>
+#include <libxml/parser.h>
+#include <libxml/xpath.h>
+#include <climits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "llvm/ADT/Optional.h"
+#include "LibXMLUtil.h"
+#include "IndexedDocument.h"
+
+namespace {
+
+/*!
+ * \brief Read-only memory mapping of a whole file.
+ */
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &filename);
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  ~MappedFile();
+  const char *
+  data() const {
+    return static_cast<const char *>(addr);
+  }
+  unsigned long long
+  size() const {
+    return length;
+  }
+
+private:
+  void *addr;
+  unsigned long long length;
+};
+
+MappedFile::MappedFile(const std::string &filename)
+    : addr(nullptr), length(0) {
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot open " + filename);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw std::runtime_error("Cannot stat " + filename);
+  }
+  length = st.st_size;
+  if (length > 0) {
+    addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (addr == MAP_FAILED) {
+    throw std::runtime_error("Cannot map " + filename);
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (addr) {
+    munmap(addr, length);
+  }
+}
+
+unsigned long long
+getNumber(xmlNodePtr entry, const char *name) {
+  const auto value = getPropOrNull(entry, name);
+  if (!value.hasValue()) {
+    throw std::runtime_error(std::string("Invalid index: ")
+        + reinterpret_cast<const char *>(entry->name) + " has no " + name);
+  }
+  return std::stoull(*value);
+}
+
+bool
+isElement(xmlNodePtr node, const char *name) {
+  return node->type == XML_ELEMENT_NODE
+      && xmlStrEqual(node->name, BAD_CAST name);
+}
+
+xmlNodePtr
+findEntry(xmlNodePtr index, const char *name) {
+  for (xmlNodePtr entry = index->children; entry; entry = entry->next) {
+    if (isElement(entry, name)) {
+      return entry;
+    }
+  }
+  throw std::runtime_error(std::string("Invalid index: no ") + name);
+}
+
+class DocumentBuilder {
+public:
+  DocumentBuilder(const MappedFile &file) : file(file) {
+  }
+  void
+  append(unsigned long long offset, unsigned long long length) {
+    if (offset > file.size() || length > file.size() - offset) {
+      throw std::runtime_error("Invalid index: range out of the file");
+    }
+    buffer.append(file.data() + offset, length);
+  }
+  void
+  append(xmlNodePtr entry) {
+    append(getNumber(entry, "offset"), getNumber(entry, "length"));
+  }
+  bool appendMatches(xmlNodePtr entries, const std::string &name);
+  const std::string &
+  str() const {
+    return buffer;
+  }
+
+private:
+  const MappedFile &file;
+  std::string buffer;
+  // namespaces and linkage specifications around the current entries
+  std::vector<xmlNodePtr> ancestors;
+};
+
+bool
+matches(xmlNodePtr entry, const std::string &name) {
+  return getPropOrNull(entry, "name") == name
+      || getPropOrNull(entry, "mangled_name") == name;
+}
+
+/*!
+ * \brief Append each declaration among \c entries (at any depth) named
+ * \c name, enclosed in the heads and tails of its ancestors.
+ * \return true if any declaration is appended.
+ */
+bool
+DocumentBuilder::appendMatches(xmlNodePtr entries, const std::string &name) {
+  bool found = false;
+  for (xmlNodePtr entry = entries->children; entry; entry = entry->next) {
+    if (!isElement(entry, "decl")) {
+      continue;
+    }
+    if (!matches(entry, name)) {
+      ancestors.push_back(entry);
+      found = appendMatches(entry, name) || found;
+      ancestors.pop_back();
+      continue;
+    }
+    for (auto ancestor : ancestors) {
+      append(getNumber(ancestor, "offset"),
+          getNumber(ancestor, "head_length"));
+    }
+    append(entry);
+    for (auto it = ancestors.rbegin(); it != ancestors.rend(); ++it) {
+      const auto tail = getNumber(*it, "tail_length");
+      append(getNumber(*it, "offset") + getNumber(*it, "length") - tail,
+          tail);
+    }
+    found = true;
+  }
+  return found;
+}
+
+} // namespace
+
+xmlDocPtr
+readIndexedDocument(const std::string &filename,
+    const std::string &indexFile,
+    const std::string &name) {
+  xmlDocPtr indexDoc = xmlReadFile(indexFile.c_str(), nullptr, 0);
+  if (!indexDoc) {
+    throw std::runtime_error("Cannot read index " + indexFile);
+  }
+  std::unique_ptr<xmlDoc, decltype(&xmlFreeDoc)> indexHolder(
+      indexDoc, xmlFreeDoc);
+  xmlNodePtr index = xmlDocGetRootElement(indexDoc);
+  if (!index || !isElement(index, "xcodemlIndex")) {
+    throw std::runtime_error("Invalid index " + indexFile);
+  }
+
+  MappedFile file(filename);
+  if (getNumber(index, "length") != file.size()) {
+    throw std::runtime_error(indexFile + " is out of date");
+  }
+  DocumentBuilder builder(file);
+  builder.append(findEntry(index, "header"));
+  builder.append(findEntry(index, "typeTable"));
+  builder.append(findEntry(index, "nnsTable"));
+  if (!builder.appendMatches(index, name)) {
+    throw std::runtime_error("No declaration named " + name);
+  }
+  builder.append(findEntry(index, "footer"));
+
+  const std::string &buffer = builder.str();
+  if (buffer.size() > INT_MAX) {
+    throw std::runtime_error("Too large declarations: " + name);
+  }
+  xmlDocPtr doc = xmlReadMemory(buffer.data(),
+      static_cast<int>(buffer.size()),
+      filename.c_str(),
+      nullptr,
+      XML_PARSE_BIG_LINES | XML_PARSE_HUGE);
+  if (!doc) {
+    throw std::runtime_error("Cannot parse declarations: " + name);
+  }
+  return doc;
+}
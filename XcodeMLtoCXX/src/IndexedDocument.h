@@ -0,0 +1,17 @@
+#ifndef INDEXEDDOCUMENT_H
+#define INDEXEDDOCUMENT_H
+
+/*!
+ * \brief Parse only the declarations named \c name out of the XcodeML
+ * document \c filename, along with its type and NNS tables.
+ *
+ * \param indexFile Index written by CXXtoXcodeML --index. A
+ * declaration matches if its qualified or mangled name is \c name.
+ * \throw std::runtime_error if the index is missing or out of date,
+ * or if no declaration matches.
+ */
+xmlDocPtr readIndexedDocument(const std::string &filename,
+    const std::string &indexFile,
+    const std::string &name);
+
+#endif /* !INDEXEDDOCUMENT_H */
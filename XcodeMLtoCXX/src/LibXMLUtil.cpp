@@ -7,20 +7,23 @@
 #include <stdexcept>
 #include <vector>
 #include <libxml/debugXML.h>
+#include <libxml/dict.h>
 #include <libxml/tree.h>
 #include <libxml/parser.h>
 #include <libxml/xpath.h>
 #include <libxml/xpathInternals.h>
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
 #include "LibXMLUtil.h"
 #include "StringTree.h"
 #include "XcodeMlNns.h"
 #include "XcodeMlName.h"
 #include "XcodeMlUtil.h"
-#include "XMLString.h"
 
 static xmlXPathObjectPtr getNodeSet(
     xmlNodePtr, const char *, xmlXPathContextPtr);
+static llvm::StringRef borrowText(xmlDocPtr, xmlNodePtr);
+static llvm::StringRef internText(xmlDocPtr, xmlChar *);
 
 void XPathObjectReleaser::operator()(xmlXPathObjectPtr ptr) {
   xmlXPathFreeObject(ptr);
@@ -78,34 +81,18 @@ nth(xmlXPathObjectPtr obj, size_t n) {
  * \brief Returns the value of the attribute on the XML node
  * as \c std::string.
  *
- * This function is a wrapper of \c xmlGetProp.
- * It terminates the whole program if \c node does not have
- * the attribute \c attr.
- *
- * \pre \c node has the attribute named \c attr.
+ * \throw std::runtime_error if \c node does not have the attribute
+ * \c attr.
  */
 std::string
 getProp(xmlNodePtr node, const std::string &attr) {
-  if (node == nullptr){
-    std::cerr << attr<<std::endl;
-    throw(std::runtime_error("Node is Null"));
-  }
-  const auto value = getPropOrNull(node, attr);
-  if (!value.hasValue()) {
-    std::cerr << "getProp: " << attr << " not found" << std::endl;
-    std::cerr << getXcodeMlPath(node) << std::endl;
-    xmlDebugDumpNode(stderr, node, 0);
-    std::abort();
-  }
-  return *value;
+  return getPropRef(node, attr.c_str()).str();
 }
 
 /*!
  * \brief Returns the value of the attribute on the XML node
  * as \c std::string.
  *
- * This function is a wrapper of \c xmlGetProp.
- *
  * \return Returns \c llvm::Optional<std::string>() if
  * the specified attribute does not exist.
  * Otherwise, returns the value of the attribute.
@@ -113,29 +100,85 @@ getProp(xmlNodePtr node, const std::string &attr) {
 llvm::Optional<std::string>
 getPropOrNull(xmlNodePtr node, const std::string &attr) {
   using MaybeString = llvm::Optional<std::string>;
-  const auto ptr = xmlGetProp(node, BAD_CAST attr.c_str());
-  if (!ptr) {
+  const auto value = getPropRefOrNull(node, attr.c_str());
+  if (!value.hasValue()) {
     return MaybeString();
   }
-  const auto value = static_cast<XMLString>(ptr);
-  xmlFree(ptr);
-  return MaybeString(value);
+  return MaybeString(value->str());
 }
 
 /*!
  * \brief Returns the XML content text.
- *
- * This function is a wrapper of \c xmlNodeGetContent.
  */
 std::string
 getContent(xmlNodePtr node) {
-  const auto ptr = xmlNodeGetContent(node);
-  if (!ptr) {
-    return "";
+  return getContentRef(node).str();
+}
+
+/*!
+ * \brief Returns the value of the attribute on the XML node
+ * without copying it.
+ *
+ * Same as \c getProp, but the result refers to the text owned by
+ * the XML document.
+ */
+llvm::StringRef
+getPropRef(xmlNodePtr node, const char *attr) {
+  if (node == nullptr) {
+    std::cerr << attr << std::endl;
+    throw(std::runtime_error("Node is Null"));
+  }
+  const auto value = getPropRefOrNull(node, attr);
+  if (!value.hasValue()) {
+    throw std::runtime_error(std::string("getProp: ") + attr
+        + " not found at " + to_string(getXcodeMlPath(node)));
+  }
+  return *value;
+}
+
+/*!
+ * \brief Returns the value of the attribute on the XML node
+ * without copying it.
+ *
+ * Same as \c getPropOrNull, but the result refers to the text owned by
+ * the XML document.
+ */
+llvm::Optional<llvm::StringRef>
+getPropRefOrNull(xmlNodePtr node, const char *attr) {
+  using MaybeStringRef = llvm::Optional<llvm::StringRef>;
+  const auto prop = xmlHasProp(node, BAD_CAST attr);
+  if (!prop) {
+    return MaybeStringRef();
+  }
+  if (prop->type == XML_ATTRIBUTE_DECL) {
+    // default value declared in the DTD
+    const auto decl = reinterpret_cast<xmlAttributePtr>(prop);
+    return MaybeStringRef(
+        reinterpret_cast<const char *>(decl->defaultValue));
+  }
+  return MaybeStringRef(borrowText(node->doc, prop->children));
+}
+
+/*!
+ * \brief Returns the XML content text without copying it.
+ *
+ * Same as \c getContent, but the result refers to the text owned by
+ * the XML document.
+ */
+llvm::StringRef
+getContentRef(xmlNodePtr node) {
+  if (!node) {
+    return llvm::StringRef();
+  }
+  switch (node->type) {
+  case XML_ELEMENT_NODE:
+  case XML_ATTRIBUTE_NODE: return borrowText(node->doc, node->children);
+  case XML_TEXT_NODE:
+  case XML_CDATA_SECTION_NODE:
+  case XML_COMMENT_NODE:
+    return llvm::StringRef(reinterpret_cast<const char *>(node->content));
+  default: return internText(node->doc, xmlNodeGetContent(node));
   }
-  const auto content = static_cast<XMLString>(ptr);
-  xmlFree(ptr);
-  return content;
 }
 
 /*!
@@ -145,7 +188,7 @@ std::string
 getName(xmlNodePtr node) {
   if(!node)
       throw(std::runtime_error("Node is null"));
-  return static_cast<XMLString>(node->name);
+  return std::string(reinterpret_cast<const char *>(node->name));
 }
 
 /*!
@@ -154,7 +197,7 @@ getName(xmlNodePtr node) {
  */
 bool
 isEmpty(xmlNodePtr node) {
-  return getContent(node).empty();
+  return getContentRef(node).empty();
 }
 
 /*!
@@ -181,7 +224,7 @@ isTrueProp(xmlNodePtr node, const char *name, bool default_value) {
   if (!xmlHasProp(node, BAD_CAST name)) {
     return default_value;
   }
-  const auto value = getProp(node, name);
+  const auto value = getPropRef(node, name);
   if (value == "1" || value == "true") {
     return true;
   } else if (value == "0" || value == "false") {
@@ -254,3 +297,46 @@ getNodeSet(
   }
   return xpathObj;
 }
+
+/*!
+ * \brief Returns the text of the child nodes \c children
+ * (of an attribute or an element) without copying it.
+ *
+ * The text is borrowed from the only text child if any. Otherwise
+ * (e.g., entity references or nested elements), the concatenated text
+ * is interned in the dictionary of \c doc.
+ */
+static llvm::StringRef
+borrowText(xmlDocPtr doc, xmlNodePtr children) {
+  if (!children) {
+    return llvm::StringRef("");
+  }
+  if (!children->next
+      && (children->type == XML_TEXT_NODE
+             || children->type == XML_CDATA_SECTION_NODE)) {
+    return llvm::StringRef(reinterpret_cast<const char *>(children->content));
+  }
+  if (children->parent && children->parent->type == XML_ATTRIBUTE_NODE) {
+    return internText(doc, xmlNodeListGetString(doc, children, 1));
+  }
+  return internText(doc, xmlNodeGetContent(children->parent));
+}
+
+/*!
+ * \brief Interns \c str in the dictionary of \c doc (creating one if
+ * necessary) and frees \c str.
+ */
+static llvm::StringRef
+internText(xmlDocPtr doc, xmlChar *str) {
+  if (!str) {
+    return llvm::StringRef("");
+  }
+  static const xmlDictPtr orphanDict = xmlDictCreate();
+  if (doc && !doc->dict) {
+    doc->dict = xmlDictCreate();
+  }
+  const auto dict = doc ? doc->dict : orphanDict;
+  const auto interned = xmlDictLookup(dict, str, -1);
+  xmlFree(str);
+  return llvm::StringRef(reinterpret_cast<const char *>(interned));
+}
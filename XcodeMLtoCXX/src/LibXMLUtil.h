@@ -1,6 +1,10 @@
 #ifndef LIBXMLUTIL_H
 #define LIBXMLUTIL_H
 
+namespace llvm {
+class StringRef;
+} // namespace llvm
+
 struct XPathObjectReleaser {
   void operator()(xmlXPathObjectPtr ptr);
 };
@@ -16,6 +20,11 @@ xmlNodePtr nth(xmlXPathObjectPtr obj, size_t n);
 std::string getProp(xmlNodePtr node, const std::string &attr);
 llvm::Optional<std::string> getPropOrNull(xmlNodePtr, const std::string &);
 std::string getContent(xmlNodePtr);
+
+/* Borrowed views: valid as long as the XML document is alive */
+llvm::StringRef getPropRef(xmlNodePtr node, const char *attr);
+llvm::Optional<llvm::StringRef> getPropRefOrNull(xmlNodePtr, const char *);
+llvm::StringRef getContentRef(xmlNodePtr);
 std::string getName(xmlNodePtr);
 bool isEmpty(xmlNodePtr);
 
@@ -23,4 +32,44 @@ bool isEmpty(xmlNodePtr);
 bool isTrueProp(xmlNodePtr node, const char *name, bool default_value);
 bool isNaturalNumber(const std::string &);
 
+/*!
+ * \brief Call \c f with every element in the subtree of \c node,
+ * \c node included, in no particular order.
+ */
+template <typename F>
+void
+forEachElement(xmlNodePtr node, F f) {
+  std::vector<xmlNodePtr> pending(1, node);
+  while (!pending.empty()) {
+    const auto cur = pending.back();
+    pending.pop_back();
+    f(cur);
+    for (xmlNodePtr child = xmlFirstElementChild(cur); child;
+         child = xmlNextElementSibling(child)) {
+      pending.push_back(child);
+    }
+  }
+}
+
+/*!
+ * \brief Call \c f with the value of every attribute of \c node,
+ * borrowed from the document.
+ */
+template <typename F>
+void
+forEachOwnAttrValue(xmlNodePtr node, F f) {
+  for (xmlAttrPtr attr = node->properties; attr; attr = attr->next) {
+    f(getContentRef(reinterpret_cast<xmlNodePtr>(attr)));
+  }
+}
+
+/*!
+ * \brief Call \c f with every attribute value in the subtree of \c node.
+ */
+template <typename F>
+void
+forEachAttrValue(xmlNodePtr node, F f) {
+  forEachElement(node, [&](xmlNodePtr cur) { forEachOwnAttrValue(cur, f); });
+}
+
 #endif /* !LIBXMLUTIL_H */
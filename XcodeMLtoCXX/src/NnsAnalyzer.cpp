@@ -1,92 +1,159 @@
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <map>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <libxml/tree.h>
 #include <libxml/xpath.h>
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Casting.h"
-#include "LibXMLUtil.h"
 #include "StringTree.h"
 #include "XcodeMlNns.h"
 #include "XcodeMlType.h"
+#include "XcodeMlTree.h"
 #include "XcodeMlTypeTable.h"
-#include "XMLString.h"
-#include "XMLWalker.h"
 
-using NnsAnalyzer = XMLWalker<void, xmlXPathContextPtr, XcodeMl::NnsTable &>;
+using XcodeMl::Tree;
 
-#define NA_ARGS                                                               \
-  const NnsAnalyzer &w __attribute__((unused)),                               \
-      xmlNodePtr node __attribute__((unused)),                                \
-      xmlXPathContextPtr ctxt __attribute__((unused)),                        \
-      XcodeMl::NnsTable &map __attribute__((unused))
+namespace {
 
-#define DEFINE_NA(name) static void name(NA_ARGS)
+/*!
+ * \brief The ids of the element and attribute names of NNS definitions
+ * in a tree, npos for the ones it lacks.
+ */
+struct NnsNames {
+  explicit NnsNames(const Tree &tree)
+      : classNns(tree.lookup("classNNS")),
+        classTemplateSpecializationNns(
+            tree.lookup("classTemplateSpecializationNNS")),
+        namespaceNns(tree.lookup("namespaceNNS")),
+        otherNns(tree.lookup("otherNNS")),
+        nns(tree.lookup("nns")),
+        parent(tree.lookup("parent")),
+        type(tree.lookup("type")),
+        isAnonymous(tree.lookup("is_anonymous")) {
+  }
+  Tree::StringId classNns;
+  Tree::StringId classTemplateSpecializationNns;
+  Tree::StringId namespaceNns;
+  Tree::StringId otherNns;
+  Tree::StringId nns;
+  Tree::StringId parent;
+  Tree::StringId type;
+  Tree::StringId isAnonymous;
+};
 
-DEFINE_NA(classNnsProc) {
-  const auto name = getProp(node, "nns");
-  const auto type = getProp(node, "type");
-  const auto parent = getPropOrNull(node, "parent");
-  if (parent.hasValue()) {
-    map[name] = XcodeMl::makeClassNns(name, *parent, type);
-  } else {
-    // local classes
-    map[name] = XcodeMl::makeClassNns(name, type);
+/*!
+ * \brief Returns the value of the attribute \c name (whose id is
+ * \c key) of \c node.
+ *
+ * \throw std::runtime_error if \c node does not have the attribute.
+ */
+const std::string &
+getAttr(const Tree &tree, Tree::NodeId node, Tree::StringId key,
+    const char *name) {
+  const auto value = tree.getAttr(node, key);
+  if (value == Tree::npos) {
+    throw std::runtime_error(std::string("getProp: ") + name
+        + " not found in " + tree.getString(tree.getName(node)));
   }
+  return tree.getString(value);
 }
 
-DEFINE_NA(otherNnsProc) {
-  const auto nident = getProp(node, "nns");
-  map[nident] = XcodeMl::makeOtherNns(nident);
+/*!
+ * \brief Same as \c isTrueProp, for a node of \c tree.
+ */
+bool
+isTrueAttr(const Tree &tree, Tree::NodeId node, Tree::StringId key) {
+  const auto value = tree.getAttr(node, key);
+  if (value == Tree::npos) {
+    return false;
+  }
+  const auto &str = tree.getString(value);
+  if (str == "1" || str == "true") {
+    return true;
+  } else if (str == "0" || str == "false") {
+    return false;
+  }
+  throw std::runtime_error("Invalid attribute value");
 }
 
-DEFINE_NA(namespaceNnsProc) {
-  const auto nident = getProp(node, "nns");
-  const auto parent = getProp(node, "parent");
-  if (isTrueProp(node, "is_anonymous", false)) {
-    map[nident] = XcodeMl::makeUnnamedNamespaceNns(nident, parent);
-  } else {
-    const auto namespaceName = getContent(node);
-    map[nident] = XcodeMl::makeNamespaceNns(nident, parent, namespaceName);
+void
+defineNns(const Tree &tree,
+    const NnsNames &names,
+    Tree::NodeId node,
+    XcodeMl::NnsTable &map) {
+  const auto kind = tree.getName(node);
+  if (kind == names.classNns || kind == names.classTemplateSpecializationNns) {
+    const auto &name = getAttr(tree, node, names.nns, "nns");
+    const auto &type = getAttr(tree, node, names.type, "type");
+    const auto parent = tree.getAttr(node, names.parent);
+    if (parent != Tree::npos) {
+      map.define(name,
+          XcodeMl::makeClassNns(name, tree.getString(parent), type));
+    } else {
+      // local classes
+      map.define(name, XcodeMl::makeClassNns(name, type));
+    }
+  } else if (kind == names.namespaceNns) {
+    const auto &nident = getAttr(tree, node, names.nns, "nns");
+    const auto &parent = getAttr(tree, node, names.parent, "parent");
+    if (isTrueAttr(tree, node, names.isAnonymous)) {
+      map.define(nident, XcodeMl::makeUnnamedNamespaceNns(nident, parent));
+    } else {
+      map.define(nident,
+          XcodeMl::makeNamespaceNns(nident, parent, tree.getText(node)));
+    }
+  } else if (kind == names.otherNns) {
+    const auto &nident = getAttr(tree, node, names.nns, "nns");
+    map.define(nident, XcodeMl::makeOtherNns(nident));
   }
 }
 
+/*!
+ * \brief Define the NNS of the children of \c nnsTableNode in \c map.
+ *
+ * The table is read from an XcodeMl::Tree, which decodes every
+ * attribute once and lets the names be compared as integers.
+ */
+void
+defineNnsTable(xmlNodePtr nnsTableNode, XcodeMl::NnsTable &map) {
+  const auto tree = Tree::fromXml(nnsTableNode);
+  const NnsNames names(tree);
+  const auto root = tree.getRoot();
+  for (auto node = tree.childBegin(root); node < tree.childEnd(root);
+       ++node) {
+    defineNns(tree, names, node, map);
+  }
+}
+
+} // namespace
+
 const XcodeMl::NnsTable initialNnsTable = {
     {"global", XcodeMl::makeGlobalNns()},
 };
 
-const NnsAnalyzer XcodeMLNNSAnalyzer("NnsAnalyzer",
-    {
-        std::make_tuple("classNNS", classNnsProc),
-        std::make_tuple("classTemplateSpecializationNNS", classNnsProc),
-        std::make_tuple("namespaceNNS", namespaceNnsProc),
-        std::make_tuple("otherNNS", otherNnsProc),
-    });
-
 XcodeMl::NnsTable
-analyzeNnsTable(xmlNodePtr nnsTable, xmlXPathContextPtr ctxt) {
+analyzeNnsTable(xmlNodePtr nnsTable, xmlXPathContextPtr) {
   if (nnsTable == nullptr) {
     return initialNnsTable;
   }
 
   XcodeMl::NnsTable map = initialNnsTable;
-  auto nnsNodes = findNodes(nnsTable, "*", ctxt);
-  for (auto &&nnsNode : nnsNodes) {
-    XcodeMLNNSAnalyzer.walk(nnsNode, ctxt, map);
-  }
+  defineNnsTable(nnsTable, map);
   return map;
 }
 
 XcodeMl::NnsTable
 expandNnsTable(const XcodeMl::NnsTable &table,
     xmlNodePtr nnsTableNode,
-    xmlXPathContextPtr ctxt) {
+    xmlXPathContextPtr) {
   auto newTable = table;
-  const auto definitions = findNodes(nnsTableNode, "*", ctxt);
-  for (auto &&definition : definitions) {
-    XcodeMLNNSAnalyzer.walk(definition, ctxt, newTable);
-  }
+  defineNnsTable(nnsTableNode, newTable);
   return newTable;
 }
@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <cctype>
+#include <memory>
+#include <string>
+#include <vector>
+#include "StringTree.h"
+#include "Stream.h"
+#include "OutputSplitter.h"
+
+OutputSplitter::OutputSplitter(size_t numUnits)
+    : units(std::max<size_t>(numUnits, 1)) {
+}
+
+void
+OutputSplitter::enterNamespace(
+    const CXXCodeGen::StringTreeRef &head, bool isAnonymous) {
+  namespaces.push_back({head, isAnonymous});
+}
+
+void
+OutputSplitter::exitNamespace() {
+  namespaces.pop_back();
+}
+
+bool
+OutputSplitter::isInAnonymousNamespace() const {
+  return std::any_of(namespaces.begin(),
+      namespaces.end(),
+      [](const Namespace &ns) { return ns.isAnonymous; });
+}
+
+void
+OutputSplitter::addDefinition(const CXXCodeGen::StringTreeRef &definition) {
+  auto acc = definition;
+  for (auto it = namespaces.rbegin(); it != namespaces.rend(); ++it) {
+    acc = it->head + CXXCodeGen::wrapWithBrace(acc);
+  }
+  CXXCodeGen::Stream out;
+  acc->flush(out);
+  out << CXXCodeGen::newline;
+
+  const auto unit = std::min_element(units.begin(),
+      units.end(),
+      [](const std::string &lhs, const std::string &rhs) {
+        return lhs.size() < rhs.size();
+      });
+  unit->append(out.str());
+}
+
+const std::vector<std::string> &
+OutputSplitter::getUnits() const {
+  return units;
+}
+
+std::string
+makeIncludeGuard(const std::string &headerName) {
+  std::string guard;
+  for (const char c : headerName) {
+    guard += std::isalnum(static_cast<unsigned char>(c))
+        ? static_cast<char>(std::toupper(static_cast<unsigned char>(c)))
+        : '_';
+  }
+  if (guard.empty() || std::isdigit(static_cast<unsigned char>(guard[0]))) {
+    guard = "H_" + guard;
+  }
+  return guard;
+}
@@ -0,0 +1,48 @@
+#ifndef OUTPUTSPLITTER_H
+#define OUTPUTSPLITTER_H
+
+/*!
+ * \brief Distributes namespace-scope definitions among several
+ * translation units.
+ *
+ * Each definition is flushed as soon as it is added, wrapped in the
+ * namespaces that enclose it, and goes to the unit with the least
+ * code so far. The declarations that remain in the shared header are
+ * not managed here.
+ */
+class OutputSplitter {
+public:
+  explicit OutputSplitter(size_t numUnits);
+
+  /*! \brief Enter a namespace whose head is `namespace name`. */
+  void enterNamespace(
+      const CXXCodeGen::StringTreeRef &head, bool isAnonymous);
+  void exitNamespace();
+
+  /*!
+   * \brief Returns true if the current scope is in an unnamed
+   * namespace, whose members cannot be defined in another unit.
+   */
+  bool isInAnonymousNamespace() const;
+
+  void addDefinition(const CXXCodeGen::StringTreeRef &definition);
+
+  /*! \brief Returns the code of each translation unit. */
+  const std::vector<std::string> &getUnits() const;
+
+private:
+  struct Namespace {
+    CXXCodeGen::StringTreeRef head;
+    bool isAnonymous;
+  };
+  std::vector<Namespace> namespaces;
+  std::vector<std::string> units;
+};
+
+/*!
+ * \brief Returns the include guard macro of the shared header whose
+ * file name is \c headerName, e.g. FOO_BAR_H for foo-bar.h.
+ */
+std::string makeIncludeGuard(const std::string &headerName);
+
+#endif /* !OUTPUTSPLITTER_H */
@@ -0,0 +1,388 @@
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <libxml/parser.h>
+#include <libxml/xmlreader.h>
+#include "SchemaValidator.h"
+
+namespace {
+
+namespace schema {
+
+struct Attribute {
+  int symbol;
+  bool required;
+  int firstValue;
+  /*! -1 if any value is allowed */
+  int numValues;
+};
+
+struct Transition {
+  int symbol;
+  int state;
+  int type;
+};
+
+struct State {
+  bool accepting;
+  int firstTransition;
+  int numTransitions;
+};
+
+/*!
+ * \brief The element patterns of a name that may occur at a position.
+ */
+struct Type {
+  int symbol;
+  int startState;
+  int firstAttribute;
+  int numAttributes;
+  /*! The values of the text content; "" stands for no text */
+  int firstValue;
+  /*! -1 if any text is allowed */
+  int numValues;
+  bool hasChildren;
+};
+
+#include "XcodeMlSchema.inc"
+
+} // namespace schema
+
+const size_t numSymbols = sizeof(schema::symbols) / sizeof(schema::symbols[0]);
+
+/*!
+ * \brief Collapse the whitespace in \c value, as RELAX NG does before
+ * comparing it with a value of the schema.
+ */
+std::string
+normalizeSpace(const char *value) {
+  std::string result;
+  bool space = false;
+  for (const char *p = value; *p; ++p) {
+    if (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+      space = !result.empty();
+      continue;
+    }
+    if (space) {
+      result += ' ';
+      space = false;
+    }
+    result += *p;
+  }
+  return result;
+}
+
+bool
+isBlank(const char *text) {
+  for (const char *p = text; *p; ++p) {
+    if (*p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool
+isAllowedValue(const char *value, int first, int count) {
+  if (count < 0) {
+    return true;
+  }
+  const auto normalized = normalizeSpace(value);
+  const auto begin = schema::values + first;
+  return std::find_if(begin, begin + count, [&](const char *v) {
+    return normalized == v;
+  }) != begin + count;
+}
+
+class Validator {
+public:
+  Validator(xmlTextReaderPtr reader, const std::string &filename);
+  void run();
+
+private:
+  struct Frame {
+    int symbol;
+    size_t index;
+    int type;
+    int state;
+    /*! The number of child elements of each name so far */
+    std::vector<std::pair<int, size_t>> childCounts;
+    std::string text;
+  };
+  int currentSymbol();
+  std::string currentName() const;
+  void startElement();
+  void checkAttributes(const schema::Type &type);
+  void endElement();
+  void addText(const char *text);
+  void addEntityText();
+  std::string expected(int state) const;
+  [[noreturn]] void fail(const std::string &message,
+      const char *name = nullptr,
+      size_t index = 0) const;
+
+  xmlTextReaderPtr reader;
+  std::string filename;
+  std::vector<Frame> frames;
+  /*! The names interned by the reader mapped to symbols */
+  std::unordered_map<const xmlChar *, int> symbolCache;
+  std::vector<bool> seenAttributes;
+};
+
+Validator::Validator(xmlTextReaderPtr r, const std::string &f)
+    : reader(r), filename(f), frames(), symbolCache(), seenAttributes() {
+}
+
+void
+Validator::run() {
+  frames.push_back({-1, 0, 0, schema::types[0].startState, {}, {}});
+  int status;
+  while ((status = xmlTextReaderRead(reader)) == 1) {
+    switch (xmlTextReaderNodeType(reader)) {
+    case XML_READER_TYPE_ELEMENT:
+      startElement();
+      if (xmlTextReaderIsEmptyElement(reader)) {
+        endElement();
+      }
+      break;
+    case XML_READER_TYPE_END_ELEMENT: endElement(); break;
+    case XML_READER_TYPE_TEXT:
+    case XML_READER_TYPE_CDATA:
+      addText(reinterpret_cast<const char *>(xmlTextReaderConstValue(reader)));
+      break;
+    case XML_READER_TYPE_ENTITY_REFERENCE: addEntityText(); break;
+    default: break;
+    }
+  }
+  if (status != 0) {
+    fail("not well-formed");
+  }
+  if (frames.size() != 1 || !schema::states[frames.back().state].accepting) {
+    fail("no root element");
+  }
+}
+
+/*!
+ * \brief Returns the symbol of the name of the current node, or -1 if
+ * the schema does not know the name.
+ */
+int
+Validator::currentSymbol() {
+  if (xmlTextReaderConstNamespaceUri(reader)) {
+    return -1;
+  }
+  // Local names are interned in the dictionary of the reader, so they
+  // are cheaper to get than qualified names and can be compared as
+  // pointers.
+  const auto name = xmlTextReaderConstLocalName(reader);
+  const auto iter = symbolCache.find(name);
+  if (iter != symbolCache.end()) {
+    return iter->second;
+  }
+  const auto str = reinterpret_cast<const char *>(name);
+  const auto end = schema::symbols + numSymbols;
+  const auto found = std::lower_bound(
+      schema::symbols, end, str, [](const char *lhs, const char *rhs) {
+        return std::strcmp(lhs, rhs) < 0;
+      });
+  const int symbol = found != end && std::strcmp(*found, str) == 0
+      ? found - schema::symbols
+      : -1;
+  symbolCache.emplace(name, symbol);
+  return symbol;
+}
+
+std::string
+Validator::currentName() const {
+  return reinterpret_cast<const char *>(xmlTextReaderConstName(reader));
+}
+
+void
+Validator::startElement() {
+  const auto symbol = currentSymbol();
+  auto &parent = frames.back();
+  auto count = std::find_if(parent.childCounts.begin(),
+      parent.childCounts.end(),
+      [symbol](const std::pair<int, size_t> &c) { return c.first == symbol; });
+  if (count == parent.childCounts.end()) {
+    parent.childCounts.emplace_back(symbol, 0);
+    count = parent.childCounts.end() - 1;
+  }
+  const auto index = ++count->second;
+
+  const auto &state = schema::states[parent.state];
+  const auto begin = schema::transitions + state.firstTransition;
+  const auto end = begin + state.numTransitions;
+  const auto transition = std::lower_bound(begin,
+      end,
+      symbol,
+      [](const schema::Transition &t, int s) { return t.symbol < s; });
+  if (symbol < 0 || transition == end || transition->symbol != symbol) {
+    fail("element not allowed here; expected " + expected(parent.state),
+        currentName().c_str(),
+        index);
+  }
+  parent.state = transition->state;
+  const auto &type = schema::types[transition->type];
+  frames.push_back({symbol, index, transition->type, type.startState, {}, {}});
+  checkAttributes(type);
+}
+
+void
+Validator::checkAttributes(const schema::Type &type) {
+  const auto begin = schema::attributes + type.firstAttribute;
+  const auto end = begin + type.numAttributes;
+  seenAttributes.assign(type.numAttributes, false);
+  while (xmlTextReaderMoveToNextAttribute(reader) == 1) {
+    if (xmlTextReaderIsNamespaceDecl(reader) == 1) {
+      continue;
+    }
+    const auto symbol = currentSymbol();
+    const auto attr = std::lower_bound(begin,
+        end,
+        symbol,
+        [](const schema::Attribute &a, int s) { return a.symbol < s; });
+    if (symbol < 0 || attr == end || attr->symbol != symbol) {
+      fail("attribute '" + currentName() + "' not allowed");
+    }
+    if (attr->numValues >= 0) {
+      // the reader interns the values it returns, so ask only if needed
+      const auto value = reinterpret_cast<const char *>(
+          xmlTextReaderConstValue(reader));
+      if (!isAllowedValue(value, attr->firstValue, attr->numValues)) {
+        fail("attribute '" + currentName() + "' has invalid value '" + value
+            + "'");
+      }
+    }
+    seenAttributes[attr - begin] = true;
+  }
+  xmlTextReaderMoveToElement(reader);
+  for (auto attr = begin; attr != end; ++attr) {
+    if (attr->required && !seenAttributes[attr - begin]) {
+      fail(std::string("attribute '") + schema::symbols[attr->symbol]
+          + "' missing");
+    }
+  }
+}
+
+void
+Validator::endElement() {
+  const auto &frame = frames.back();
+  if (!schema::states[frame.state].accepting) {
+    fail("element incomplete; expected " + expected(frame.state));
+  }
+  const auto &type = schema::types[frame.type];
+  if (!type.hasChildren
+      && !isAllowedValue(
+             frame.text.c_str(), type.firstValue, type.numValues)) {
+    fail("invalid content '" + frame.text + "'");
+  }
+  frames.pop_back();
+}
+
+void
+Validator::addText(const char *text) {
+  auto &frame = frames.back();
+  const auto &type = schema::types[frame.type];
+  if (type.numValues < 0) {
+    return;
+  }
+  if (!type.hasChildren) {
+    // checked as a whole at the end of the element
+    frame.text += text;
+  } else if (!isBlank(text)) {
+    fail("text not allowed here");
+  }
+}
+
+/*!
+ * \brief Check an entity reference as the text it stands for, which is
+ * what the converter reads for it. External entities are not loaded, so
+ * they stand for no text.
+ */
+void
+Validator::addEntityText() {
+  const auto content = xmlNodeGetContent(xmlTextReaderCurrentNode(reader));
+  if (!content) {
+    return;
+  }
+  std::unique_ptr<xmlChar, decltype(xmlFree)> guard(content, xmlFree);
+  addText(reinterpret_cast<const char *>(content));
+}
+
+std::string
+Validator::expected(int stateIndex) const {
+  const auto &state = schema::states[stateIndex];
+  std::string result;
+  const int shown = 8;
+  for (int i = 0; i < state.numTransitions && i < shown; ++i) {
+    const auto &t = schema::transitions[state.firstTransition + i];
+    result += (i == 0 ? "" : ", ") + std::string(schema::symbols[t.symbol]);
+  }
+  if (state.numTransitions > shown) {
+    result += ", ...";
+  }
+  if (state.accepting) {
+    result += state.numTransitions == 0 ? "the end" : " or the end";
+  }
+  return result;
+}
+
+/*!
+ * \brief Throw an error at the current element, or at its child \c name
+ * if given.
+ */
+void
+Validator::fail(
+    const std::string &message, const char *name, size_t index) const {
+  // the line of the node rather than that of the parser, which reads
+  // ahead
+  auto node = xmlTextReaderCurrentNode(reader);
+  if (node && node->type == XML_ATTRIBUTE_NODE) {
+    node = node->parent;
+  }
+  const auto line =
+      node ? xmlGetLineNo(node) : xmlTextReaderGetParserLineNumber(reader);
+  std::stringstream ss;
+  ss << filename << ":" << line << ": ";
+  for (size_t i = 1; i < frames.size(); ++i) {
+    ss << "/" << schema::symbols[frames[i].symbol];
+    if (frames[i].index > 1) {
+      ss << "[" << frames[i].index << "]";
+    }
+  }
+  if (name) {
+    ss << "/" << name;
+    if (index > 1) {
+      ss << "[" << index << "]";
+    }
+  }
+  if (frames.size() == 1 && !name) {
+    ss << "/";
+  }
+  ss << ": " << message;
+  throw std::runtime_error(ss.str());
+}
+
+} // namespace
+
+void
+validateXcodeMlDocument(const std::string &filename) {
+  std::unique_ptr<xmlTextReader, decltype(&xmlFreeTextReader)> reader(
+      // Parse as the converter does, which keeps entity references
+      // unexpanded; never fetch anything the untrusted input refers to.
+      xmlReaderForFile(filename.c_str(),
+          nullptr,
+          XML_PARSE_BIG_LINES | XML_PARSE_HUGE | XML_PARSE_NONET),
+      xmlFreeTextReader);
+  if (!reader) {
+    throw std::runtime_error("Cannot read " + filename);
+  }
+  Validator(reader.get(), filename).run();
+}
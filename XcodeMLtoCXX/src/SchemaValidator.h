@@ -0,0 +1,15 @@
+#ifndef SCHEMAVALIDATOR_H
+#define SCHEMAVALIDATOR_H
+
+/*!
+ * \brief Validate the XcodeML document \c filename against
+ * schema/XcodeML_CXX.rnc in a single streaming pass, without building
+ * its tree.
+ *
+ * scripts/rnc2automaton.py compiles the schema into the automata of
+ * XcodeMlSchema.inc. Throws std::runtime_error giving the line and the
+ * element path of the first violation.
+ */
+void validateXcodeMlDocument(const std::string &filename);
+
+#endif /* !SCHEMAVALIDATOR_H */
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <map>
@@ -6,10 +7,12 @@
 #include <libxml/xpath.h>
 #include "llvm/ADT/Optional.h"
 
+#include "LibXMLUtil.h"
 #include "StringTree.h"
 #include "XcodeMlNns.h"
 #include "XcodeMlType.h"
 #include "XcodeMlTypeTable.h"
+#include "XcodeMlName.h"
 
 #include "SourceInfo.h"
 
@@ -17,10 +20,42 @@ SourceInfo::SourceInfo(xmlXPathContextPtr c,
     const XcodeMl::TypeTable &e,
     const XcodeMl::NnsTable &n,
     Language l)
-    : ctxt(c), typeTable(e), nnsTable(n), language(l), uniqueNameIndex(0) {
+    : ctxt(c),
+      typeTable(e),
+      nnsTable(n),
+      language(l),
+      unqualIds(std::make_shared<XcodeMl::UnqualIdTable>()),
+      fragmentCache(nullptr),
+      outputSplitter(nullptr),
+      minimalParens(false),
+      sourcePositions(false),
+      dependencyGraph(nullptr),
+      uniqueNameIndex(0),
+      nonTypeNamesCollected(false) {
 }
 
 std::string
 SourceInfo::getUniqueName() {
   return std::string("__xcodeml_") + std::to_string(++uniqueNameIndex);
 }
+
+bool
+SourceInfo::isNonTypeName(const std::string &name) {
+  if (!nonTypeNamesCollected) {
+    const auto names = findNodes(xmlDocGetRootElement(ctxt->doc),
+        "//clangDecl[not(@class='CXXRecord' or @class='Record'"
+        " or @class='ClassTemplate' or @class='ClassTemplateSpecialization'"
+        " or @class='ClassTemplatePartialSpecialization' or @class='Enum'"
+        " or @class='Typedef' or @class='TypeAlias'"
+        " or @class='TypeAliasTemplate' or @class='TemplateTypeParm'"
+        " or @class='CXXConstructor' or @class='CXXDestructor'"
+        " or @class='CXXConversion')]/name",
+        ctxt);
+    for (auto &&nameNode : names) {
+      nonTypeNames.push_back(getContent(nameNode));
+    }
+    std::sort(nonTypeNames.begin(), nonTypeNames.end());
+    nonTypeNamesCollected = true;
+  }
+  return std::binary_search(nonTypeNames.begin(), nonTypeNames.end(), name);
+}
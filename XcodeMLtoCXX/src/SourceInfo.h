@@ -3,8 +3,13 @@
 
 namespace XcodeMl {
 class TypeTable;
+class UnqualIdTable;
 } // namespace XcodeMl
 
+class DependencyGraph;
+class FragmentCache;
+class OutputSplitter;
+
 enum class Language {
   Invalid,
   C,
@@ -22,14 +27,41 @@ public:
       const XcodeMl::NnsTable &n,
       Language l);
   std::string getUniqueName();
+  /*!
+   * \brief Returns true if a variable, function or other non-type is
+   * declared as \c name somewhere in the program, so that the plain
+   * name of a class of that name may not denote the class.
+   */
+  bool isNonTypeName(const std::string &name);
 
   xmlXPathContextPtr ctxt;
   XcodeMl::TypeTable typeTable;
   XcodeMl::NnsTable nnsTable;
   Language language;
+  /*! The names in the document, interned (see getUnqualIdFromNameNode) */
+  std::shared_ptr<XcodeMl::UnqualIdTable> unqualIds;
+  /*! Cache of generated declarations, or nullptr if disabled */
+  const FragmentCache *fragmentCache;
+  /*! Translation units to split definitions into, or nullptr */
+  OutputSplitter *outputSplitter;
+  /*!
+   * Whether to put operands in parentheses only where the precedence
+   * of the operators requires it, instead of everywhere
+   */
+  bool minimalParens;
+  /*!
+   * Whether to mark each declaration with its position in the
+   * original source, which the output carries as `#line` directives
+   */
+  bool sourcePositions;
+  /*! Graph to record the namespace-scope declarations in, or nullptr */
+  DependencyGraph *dependencyGraph;
 
 private:
   size_t uniqueNameIndex;
+  /*! Sorted names of the non-type declarations, collected on demand */
+  std::vector<std::string> nonTypeNames;
+  bool nonTypeNamesCollected;
 };
 
 #endif /* !SOURCEINFO_H */
@@ -0,0 +1,104 @@
+#include <cctype>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "llvm/ADT/Optional.h"
+#include "SourceMap.h"
+
+namespace {
+
+using Position = std::pair<std::string, size_t>;
+
+/*!
+ * \brief Parse `#line <line> "<file>"` as CXXCodeGen::Stream emits it.
+ */
+llvm::Optional<Position>
+parseLineDirective(const std::string &text) {
+  const std::string head = "#line ";
+  if (text.compare(0, head.size(), head) != 0) {
+    return llvm::None;
+  }
+  size_t i = head.size();
+  size_t line = 0;
+  const auto digits = i;
+  for (; i < text.size() && isdigit(text[i]); ++i) {
+    line = line * 10 + (text[i] - '0');
+  }
+  if (i == digits || text.compare(i, 2, " \"") != 0) {
+    return llvm::None;
+  }
+  std::string filename;
+  for (i += 2; i < text.size() && text[i] != '"'; ++i) {
+    if (text[i] == '\\' && i + 1 < text.size()) {
+      ++i;
+    }
+    filename += text[i];
+  }
+  if (i + 1 != text.size()) {
+    return llvm::None;
+  }
+  return Position(filename, line);
+}
+
+} // namespace
+
+std::string
+SourceMap::extract(
+    const std::string &name, const std::string &code, size_t firstLine) {
+  codes.push_back({name, {}});
+  auto &ranges = codes.back().ranges;
+
+  std::string result;
+  result.reserve(code.size());
+  auto outputLine = firstLine;
+  llvm::Optional<Range> current;
+  size_t begin = 0;
+  while (begin < code.size()) {
+    auto end = code.find('\n', begin);
+    end = end == std::string::npos ? code.size() : end + 1;
+    const auto text = code.substr(begin, end - begin - (code[end - 1] == '\n'));
+    if (const auto position = parseLineDirective(text)) {
+      if (current && current->last >= current->first) {
+        ranges.push_back(*current);
+      }
+      const auto source = internSource(position->first);
+      current = Range{outputLine, outputLine - 1, source, position->second};
+    } else {
+      result.append(code, begin, end - begin);
+      if (current) {
+        current->last = outputLine;
+      }
+      ++outputLine;
+    }
+    begin = end;
+  }
+  if (current && current->last >= current->first) {
+    ranges.push_back(*current);
+  }
+  return result;
+}
+
+void
+SourceMap::write(std::ostream &out) const {
+  for (size_t i = 0; i < sources.size(); ++i) {
+    out << "source " << i << " " << sources[i] << "\n";
+  }
+  for (auto &&code : codes) {
+    out << "code " << code.name << "\n";
+    for (auto &&range : code.ranges) {
+      out << range.first << "-" << range.last << " " << range.source << " "
+          << range.line << "\n";
+    }
+  }
+}
+
+size_t
+SourceMap::internSource(const std::string &filename) {
+  const auto result = sourceIds.emplace(filename, sources.size());
+  if (result.second) {
+    sources.push_back(filename);
+  }
+  return result.first->second;
+}
@@ -0,0 +1,53 @@
+#ifndef SOURCEMAP_H
+#define SOURCEMAP_H
+
+/*!
+ * \brief Original source positions of the generated lines, kept in a
+ * file of their own instead of `#line` directives.
+ *
+ * The positions travel with the generated code as the directives that
+ * CXXCodeGen::Stream emits, and \c extract takes them out of each
+ * output file. The map lists every original file once, followed by a
+ * section per output file:
+ *
+ *     source <index> <original file>
+ *     code <output file>
+ *     <first>-<last> <index> <line>
+ *
+ * where the line <first> + k of the output file (counting from 1) comes
+ * from the line <line> + k of the original file <index>, as if the
+ * range were preceded by `#line <line> "<original file>"`.
+ */
+class SourceMap {
+public:
+  /*!
+   * \brief Remove the `#line` directives from \c code, which goes to
+   * the output file \c name, and record the positions they give.
+   * \param firstLine The line of \c name at which \c code begins.
+   * \return \c code without the directives.
+   */
+  std::string extract(const std::string &name,
+      const std::string &code,
+      size_t firstLine = 1);
+
+  void write(std::ostream &out) const;
+
+private:
+  struct Range {
+    size_t first;
+    size_t last;
+    size_t source;
+    size_t line;
+  };
+  struct Code {
+    std::string name;
+    std::vector<Range> ranges;
+  };
+  size_t internSource(const std::string &filename);
+
+  std::vector<std::string> sources;
+  std::map<std::string, size_t> sourceIds;
+  std::vector<Code> codes;
+};
+
+#endif /* !SOURCEMAP_H */
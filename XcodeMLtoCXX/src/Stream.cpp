@@ -30,7 +30,7 @@ struct StreamImpl {
         alreadyIndented(false),
         lastChar('\n'),
         currline(),
-        nextline() {
+        lineInfoChanged(false) {
   }
 
   using LineInfo = std::tuple<std::string, size_t>;
@@ -40,24 +40,10 @@ struct StreamImpl {
   bool alreadyIndented;
   char lastChar;
   llvm::Optional<LineInfo> currline;
-  llvm::Optional<LineInfo> nextline;
+  /*! Whether currline has changed since the last #line directive */
+  bool lineInfoChanged;
 };
 
-bool operator==(const llvm::Optional<StreamImpl::LineInfo> &x,
-    const llvm::Optional<StreamImpl::LineInfo> &y) {
-  if (!x && !y) {
-    return true;
-  }
-  if (!x || !y) {
-    return false;
-  }
-  return *x == *y;
-}
-bool operator!=(const llvm::Optional<StreamImpl::LineInfo> &x,
-    const llvm::Optional<StreamImpl::LineInfo> &y) {
-  return !(x == y);
-}
-
 namespace {
 
 void
@@ -79,6 +65,33 @@ emit(StreamImpl &impl, const std::string &str) {
   impl.lastChar = str.back();
 }
 
+void
+outputLineDirective(StreamImpl &impl) {
+  if (!impl.lineInfoChanged) {
+    return;
+  }
+  if (impl.lastChar != '\n') {
+    // a directive takes a line of its own
+    emit(impl, "\n");
+    impl.alreadyIndented = false;
+  }
+  std::string filename;
+  size_t lineno;
+  std::tie(filename, lineno) = *(impl.currline);
+
+  std::string quoted;
+  for (char c : filename) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+    }
+    quoted += c;
+  }
+  emit(impl,
+      std::string("#line ") + std::to_string(lineno) + " \"" + quoted
+          + "\"\n");
+  impl.lineInfoChanged = false;
+}
+
 } // namespace
 
 Stream::Stream() : pimpl(make_unique<StreamImpl>()) {
@@ -116,25 +129,7 @@ Stream::insertSpace() {
 
 void
 Stream::insertNewLine() {
-  if (pimpl->currline && pimpl->currline != pimpl->nextline) {
-    std::string filename;
-    size_t lineno;
-    std::tie(filename, lineno) = *(pimpl->currline);
-
-    const auto directive = std::string("#line ") + std::to_string(lineno)
-        + "\"" + filename + "\"";
-    emit(*pimpl, std::string("\n") + directive + "\n");
-    pimpl->nextline = StreamImpl::LineInfo(filename, lineno + 1);
-  } else {
-    emit(*pimpl, "\n");
-    if (pimpl->nextline) {
-      std::string filename;
-      size_t lineno;
-      std::tie(filename, lineno) = *(pimpl->currline);
-
-      pimpl->nextline = StreamImpl::LineInfo(filename, lineno + 1);
-    }
-  }
+  emit(*pimpl, "\n");
   pimpl->alreadyIndented = false;
 }
 
@@ -154,7 +149,8 @@ shouldInterleaveSpace(char last, char next) {
       || (operators.find(last) != std::string::npos && next == '=')
       || (last == next && repeatables.find(last) != std::string::npos)
       || (last == '-' && next == '>') || // `->`
-      (last == '>' && next == '*'); // `->*`
+      (last == '>' && next == '*') || // `->*`
+      (last == '/' && (next == '*' || next == '/')); // comments
 }
 
 } // namespace
@@ -165,6 +161,7 @@ Stream::insert(const std::string &token) {
     return;
   }
 
+  outputLineDirective(*pimpl);
   outputIndentation(*pimpl);
 
   if (shouldInterleaveSpace(pimpl->lastChar, token[0])) {
@@ -175,7 +172,11 @@ Stream::insert(const std::string &token) {
 
 void
 Stream::setLineInfo(const std::string &filename, size_t lineno) {
-  pimpl->currline = StreamImpl::LineInfo(filename, lineno);
+  const StreamImpl::LineInfo info(filename, lineno);
+  if (!pimpl->currline || *(pimpl->currline) != info) {
+    pimpl->currline = info;
+    pimpl->lineInfoChanged = true;
+  }
 }
 
 } // namespace CXXCodeGen
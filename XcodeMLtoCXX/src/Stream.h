@@ -33,7 +33,12 @@ public:
    */
   void insert(const std::string &);
 
-  /*! \brief Set the source position to emit #-line directive properly. */
+  /*!
+   * \brief Set the source position of the code that follows.
+   *
+   * A change of the position is emitted as a `#line` directive, on a
+   * line of its own before the next token (see SourceMap).
+   */
   void setLineInfo(const std::string &filename, size_t lineno);
 
   /*! \brief Decreases indent. */
@@ -1,6 +1,9 @@
+#include <algorithm>
+#include <cctype>
 #include <memory>
 #include <vector>
 #include <string>
+#include <utility>
 #include "llvm/Support/Casting.h"
 
 #include "Stream.h"
@@ -21,13 +24,18 @@ StringTree::getKind() const {
 
 bool
 InnerNode::classof(const StringTree *node) {
-  return node->getKind() == StringTreeKind::Inner;
+  return node->getKind() == StringTreeKind::Inner
+      || node->getKind() == StringTreeKind::Operation;
 }
 
 InnerNode::InnerNode(const std::vector<StringTreeRef> &v)
     : StringTree(StringTreeKind::Inner), children(v) {
 }
 
+InnerNode::InnerNode(StringTreeKind k, const std::vector<StringTreeRef> &v)
+    : StringTree(k), children(v) {
+}
+
 StringTree *
 InnerNode::clone() const {
   std::vector<StringTreeRef> v;
@@ -40,8 +48,22 @@ InnerNode::clone() const {
 
 void
 InnerNode::flush(Stream &ss) const {
-  for (auto child : children) {
-    child->flush(ss);
+  // Nested inner nodes are flushed with an explicit stack so that
+  // deeply nested trees do not exhaust the native stack.
+  std::vector<std::pair<const InnerNode *, size_t>> stack;
+  stack.emplace_back(this, 0);
+  while (!stack.empty()) {
+    auto &top = stack.back();
+    if (top.second == top.first->children.size()) {
+      stack.pop_back();
+      continue;
+    }
+    const auto &child = top.first->children[top.second++];
+    if (const auto inner = llvm::dyn_cast<InnerNode>(child.get())) {
+      stack.emplace_back(inner, 0);
+    } else {
+      child->flush(ss);
+    }
   }
 }
 
@@ -51,6 +73,46 @@ InnerNode::lift() const {
   return copy;
 }
 
+const std::vector<StringTreeRef> &
+InnerNode::getChildren() const {
+  return children;
+}
+
+bool
+OperationNode::classof(const StringTree *node) {
+  return node->getKind() == StringTreeKind::Operation;
+}
+
+OperationNode::OperationNode(const StringTreeRef &e, Precedence prec)
+    : InnerNode(StringTreeKind::Operation,
+          {makeInternedTokenNode<token::LParen>(),
+              e,
+              makeInternedTokenNode<token::RParen>()}),
+      expr(e),
+      precedence(prec) {
+}
+
+StringTree *
+OperationNode::clone() const {
+  return new OperationNode(StringTreeRef(expr->clone()), precedence);
+}
+
+InnerNode *
+OperationNode::lift() const {
+  // Appending to an operation makes a mere inner node
+  return new InnerNode(getChildren());
+}
+
+const StringTreeRef &
+OperationNode::getExpr() const {
+  return expr;
+}
+
+Precedence
+OperationNode::getPrecedence() const {
+  return precedence;
+}
+
 bool
 TokenNode::classof(const StringTree *node) {
   return node->getKind() == StringTreeKind::Token;
@@ -71,6 +133,11 @@ TokenNode::flush(Stream &ss) const {
   ss << token;
 }
 
+const std::string &
+TokenNode::getToken() const {
+  return token;
+}
+
 InnerNode *
 TokenNode::lift() const {
   std::vector<StringTreeRef> v({std::make_shared<TokenNode>(token)});
@@ -80,9 +147,18 @@ TokenNode::lift() const {
 
 void
 InnerNode::amend(const StringTreeRef &node) {
-  std::unique_ptr<InnerNode> IN(node->lift());
-  std::copy(
-      IN->children.begin(), IN->children.end(), std::back_inserter(children));
+  // Operations are kept whole so that their precedence stays known
+  const auto IN = node->getKind() == StringTreeKind::Inner
+      ? llvm::cast<InnerNode>(node.get())
+      : nullptr;
+  if (IN) {
+    std::copy(
+        IN->children.begin(), IN->children.end(), std::back_inserter(children));
+    return;
+  }
+  // Leaves and operations are immutable and can be shared instead of
+  // copied
+  children.push_back(node);
 }
 
 bool
@@ -130,7 +206,7 @@ SourcePosNode::SourcePosNode(std::string f, size_t l)
 
 StringTree *
 SourcePosNode::clone() const {
-  return (StringTree *)this;
+  return new SourcePosNode(*this);
 }
 
 void
@@ -161,6 +237,11 @@ makeTokenNode(const std::string &s) {
   return std::make_shared<TokenNode>(s);
 }
 
+StringTreeRef
+makeSourcePosNode(const std::string &filename, size_t lineno) {
+  return std::make_shared<SourcePosNode>(filename, lineno);
+}
+
 std::string
 to_string(const StringTreeRef &str) {
   Stream ss;
@@ -170,17 +251,62 @@ to_string(const StringTreeRef &str) {
 
 StringTreeRef
 makeVoidNode() {
-  return std::make_shared<TokenNode>("");
+  return makeInternedTokenNode<token::Empty>();
 }
 
 namespace {
 // helpers
 
+template <typename Opening, typename Closing>
 StringTreeRef
-wrapWithStr(const std::string &opening,
-    const StringTreeRef &str,
-    const std::string &closing) {
-  return makeTokenNode(opening) + str + makeTokenNode(closing);
+wrapWithTokens(const StringTreeRef &str) {
+  return makeInternedTokenNode<Opening>() + str
+      + makeInternedTokenNode<Closing>();
+}
+
+/*!
+ * \brief Returns the operation that `str` consists of, looking through
+ * inner nodes that contain nothing else, or nullptr.
+ */
+const OperationNode *
+getOperation(const StringTreeRef &str) {
+  const StringTree *node = str.get();
+  while (node->getKind() == StringTreeKind::Inner) {
+    const StringTree *only = nullptr;
+    for (auto &&child : llvm::cast<InnerNode>(node)->getChildren()) {
+      const auto token = llvm::dyn_cast<TokenNode>(child.get());
+      if (token && token->getToken().empty()) {
+        continue;
+      }
+      if (only) {
+        return nullptr;
+      }
+      only = child.get();
+    }
+    if (!only) {
+      return nullptr;
+    }
+    node = only;
+  }
+  return llvm::dyn_cast<OperationNode>(node);
+}
+
+/*!
+ * \brief Returns true if `str` is a single token of a name or a number.
+ */
+bool
+isNameOrNumber(const StringTreeRef &str) {
+  const auto token = llvm::dyn_cast<TokenNode>(str.get());
+  if (!token || token->getToken().empty()) {
+    return false;
+  }
+  const auto &spelling = token->getToken();
+  if (!isalnum(spelling.front()) && spelling.front() != '_') {
+    return false;
+  }
+  return std::all_of(spelling.begin(), spelling.end(), [](char c) {
+    return isalnum(c) || c == '_' || c == '.';
+  });
 }
 
 } // namespace
@@ -207,7 +333,8 @@ StringTreeRef
 foldWithSemicolon(const std::vector<StringTreeRef> &stmts) {
   auto node = makeVoidNode();
   for (auto &stmt : stmts) {
-    node = node + stmt + makeTokenNode(";") + makeNewLineNode();
+    node = node + stmt + makeInternedTokenNode<token::Semicolon>()
+        + makeNewLineNode();
   }
   return node;
 }
@@ -215,10 +342,13 @@ foldWithSemicolon(const std::vector<StringTreeRef> &stmts) {
 StringTreeRef
 join(const std::string &delim, const std::vector<StringTreeRef> &strs) {
   auto acc = makeVoidNode();
+  const auto delimNode = delim == token::Comma::spelling()
+      ? makeInternedTokenNode<token::Comma>()
+      : makeTokenNode(delim);
   bool alreadyPrinted = false;
   for (auto &str : strs) {
     if (alreadyPrinted) {
-      acc = acc + makeTokenNode(delim);
+      acc = acc + delimNode;
     }
     acc = acc + str;
     alreadyPrinted = true;
@@ -228,17 +358,17 @@ join(const std::string &delim, const std::vector<StringTreeRef> &strs) {
 
 StringTreeRef
 wrapWithParen(const StringTreeRef &str) {
-  return wrapWithStr("(", str, ")");
+  return wrapWithTokens<token::LParen, token::RParen>(str);
 }
 
 StringTreeRef
 wrapWithSquareBracket(const StringTreeRef &str) {
-  return wrapWithStr("[", str, "]");
+  return wrapWithTokens<token::LBracket, token::RBracket>(str);
 }
 
 StringTreeRef
 wrapWithBrace(const StringTreeRef &str) {
-  return wrapWithStr("{", str, "}");
+  return wrapWithTokens<token::LBrace, token::RBrace>(str);
 }
 
 StringTreeRef
@@ -246,11 +376,36 @@ wrapWithXcodeMlIdentity(const StringTreeRef &type) {
   return makeTokenNode("__xcodeml_identity<") + type + makeTokenNode(">::t");
 }
 
+StringTreeRef
+makeOperationNode(const StringTreeRef &expr, Precedence prec) {
+  return std::make_shared<OperationNode>(expr, prec);
+}
+
+StringTreeRef
+makeOperand(const StringTreeRef &operand, Precedence max) {
+  const auto operation = getOperation(operand);
+  if (operation && operation->getPrecedence() <= max) {
+    return operation->getExpr();
+  }
+  return operand;
+}
+
+StringTreeRef
+makeEnclosedOperand(const StringTreeRef &operand, Precedence max) {
+  if (getOperation(operand) || isNameOrNumber(operand)) {
+    return makeOperand(operand, max);
+  }
+  return wrapWithParen(operand);
+}
+
 } // namespace CXXCodeGen
 
 CXXCodeGen::StringTreeRef operator+(const CXXCodeGen::StringTreeRef &lhs,
     const CXXCodeGen::StringTreeRef &rhs) {
-  auto ret = lhs->lift();
+  using CXXCodeGen::InnerNode;
+  const auto ret = llvm::isa<InnerNode>(lhs.get())
+      ? lhs->lift()
+      : new InnerNode(std::vector<CXXCodeGen::StringTreeRef>({lhs}));
   ret->amend(rhs);
   return CXXCodeGen::StringTreeRef(ret);
 }
@@ -12,6 +12,32 @@ enum class StringTreeKind {
   NewLine,
   /*! leaf node which represents a source position */
   SourcePos,
+  /*! inner node which represents an operation (see OperationNode) */
+  Operation,
+};
+
+/*!
+ * \brief Precedence of C++ operators; an operator of a smaller value
+ * binds tighter.
+ */
+enum class Precedence {
+  Primary,
+  Postfix,
+  Unary,
+  PointerToMember,
+  Multiplicative,
+  Additive,
+  Shift,
+  Relational,
+  Equality,
+  BitAnd,
+  BitXor,
+  BitOr,
+  LogAnd,
+  LogOr,
+  /*! assignment and conditional operators */
+  Assignment,
+  Comma,
 };
 
 class InnerNode;
@@ -52,14 +78,45 @@ public:
   /*! \brief (Shallowly) Copy the child-string-nodes of `other` to
    * `this->children`. */
   void amend(const StringTreeRef &other);
+  const std::vector<StringTreeRef> &getChildren() const;
 
 protected:
+  InnerNode(StringTreeKind, const std::vector<StringTreeRef> &);
   InnerNode(const InnerNode &) = default;
 
 private:
   std::vector<StringTreeRef> children;
 };
 
+/*!
+ * \brief An expression of an operator, which is output in parentheses.
+ *
+ * The operation it is an operand of may output it without the
+ * parentheses, where the precedence makes them redundant (see
+ * makeOperand).
+ */
+class OperationNode : public InnerNode {
+public:
+  static bool classof(const StringTree *);
+  /*!
+   * \param expr The expression without the outer parentheses
+   * \param prec The precedence of its (outermost) operator
+   */
+  OperationNode(const StringTreeRef &expr, Precedence prec);
+  ~OperationNode() = default;
+  StringTree *clone() const override;
+  InnerNode *lift() const override;
+  const StringTreeRef &getExpr() const;
+  Precedence getPrecedence() const;
+
+protected:
+  OperationNode(const OperationNode &) = default;
+
+private:
+  StringTreeRef expr;
+  Precedence precedence;
+};
+
 class TokenNode : public StringTree {
 public:
   static bool classof(const StringTree *);
@@ -67,6 +124,7 @@ public:
   ~TokenNode() = default;
   StringTree *clone() const override;
   void flush(Stream &) const override;
+  const std::string &getToken() const;
   /*!
    * \brief Make and return an `XcodeMl::InnerNode` object containing a
    * child-string-node that is a copy of this object.
@@ -153,6 +211,48 @@ StringTreeRef makeInnerNode(const std::vector<StringTreeRef> &nodes);
 /*! \brief Make and return a `CXXCodeGen::TokenNode` object. */
 StringTreeRef makeTokenNode(const std::string &);
 
+/*!
+ * \brief Make and return a `CXXCodeGen::SourcePosNode` object, which
+ * marks the code that follows as coming from `filename`:`lineno`.
+ */
+StringTreeRef makeSourcePosNode(const std::string &filename, size_t lineno);
+
+/*!
+ * \brief Return the token node of `Token::spelling()`.
+ *
+ * Like the new line node, it is created once and shared by every
+ * caller (string-nodes are never modified once made).
+ */
+template <typename Token>
+const StringTreeRef &
+makeInternedTokenNode() {
+  static const StringTreeRef node = makeTokenNode(Token::spelling());
+  return node;
+}
+
+/*! \brief Define a token type for makeInternedTokenNode. */
+#define CXXCODEGEN_DEFINE_TOKEN(name, str)                                    \
+  struct name {                                                               \
+    static constexpr const char *                                             \
+    spelling() {                                                              \
+      return str;                                                             \
+    }                                                                         \
+  }
+
+namespace token {
+
+CXXCODEGEN_DEFINE_TOKEN(LParen, "(");
+CXXCODEGEN_DEFINE_TOKEN(RParen, ")");
+CXXCODEGEN_DEFINE_TOKEN(LBracket, "[");
+CXXCODEGEN_DEFINE_TOKEN(RBracket, "]");
+CXXCODEGEN_DEFINE_TOKEN(LBrace, "{");
+CXXCODEGEN_DEFINE_TOKEN(RBrace, "}");
+CXXCODEGEN_DEFINE_TOKEN(Semicolon, ";");
+CXXCODEGEN_DEFINE_TOKEN(Comma, ",");
+CXXCODEGEN_DEFINE_TOKEN(Empty, "");
+
+} // namespace token
+
 /*!
  * \brief Returns a string-node created by concatenating the string-nodes,
  * separated by line break("\n").
@@ -193,6 +293,27 @@ StringTreeRef wrapWithBrace(const StringTreeRef &);
 
 StringTreeRef wrapWithXcodeMlIdentity(const StringTreeRef &type);
 
+/*!
+ * \brief Make and return a `CXXCodeGen::OperationNode` object.
+ */
+StringTreeRef makeOperationNode(const StringTreeRef &expr, Precedence prec);
+
+/*!
+ * \brief Returns `operand` as an operand that must bind at least as
+ * tightly as `max`.
+ *
+ * An operation of such a precedence is returned without its
+ * parentheses, and any other string-node as it is.
+ */
+StringTreeRef makeOperand(const StringTreeRef &operand, Precedence max);
+
+/*!
+ * \brief Like `makeOperand`, but puts `operand` in parentheses unless
+ * it is an operation or a single name or number.
+ */
+StringTreeRef makeEnclosedOperand(
+    const StringTreeRef &operand, Precedence max);
+
 } // namespace CXXCodeGen
 
 CXXCodeGen::StringTreeRef operator+(
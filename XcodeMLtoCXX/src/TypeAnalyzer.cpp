@@ -11,6 +11,7 @@
 #include <libxml/xpath.h>
 #include <libxml/xpathInternals.h>
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Casting.h"
 #include "LibXMLUtil.h"
 #include "XMLString.h"
@@ -45,8 +46,8 @@ using CXXCodeGen::makeVoidNode;
 #define DEFINE_TA(name) static void name(TA_ARGS)
 
 DEFINE_TA(basicTypeProc) {
-  XMLString signified = xmlGetProp(node, BAD_CAST "name");
-  XMLString signifier(xmlGetProp(node, BAD_CAST "type"));
+  const auto signified = getProp(node, "name");
+  const auto signifier = getProp(node, "type");
   map[signifier] = XcodeMl::makeQualifiedType(signifier,
       signified,
       isTrueProp(node, "is_const", false),
@@ -54,8 +55,8 @@ DEFINE_TA(basicTypeProc) {
 }
 
 DEFINE_TA(pointerTypeProc) {
-  XMLString refName = xmlGetProp(node, BAD_CAST "ref");
-  XMLString name(xmlGetProp(node, BAD_CAST "type"));
+  const auto refName = getProp(node, "ref");
+  const auto name = getProp(node, "type");
 
   const auto refProp = getPropOrNull(node, "reference");
   if (refProp.hasValue() && (*refProp == "lvalue")) {
@@ -111,14 +112,14 @@ DEFINE_TA(functionTypeProc) {
 DEFINE_TA(arrayTypeProc) {
   using XcodeMl::Array;
 
-  XMLString elemName = xmlGetProp(node, BAD_CAST "element_type");
-  XMLString name(xmlGetProp(node, BAD_CAST "type"));
+  const auto elemName = getProp(node, "element_type");
+  const auto name = getProp(node, "type");
 
   const Array::Size size = [node]() {
     if (!xmlHasProp(node, BAD_CAST "array_size")) {
       return Array::Size::makeVariableSize();
     }
-    const XMLString size_prop = xmlGetProp(node, BAD_CAST "array_size");
+    const auto size_prop = getProp(node, "array_size");
     return size_prop == "*"
         ? Array::Size::makeVariableSize()
         : Array::Size::makeIntegerSize(std::stoi(size_prop));
@@ -132,12 +133,12 @@ DEFINE_TA(arrayTypeProc) {
 
 static XcodeMl::MemberDecl
 makeMember(xmlNodePtr idNode) {
-  XMLString type = xmlGetProp(idNode, BAD_CAST "type");
-  XMLString name = xmlNodeGetContent(xmlFirstElementChild(idNode));
+  const auto type = getProp(idNode, "type");
+  const auto name = getContent(xmlFirstElementChild(idNode));
   if (!xmlHasProp(idNode, BAD_CAST "bit_field")) {
     return XcodeMl::MemberDecl(type, makeTokenNode(name));
   }
-  XMLString bit_size = xmlGetProp(idNode, BAD_CAST "bit_field");
+  const auto bit_size = getProp(idNode, "bit_field");
   if (!isNaturalNumber(bit_size)) {
     return XcodeMl::MemberDecl(type, makeTokenNode(name));
     // FIXME: Don't ignore <bitField> element
@@ -146,7 +147,7 @@ makeMember(xmlNodePtr idNode) {
 }
 
 DEFINE_TA(structTypeProc) {
-  XMLString elemName = xmlGetProp(node, BAD_CAST "type");
+  const auto elemName = getProp(node, "type");
   XcodeMl::Struct::MemberList fields;
   const auto symbols = findNodes(node, "symbols/id", ctxt);
   for (auto &symbol : symbols) {
@@ -206,7 +207,7 @@ getTemplateArgs(xmlNodePtr node, xmlXPathContextPtr ctxt) {
   return MaybeList(targs);
 }
 DEFINE_TA(classTypeProc) {
-  XMLString elemName = xmlGetProp(node, BAD_CAST "type");
+  const auto elemName = getProp(node, "type");
   const auto nameSpelling = getContent(findFirst(node, "name", ctxt));
   const auto className = nameSpelling.empty() ? XcodeMl::ClassType::ClassName()
                                               : makeTokenNode(nameSpelling);
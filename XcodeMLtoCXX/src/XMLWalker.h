@@ -3,6 +3,9 @@
 
 #include <libxml/debugXML.h>
 #include <iostream>
+#include <stdexcept>
+
+#include "TraceEvent.h"
 
 /*!
  * \brief A class that combines procedures into a single one
@@ -15,6 +18,12 @@
  * given XML elements and their descendants until it finds an element
  * whose name is registered with the map. Finally it executes
  * a corresponding procedure.
+ *
+ * Procedures registered as staged procedures do not walk their
+ * operands themselves; they return a Continuation instead, and
+ * XMLWalker evaluates the operands on an explicit stack. Elements
+ * without procedures are folded in the same way, so deeply nested
+ * elements handled by them do not consume the native stack.
  */
 template <typename ReturnT, typename... T>
 class XMLWalker {
@@ -25,27 +34,57 @@ public:
   using Procedure =
       std::function<ReturnT(const XMLWalker &, xmlNodePtr, T...)>;
 
+  /*!
+   * \brief Deferred part of a staged procedure.
+   *
+   * XMLWalker walks each of \c operands in order and passes
+   * the results to \c combine.
+   */
+  struct Continuation {
+    std::vector<xmlNodePtr> operands;
+    std::function<ReturnT(const std::vector<ReturnT> &)> combine;
+  };
+
+  /*!
+   * \brief Procedure that fills in a Continuation instead of walking
+   * the operands by itself.
+   *
+   * It returns false to leave the element to the ordinary procedure.
+   */
+  using StagedProcedure = std::function<bool(
+      const XMLWalker &, xmlNodePtr, Continuation &, T...)>;
+
   XMLWalker(const std::string &n,
       const std::function<ReturnT(const std::vector<ReturnT> &)> f,
       std::initializer_list<std::tuple<std::string, Procedure>> pairs)
-      : name(n), fold(f), map() {
+      : name(n), fold(f), map(), stagedMap() {
     for (auto p : pairs) {
       registerProc(std::get<0>(p), std::get<1>(p));
     }
   }
 
+  XMLWalker(const std::string &n,
+      const std::function<ReturnT(const std::vector<ReturnT> &)> f,
+      std::initializer_list<std::tuple<std::string, Procedure>> pairs,
+      std::initializer_list<std::tuple<std::string, StagedProcedure>>
+          stagedPairs)
+      : XMLWalker(n, f, pairs) {
+    for (auto p : stagedPairs) {
+      registerStagedProc(std::get<0>(p), std::get<1>(p));
+    }
+  }
+
   XMLWalker(const std::string &n,
       const std::function<ReturnT(const std::vector<ReturnT> &)> f,
       std::map<std::string, Procedure> &&initMap)
-      : name(n), fold(f), map(initMap) {
+      : name(n), fold(f), map(initMap), stagedMap() {
   }
 
   const Procedure &operator[](const std::string &key) const {
     const auto iter = map.find(key);
     if (iter == map.end()) {
-      std::cerr << "In " << name << ":" << std::endl
-                << "Nonexistent procedure called: '" + key + "'" << std::endl;
-      std::abort();
+      throw std::runtime_error(
+          "In " + name + ": Nonexistent procedure called: '" + key + "'");
     }
     return iter->second;
   }
@@ -88,26 +127,33 @@ public:
    * \pre \c node is an XML element node.
    */
   ReturnT
-  walk(xmlNodePtr node, T... args) const
-  {
-    if(!node){
-      throw std::runtime_error("null node passed");
-    }else if(node->type != XML_ELEMENT_NODE){
-      std::cerr <<"Node Type Invalid"<<node->name<<node->type<<std::endl;
-      throw std::runtime_error("Node Type Invalid");
-    }
-    XMLString elemName = node->name;
-    auto iter = map.find(elemName);
-    try{
-      if (iter != map.end()) {
-	return (iter->second)(*this, node, args...);
-      } else {
-	return fold(walkAll(node->children, args...));
+  walk(xmlNodePtr node, T... args) const {
+    std::vector<Frame> stack;
+    try {
+      if (!stage(node, stack, args...)) {
+        return apply(node, args...);
       }
-    }catch(std::exception &e){
-        std::cerr << "In " << name << ": walk(" << elemName << ")" << std::endl << e.what() << std::endl;
-	std::cerr<< node->name <<xmlGetLineNo(node)<<std::endl;
-      throw ;
+      for (;;) {
+        Frame &top = stack.back();
+        if (top.values.size() < top.k.operands.size()) {
+          const auto operand = top.k.operands[top.values.size()];
+          if (!stage(operand, stack, args...)) {
+            top.values.push_back(apply(operand, args...));
+          }
+          continue;
+        }
+        const auto value = top.k.combine(top.values);
+        stack.pop_back();
+        if (stack.empty()) {
+          return value;
+        }
+        stack.back().values.push_back(value);
+      }
+    } catch (std::exception &e) {
+      for (auto iter = stack.rbegin(); iter != stack.rend(); ++iter) {
+        report(iter->node, e);
+      }
+      throw;
     }
   }
 
@@ -128,10 +174,111 @@ public:
     return true;
   }
 
+  /*!
+   * \brief Register a staged procedure. If \c key already exists,
+   * do nothing.
+   * \param key The name of XML element which \c proc should process.
+   * \param value Staged procedure to run. It takes precedence over
+   * the procedure registered with the same key.
+   * \return false if \c key already exists.
+   */
+  bool
+  registerStagedProc(std::string key, StagedProcedure value) {
+    auto iter = stagedMap.find(key);
+    if (iter != stagedMap.end()) {
+      return false;
+    }
+    stagedMap[key] = value;
+    return true;
+  }
+
 private:
+  /*!
+   * \brief An element whose operands are being walked.
+   */
+  struct Frame {
+    explicit Frame(xmlNodePtr n) : node(n), k(), values() {
+    }
+    xmlNodePtr node;
+    Continuation k;
+    std::vector<ReturnT> values;
+  };
+
+  static void
+  checkNode(xmlNodePtr node) {
+    if(!node){
+      throw std::runtime_error("null node passed");
+    }else if(node->type != XML_ELEMENT_NODE){
+      std::cerr <<"Node Type Invalid"<<node->name<<node->type<<std::endl;
+      throw std::runtime_error("Node Type Invalid");
+    }
+  }
+
+  void
+  report(xmlNodePtr node, const std::exception &e) const {
+    std::cerr << "In " << name << ": walk(" << XMLString(node->name) << ")"
+              << std::endl << e.what() << std::endl;
+    std::cerr<< node->name <<xmlGetLineNo(node)<<std::endl;
+  }
+
+  /*!
+   * \brief Push a frame for \c node onto \c stack if it is processed
+   * by a staged procedure or by \c fold.
+   * \return false if \c node should be passed to apply() instead.
+   */
+  bool
+  stage(xmlNodePtr node, std::vector<Frame> &stack, T... args) const {
+    checkNode(node);
+    XMLString elemName = node->name;
+    Frame frame(node);
+    const auto staged = stagedMap.find(elemName);
+    if (staged != stagedMap.end()) {
+      try {
+        if (!(staged->second)(*this, node, frame.k, args...)) {
+          return false;
+        }
+      } catch (std::exception &e) {
+        report(node, e);
+        throw;
+      }
+    } else if (map.find(elemName) == map.end()) {
+      for (xmlNodePtr cur = xmlFirstElementChild(node); cur;
+           cur = xmlNextElementSibling(cur)) {
+        frame.k.operands.push_back(cur);
+      }
+      frame.k.combine = fold;
+    } else {
+      return false;
+    }
+    stack.push_back(std::move(frame));
+    return true;
+  }
+
+  /*!
+   * \brief Run the ordinary procedure for \c node.
+   */
+  ReturnT
+  apply(xmlNodePtr node, T... args) const {
+    XMLString elemName = node->name;
+    auto iter = map.find(elemName);
+    TraceEvent::Scope trace(
+        name.c_str(), reinterpret_cast<const char *>(node->name));
+    try{
+      if (iter != map.end()) {
+	return (iter->second)(*this, node, args...);
+      } else {
+	return fold(walkAll(node->children, args...));
+      }
+    }catch(std::exception &e){
+      report(node, e);
+      throw ;
+    }
+  }
+
   std::string name;
   std::function<ReturnT(const std::vector<ReturnT> &)> fold;
   std::map<std::string, Procedure> map;
+  std::map<std::string, StagedProcedure> stagedMap;
 };
 
 template <typename... T>
@@ -154,9 +301,8 @@ public:
   const Procedure &operator[](const std::string &key) const {
     const auto iter = map.find(key);
     if (iter == map.end()) {
-      std::cerr << "In " << name << ":" << std::endl
-                << "Nonexistent procedure called: '" + key + "'" << std::endl;
-      std::abort();
+      throw std::runtime_error(
+          "In " + name + ": Nonexistent procedure called: '" + key + "'");
     }
     return iter->second;
   }
@@ -190,18 +336,31 @@ public:
       std::cerr <<"Node Type Invalid"<<node->name<<node->type<<std::endl;
       throw std::runtime_error("Node Type Invalid");
     }
-    XMLString elemName = node->name;
-    auto iter = map.find(elemName);
-    if (iter != map.end()) {
-      try {
-        (iter->second)(*this, node, args...);
-      } catch (const std::exception &e) {
-        std::cerr << "In " << name << ": walk(" << elemName << ")" << std::endl << e.what() << std::endl;
-        xmlDebugDumpNode(stderr, node, 0);
-        abort();
+    // Elements without procedures are descended into with an explicit
+    // stack. Children are pushed in reverse so that they are visited in
+    // document order.
+    std::vector<xmlNodePtr> pending(1, node);
+    while (!pending.empty()) {
+      const xmlNodePtr cur = pending.back();
+      pending.pop_back();
+      XMLString elemName = cur->name;
+      auto iter = map.find(elemName);
+      if (iter != map.end()) {
+        TraceEvent::Scope trace(
+            name.c_str(), reinterpret_cast<const char *>(cur->name));
+        try {
+          (iter->second)(*this, cur, args...);
+        } catch (const std::exception &e) {
+          std::cerr << "In " << name << ": walk(" << elemName << ")"
+                    << std::endl;
+          throw;
+        }
+        continue;
+      }
+      for (xmlNodePtr child = xmlLastElementChild(cur); child;
+           child = xmlPreviousElementSibling(child)) {
+        pending.push_back(child);
       }
-    } else {
-      walkAll(node->children, args...);
     }
   }
 
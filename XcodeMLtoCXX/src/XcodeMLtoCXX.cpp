@@ -2,10 +2,13 @@
 #include <libxml/parser.h>
 #include <libxml/xpath.h>
 #include <libxml/xpathInternals.h>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <functional>
 #include <map>
+#include <set>
 #include <sstream>
 #include <cassert>
 #include <memory>
@@ -20,29 +23,292 @@
 #include "TypeAnalyzer.h"
 #include "SourceInfo.h"
 #include "CodeBuilder.h"
+#include "DependencyGraph.h"
+#include "FragmentCache.h"
+#include "IndexedDocument.h"
+#include "OutputSplitter.h"
+#include "SchemaValidator.h"
+#include "SourceMap.h"
+#include "TraceEvent.h"
+
+namespace {
+
+void
+printUsage(const char *program) {
+  std::cout << "usage: " << program
+            << " [--cache-dir <dir>] [--only <name> [--index <file>]]"
+            << " [--split <N> [--output-prefix <prefix>]] [--minimal-parens]"
+            << " [--line-directives | --source-map <file>] [--deps <file>]"
+            << " [--validate]"
+            << " [--trace-out <file> [--trace-threshold <us>]] <filename>"
+            << std::endl;
+}
+
+bool
+parseThreshold(const std::string &str, unsigned &threshold) {
+  char *end;
+  const auto value = std::strtoul(str.c_str(), &end, 10);
+  if (str.empty() || *end != '\0') {
+    return false;
+  }
+  threshold = value;
+  return true;
+}
+
+bool
+parseUnitCount(const std::string &str, size_t &count) {
+  char *end;
+  const auto value = std::strtoul(str.c_str(), &end, 10);
+  if (str.empty() || *end != '\0' || value == 0) {
+    return false;
+  }
+  count = value;
+  return true;
+}
+
+/*!
+ * \brief Returns \c filename without its directory and extension.
+ */
+std::string
+getStem(const std::string &filename) {
+  const auto slash = filename.find_last_of('/');
+  auto stem =
+      slash == std::string::npos ? filename : filename.substr(slash + 1);
+  const auto dot = stem.find_last_of('.');
+  return dot == std::string::npos || dot == 0 ? stem : stem.substr(0, dot);
+}
+
+/*!
+ * \brief Returns \c code as it goes to the file \c name: with its
+ * `#line` directives moved to \c sourceMap if any.
+ */
+std::string
+placeLineInfo(SourceMap *sourceMap,
+    const std::string &name,
+    const std::string &code,
+    size_t firstLine = 1) {
+  return sourceMap ? sourceMap->extract(name, code, firstLine) : code;
+}
+
+/*!
+ * \brief Write <prefix>.h, guarded against repeated inclusion, and
+ * <prefix>_<i>.cpp, each of which includes the former.
+ */
+bool
+writeSplitCode(const std::string &prefix,
+    const std::string &header,
+    const OutputSplitter &splitter,
+    SourceMap *sourceMap) {
+  const auto headerName = prefix + ".h";
+  const auto guard = makeIncludeGuard(getStem(prefix) + ".h");
+  std::ofstream headerFile(headerName);
+  // the code begins after the #ifndef and #define lines
+  headerFile << "#ifndef " << guard << std::endl
+             << "#define " << guard << std::endl
+             << placeLineInfo(sourceMap, headerName, header, 3) << std::endl
+             << "#endif /* !" << guard << " */" << std::endl;
+  if (!headerFile) {
+    std::cerr << "Cannot write " << headerName << std::endl;
+    return false;
+  }
+  const auto &units = splitter.getUnits();
+  for (size_t i = 0; i < units.size(); ++i) {
+    const auto unitName = prefix + "_" + std::to_string(i) + ".cpp";
+    std::ofstream unitFile(unitName);
+    // the code begins after the #include line
+    unitFile << "#include \"" << getStem(prefix) << ".h\"" << std::endl
+             << placeLineInfo(sourceMap, unitName, units[i], 2);
+    if (!unitFile) {
+      std::cerr << "Cannot write " << unitName << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
 
 int
 main(int argc, char **argv) {
-  if (argc < 2) {
-    std::cout << "usage: " << argv[0] << " <filename>" << std::endl;
+  std::string filename;
+  llvm::Optional<std::string> cacheDir;
+  llvm::Optional<std::string> only;
+  llvm::Optional<std::string> indexFile;
+  llvm::Optional<std::string> outputPrefix;
+  llvm::Optional<std::string> traceFile;
+  size_t numUnits = 0;
+  unsigned traceThreshold = 100;
+  bool minimalParens = false;
+  bool lineDirectives = false;
+  llvm::Optional<std::string> sourceMapFile;
+  llvm::Optional<std::string> depsFile;
+  bool validate = false;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg(argv[i]);
+    if (arg == "--cache-dir" && i + 1 < argc) {
+      cacheDir = std::string(argv[++i]);
+    } else if (arg.compare(0, 12, "--cache-dir=") == 0) {
+      cacheDir = arg.substr(12);
+    } else if (arg == "--only" && i + 1 < argc) {
+      only = std::string(argv[++i]);
+    } else if (arg.compare(0, 7, "--only=") == 0) {
+      only = arg.substr(7);
+    } else if (arg == "--index" && i + 1 < argc) {
+      indexFile = std::string(argv[++i]);
+    } else if (arg.compare(0, 8, "--index=") == 0) {
+      indexFile = arg.substr(8);
+    } else if (arg == "--split" && i + 1 < argc) {
+      if (!parseUnitCount(argv[++i], numUnits)) {
+        printUsage(argv[0]);
+        return 1;
+      }
+    } else if (arg.compare(0, 8, "--split=") == 0) {
+      if (!parseUnitCount(arg.substr(8), numUnits)) {
+        printUsage(argv[0]);
+        return 1;
+      }
+    } else if (arg == "--output-prefix" && i + 1 < argc) {
+      outputPrefix = std::string(argv[++i]);
+    } else if (arg.compare(0, 16, "--output-prefix=") == 0) {
+      outputPrefix = arg.substr(16);
+    } else if (arg == "--trace-out" && i + 1 < argc) {
+      traceFile = std::string(argv[++i]);
+    } else if (arg.compare(0, 12, "--trace-out=") == 0) {
+      traceFile = arg.substr(12);
+    } else if (arg == "--trace-threshold" && i + 1 < argc) {
+      if (!parseThreshold(argv[++i], traceThreshold)) {
+        printUsage(argv[0]);
+        return 1;
+      }
+    } else if (arg.compare(0, 18, "--trace-threshold=") == 0) {
+      if (!parseThreshold(arg.substr(18), traceThreshold)) {
+        printUsage(argv[0]);
+        return 1;
+      }
+    } else if (arg == "--minimal-parens") {
+      minimalParens = true;
+    } else if (arg == "--line-directives") {
+      lineDirectives = true;
+    } else if (arg == "--source-map" && i + 1 < argc) {
+      sourceMapFile = std::string(argv[++i]);
+    } else if (arg.compare(0, 13, "--source-map=") == 0) {
+      sourceMapFile = arg.substr(13);
+    } else if (arg == "--deps" && i + 1 < argc) {
+      depsFile = std::string(argv[++i]);
+    } else if (arg.compare(0, 7, "--deps=") == 0) {
+      depsFile = arg.substr(7);
+    } else if (arg == "--validate") {
+      validate = true;
+    } else if (filename.empty() && arg.compare(0, 2, "--") != 0) {
+      filename = arg;
+    } else {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+  if (filename.empty()) {
+    printUsage(argv[0]);
     return 0;
   }
-  std::string filename(argv[1]);
-  xmlDocPtr doc = xmlReadFile(filename.c_str(), NULL, XML_PARSE_BIG_LINES);
+  if (lineDirectives && sourceMapFile.hasValue()) {
+    printUsage(argv[0]);
+    return 1;
+  }
+  if (traceFile.hasValue()) {
+    TraceEvent::start(*traceFile, traceThreshold);
+  }
+  std::unique_ptr<FragmentCache> cache;
+  if (cacheDir.hasValue()) {
+    // /proc/self/exe is not available on every platform
+    cache.reset(new FragmentCache(*cacheDir, "/proc/self/exe"));
+    if (!cache->isEnabled()) {
+      cache.reset(new FragmentCache(*cacheDir, argv[0]));
+    }
+  }
+  if (validate) {
+    try {
+      validateXcodeMlDocument(filename);
+    } catch (std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+  }
+  xmlDocPtr doc = nullptr;
+  if (only.hasValue()) {
+    try {
+      doc = readIndexedDocument(filename,
+          indexFile.hasValue() ? *indexFile : filename + ".index",
+          *only);
+    } catch (std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+  } else {
+    doc = xmlReadFile(
+        filename.c_str(), NULL, XML_PARSE_BIG_LINES | XML_PARSE_HUGE);
+  }
   xmlNodePtr root = xmlDocGetRootElement(doc);
   xmlXPathContextPtr ctxt = xmlXPathNewContext(doc);
+  std::unique_ptr<OutputSplitter> splitter;
+  if (numUnits > 0) {
+    splitter.reset(new OutputSplitter(numUnits));
+  }
+  std::unique_ptr<DependencyGraph> dependencyGraph;
+  if (depsFile.hasValue()) {
+    dependencyGraph.reset(new DependencyGraph);
+  }
   std::stringstream ss;
   try{
-    buildCode(root, ctxt, ss);
+    buildCode(root,
+        ctxt,
+        ss,
+        cache.get(),
+        splitter.get(),
+        minimalParens,
+        lineDirectives || sourceMapFile.hasValue(),
+        dependencyGraph.get());
   }catch(std::exception &e){
     std::cerr <<e.what()<<std::endl;
+    TraceEvent::finish();
     exit(-1);
   }catch(...){
     std::cerr << "Unknown Error"<<std::endl;
+    TraceEvent::finish();
     exit(-1);
   }
-  std::cout << ss.str() << std::endl;
+  if (!TraceEvent::finish()) {
+    std::cerr << "Cannot write " << *traceFile << std::endl;
+  }
   xmlXPathFreeContext(ctxt);
   xmlFreeDoc(doc);
+  std::unique_ptr<SourceMap> sourceMap;
+  if (sourceMapFile.hasValue()) {
+    sourceMap.reset(new SourceMap);
+  }
+  if (splitter) {
+    const auto prefix =
+        outputPrefix.hasValue() ? *outputPrefix : getStem(filename);
+    if (!writeSplitCode(prefix, ss.str(), *splitter, sourceMap.get())) {
+      return 1;
+    }
+  } else {
+    std::cout << placeLineInfo(sourceMap.get(), "-", ss.str()) << std::endl;
+  }
+  if (dependencyGraph) {
+    std::ofstream graphFile(*depsFile);
+    dependencyGraph->write(graphFile);
+    if (!graphFile) {
+      std::cerr << "Cannot write " << *depsFile << std::endl;
+      return 1;
+    }
+  }
+  if (sourceMap) {
+    std::ofstream mapFile(*sourceMapFile);
+    sourceMap->write(mapFile);
+    if (!mapFile) {
+      std::cerr << "Cannot write " << *sourceMapFile << std::endl;
+      return 1;
+    }
+  }
   return 0;
 }
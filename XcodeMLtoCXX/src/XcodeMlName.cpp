@@ -1,9 +1,11 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <libxml/tree.h>
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Casting.h"
 #include "StringTree.h"
 #include "XcodeMlNns.h"
@@ -54,7 +56,7 @@ UnqualId::getKind() const {
 }
 
 UIDIdent::UIDIdent(const std::string &id)
-    : UnqualId(UnqualIdKind::Ident), ident(id) {
+    : UnqualId(UnqualIdKind::Ident), token(makeTokenNode(id)) {
 }
 
 UnqualId *
@@ -65,7 +67,7 @@ UIDIdent::clone() const {
 
 CodeFragment
 UIDIdent::toString(const TypeTable &, const NnsTable &) const {
-  return makeTokenNode(ident);
+  return token;
 }
 
 bool
@@ -179,4 +181,67 @@ UnnamedId::classof(const UnqualId *id) {
   return id->getKind() == UnqualIdKind::Unnamed;
 }
 
+namespace {
+
+using UnqualIdMap = std::unordered_map<std::string, std::shared_ptr<UnqualId>>;
+
+template <typename T>
+std::shared_ptr<UnqualId>
+intern(UnqualIdMap &ids, llvm::StringRef key) {
+  auto &id = ids[key.str()];
+  if (!id) {
+    id = std::make_shared<T>(key.str());
+  }
+  return id;
+}
+
+} // namespace
+
+struct UnqualIdTable::Impl {
+  UnqualIdMap idents;
+  UnqualIdMap opFuncIds;
+  UnqualIdMap convFuncIds;
+  UnqualIdMap ctorNames;
+  UnqualIdMap dtorNames;
+  std::shared_ptr<UnqualId> unnamedId;
+};
+
+UnqualIdTable::UnqualIdTable() : pimpl(new Impl) {
+}
+
+UnqualIdTable::~UnqualIdTable() = default;
+
+std::shared_ptr<UnqualId>
+UnqualIdTable::getIdent(llvm::StringRef ident) {
+  return intern<UIDIdent>(pimpl->idents, ident);
+}
+
+std::shared_ptr<UnqualId>
+UnqualIdTable::getOpFuncId(llvm::StringRef op) {
+  return intern<OpFuncId>(pimpl->opFuncIds, op);
+}
+
+std::shared_ptr<UnqualId>
+UnqualIdTable::getConvFuncId(llvm::StringRef dtident) {
+  return intern<ConvFuncId>(pimpl->convFuncIds, dtident);
+}
+
+std::shared_ptr<UnqualId>
+UnqualIdTable::getCtorName(llvm::StringRef dtident) {
+  return intern<CtorName>(pimpl->ctorNames, dtident);
+}
+
+std::shared_ptr<UnqualId>
+UnqualIdTable::getDtorName(llvm::StringRef dtident) {
+  return intern<DtorName>(pimpl->dtorNames, dtident);
+}
+
+std::shared_ptr<UnqualId>
+UnqualIdTable::getUnnamedId() {
+  if (!pimpl->unnamedId) {
+    pimpl->unnamedId = std::make_shared<UnnamedId>();
+  }
+  return pimpl->unnamedId;
+}
+
 } // namespace XcodeMl
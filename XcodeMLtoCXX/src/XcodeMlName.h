@@ -1,6 +1,10 @@
 #ifndef XCODEMLNAME_H
 #define XCODEMLNAME_H
 
+namespace llvm {
+class StringRef;
+} // namespace llvm
+
 namespace XcodeMl {
 
 class TypeTable;
@@ -78,7 +82,8 @@ protected:
   UIDIdent(const UIDIdent &) = default;
 
 private:
-  std::string ident;
+  /*! The token of the identifier, shared by every use of it */
+  CodeFragment token;
 };
 
 /*! \brief Represents C++ _operator-function-id_. */
@@ -158,6 +163,31 @@ protected:
   UnnamedId(const UnnamedId &) = default;
 };
 
+/*!
+ * \brief Interns unqualified-ids: every occurrence of the same kind and
+ * spelling of name gets the same immutable UnqualId object, made the
+ * first time it is asked for.
+ */
+class UnqualIdTable {
+public:
+  UnqualIdTable();
+  ~UnqualIdTable();
+  UnqualIdTable(const UnqualIdTable &) = delete;
+  UnqualIdTable &operator=(const UnqualIdTable &) = delete;
+
+  std::shared_ptr<UnqualId> getIdent(llvm::StringRef ident);
+  /*! \brief Returns the operator-function-id `operator` + \c op. */
+  std::shared_ptr<UnqualId> getOpFuncId(llvm::StringRef op);
+  std::shared_ptr<UnqualId> getConvFuncId(llvm::StringRef dtident);
+  std::shared_ptr<UnqualId> getCtorName(llvm::StringRef dtident);
+  std::shared_ptr<UnqualId> getDtorName(llvm::StringRef dtident);
+  std::shared_ptr<UnqualId> getUnnamedId();
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> pimpl;
+};
+
 } // namespace XcodeMl
 
 #endif /*! XCODEMLNAME_H */
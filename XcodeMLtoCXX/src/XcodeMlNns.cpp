@@ -1,6 +1,7 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include "llvm/ADT/Optional.h"
@@ -41,17 +42,26 @@ Nns::getKind() const {
 
 CodeFragment
 Nns::makeDeclaration(const TypeTable &env, const NnsTable &nnss) const {
-  const auto par = getParent();
-  if (!par.hasValue()) {
-    return makeNestedNameSpec(env, nnss);
+  if (const auto memo = nnss.getMemoizedSpec(ident)) {
+    return *memo;
   }
-  const auto p = getOrNull(nnss, *par);
-  if (!p.hasValue()) {
-    std::cerr << "Undefined NNS: '" << *par << "'" << std::endl;
-    std::abort();
+  const auto &chain = nnss.getParentChain(ident);
+  // Find the innermost prefix whose representation is already known
+  // and extend it one NNS at a time.
+  auto first = chain.size();
+  CodeFragment spec = CXXCodeGen::makeVoidNode();
+  while (first > 0) {
+    if (const auto memo = nnss.getMemoizedSpec(chain[first - 1]->ident)) {
+      spec = *memo;
+      break;
+    }
+    --first;
   }
-  const auto prefix = (*p)->makeDeclaration(env, nnss);
-  return prefix + makeNestedNameSpec(env, nnss);
+  for (auto i = first; i < chain.size(); ++i) {
+    spec = spec + chain[i]->makeNestedNameSpec(env, nnss);
+    nnss.memoizeSpec(chain[i]->ident, spec);
+  }
+  return spec;
 }
 
 llvm::Optional<NnsIdent>
@@ -102,8 +112,10 @@ CodeFragment
 ClassNns::makeNestedNameSpec(
     const TypeTable &env, const NnsTable &nnsTable) const {
   const auto T = env.at(dtident);
-  const auto classT = llvm::cast<XcodeMl::ClassType>(T.get());
-  assert(classT);
+  const auto classT = llvm::dyn_cast<XcodeMl::ClassType>(T.get());
+  if (!classT) {
+    throw std::runtime_error("NNS of '" + dtident + "' is not a class");
+  }
   if (const auto tid = classT->getAsTemplateId(env, nnsTable)) {
     return *tid + makeTokenNode("::");
   }
@@ -222,4 +234,60 @@ makeOtherNns(const NnsIdent &nident) {
   return std::make_shared<OtherNns>(nident);
 }
 
+NnsTable::NnsTable(
+    std::initializer_list<std::pair<const NnsIdent, NnsRef>> definitions)
+    : map(definitions), chains(), specs() {
+}
+
+const NnsRef &
+NnsTable::at(const NnsIdent &ident) const {
+  const auto iter = map.find(ident);
+  if (iter == map.end()) {
+    throw std::out_of_range(
+        "NNS '" + ident + "' not found in XcodeMl::NnsTable");
+  }
+  return iter->second;
+}
+
+bool
+NnsTable::exists(const NnsIdent &ident) const {
+  return map.find(ident) != map.end();
+}
+
+void
+NnsTable::define(const NnsIdent &ident, const NnsRef &nns) {
+  if (exists(ident)) {
+    // The NNSs whose prefix contains `ident` are now stale.
+    chains.clear();
+    specs.clear();
+  }
+  map[ident] = nns;
+}
+
+const std::vector<NnsRef> &
+NnsTable::getParentChain(const NnsIdent &ident) const {
+  const auto iter = chains.find(ident);
+  if (iter != chains.end()) {
+    return iter->second;
+  }
+  const auto &nns = at(ident);
+  const auto parent = nns->getParent();
+  std::vector<NnsRef> chain;
+  if (parent.hasValue()) {
+    chain = getParentChain(*parent);
+  }
+  chain.push_back(nns);
+  return chains[ident] = chain;
+}
+
+llvm::Optional<CodeFragment>
+NnsTable::getMemoizedSpec(const NnsIdent &ident) const {
+  return getOrNull(specs, ident);
+}
+
+void
+NnsTable::memoizeSpec(const NnsIdent &ident, const CodeFragment &spec) const {
+  specs[ident] = spec;
+}
+
 } // namespace XcodeMl
@@ -14,7 +14,7 @@ class TypeTable;
 
 using NnsIdent = std::string;
 
-using NnsTable = std::map<NnsIdent, NnsRef>;
+class NnsTable;
 
 /*!
  * \brief Represents the kinds of XcodeML NNS.
@@ -61,6 +61,7 @@ protected:
   virtual llvm::Optional<NnsIdent> getParent() const;
 
 private:
+  friend class NnsTable;
   llvm::Optional<NnsIdent> parent;
   NnsKind kind;
   NnsIdent ident;
@@ -183,6 +184,46 @@ NnsRef makeUnnamedNamespaceNns(const NnsIdent &nident, const NnsIdent &parent);
 
 NnsRef makeOtherNns(const NnsIdent &nident);
 
+/*!
+ * \brief A mapping from NNS identifiers to XcodeML NNSs.
+ *
+ * An `XcodeMl::NnsTable` object represents one NNS table scope. It
+ * memoizes the source-code representation of NNSs defined in the scope
+ * and their parent chains, so that deeply nested NNSs like
+ * `::a::b::c::detail::` are built only once per scope.
+ */
+class NnsTable {
+public:
+  NnsTable() = default;
+  NnsTable(std::initializer_list<std::pair<const NnsIdent, NnsRef>>);
+  /*!
+   * \brief Returns the NNS corresponding to `ident`.
+   *
+   * \throw std::out_of_range if `ident` is not defined in this table.
+   */
+  const NnsRef &at(const NnsIdent &ident) const;
+  bool exists(const NnsIdent &ident) const;
+  /*!
+   * \brief Defines (or redefines) `ident` as `nns`.
+   *
+   * Redefinition discards the memoized representations.
+   */
+  void define(const NnsIdent &ident, const NnsRef &nns);
+  /*!
+   * \brief Returns the parent chain of `ident`, from the outermost NNS to
+   * the NNS corresponding to `ident` itself.
+   */
+  const std::vector<NnsRef> &getParentChain(const NnsIdent &ident) const;
+  /*! \brief Returns the memoized representation of `ident`, if any. */
+  llvm::Optional<CodeFragment> getMemoizedSpec(const NnsIdent &ident) const;
+  void memoizeSpec(const NnsIdent &ident, const CodeFragment &spec) const;
+
+private:
+  std::map<NnsIdent, NnsRef> map;
+  mutable std::map<NnsIdent, std::vector<NnsRef>> chains;
+  mutable std::map<NnsIdent, CodeFragment> specs;
+};
+
 } // namespace XcodeMl
 
 #endif /* !XCODEMLNNS_H */
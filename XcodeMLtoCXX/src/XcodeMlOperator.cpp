@@ -1,6 +1,7 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include <libxml/debugXML.h>
@@ -70,6 +71,70 @@ const std::map<std::string, std::string> opMap = {
     {"bitNotExpr", "~"},
 };
 
+using CXXCodeGen::Precedence;
+
+const std::map<std::string, Precedence> precedenceMap = {
+    {"postIncrExpr", Precedence::Postfix},
+    {"postDecrExpr", Precedence::Postfix},
+
+    {"preIncrExpr", Precedence::Unary},
+    {"preDecrExpr", Precedence::Unary},
+    {"AddrOfExpr", Precedence::Unary},
+    {"pointerRef", Precedence::Unary},
+    {"unaryPlusExpr", Precedence::Unary},
+    {"unaryMinusExpr", Precedence::Unary},
+    {"logNotExpr", Precedence::Unary},
+    {"bitNotExpr", Precedence::Unary},
+
+    {"memberIndirectRef", Precedence::PointerToMember},
+    {"memberPointerRef", Precedence::PointerToMember},
+
+    {"mulExpr", Precedence::Multiplicative},
+    {"divExpr", Precedence::Multiplicative},
+    {"modExpr", Precedence::Multiplicative},
+    {"plusExpr", Precedence::Additive},
+    {"minusExpr", Precedence::Additive},
+    {"LshiftExpr", Precedence::Shift},
+    {"RshiftExpr", Precedence::Shift},
+    {"logLTExpr", Precedence::Relational},
+    {"logGTExpr", Precedence::Relational},
+    {"logLEExpr", Precedence::Relational},
+    {"logGEExpr", Precedence::Relational},
+    {"logEQExpr", Precedence::Equality},
+    {"logNEQExpr", Precedence::Equality},
+    {"bitAndExpr", Precedence::BitAnd},
+    {"bitXorExpr", Precedence::BitXor},
+    {"bitOrExpr", Precedence::BitOr},
+    {"logAndExpr", Precedence::LogAnd},
+    {"logOrExpr", Precedence::LogOr},
+
+    {"assignExpr", Precedence::Assignment},
+    {"asgPlusExpr", Precedence::Assignment},
+    {"asgMinusExpr", Precedence::Assignment},
+    {"asgMulExpr", Precedence::Assignment},
+    {"asgDivExpr", Precedence::Assignment},
+    {"asgModExpr", Precedence::Assignment},
+    {"asgLshiftExpr", Precedence::Assignment},
+    {"asgRshiftExpr", Precedence::Assignment},
+    {"asgBitAndExpr", Precedence::Assignment},
+    {"asgBitOrExpr", Precedence::Assignment},
+    {"asgBitXorExpr", Precedence::Assignment},
+
+    {"commaExpr", Precedence::Comma},
+};
+
+namespace {
+
+/*!
+ * \brief Returns the precedence just tighter than \c prec.
+ */
+Precedence
+tighter(Precedence prec) {
+  return static_cast<Precedence>(static_cast<int>(prec) - 1);
+}
+
+} // namespace
+
 namespace XcodeMl {
 
 llvm::Optional<std::string>
@@ -77,17 +142,35 @@ OperatorNameToSpelling(const std::string &opName) {
   return getOrNull(opMap, opName);
 }
 
+llvm::Optional<Precedence>
+OperatorNameToPrecedence(const std::string &opName) {
+  return getOrNull(precedenceMap, opName);
+}
+
+XcodeMl::CodeFragment
+makeBinaryOperation(const XcodeMl::CodeFragment &lhs,
+    const XcodeMl::CodeFragment &op,
+    const XcodeMl::CodeFragment &rhs,
+    Precedence prec,
+    bool minimalParens) {
+  if (!minimalParens) {
+    return CXXCodeGen::makeOperationNode(lhs + op + rhs, prec);
+  }
+  // Only the assignment operators are right-associative
+  const bool rightAssoc = prec == Precedence::Assignment;
+  return CXXCodeGen::makeOperationNode(
+      CXXCodeGen::makeOperand(lhs, rightAssoc ? tighter(prec) : prec) + op
+          + CXXCodeGen::makeOperand(rhs, rightAssoc ? prec : tighter(prec)),
+      prec);
+}
+
 XcodeMl::CodeFragment
 makeOpNode(xmlNodePtr operatorNode) {
   const auto opName = getContent(operatorNode);
   const auto op = XcodeMl::OperatorNameToSpelling(opName);
   if (!op.hasValue()) {
-    const auto lineno = xmlGetLineNo(operatorNode);
-    assert(lineno >= 0);
-    std::cerr << "Unknown operator name: '" << opName << "'" << std::endl
-              << "lineno: " << lineno << std::endl;
-    xmlDebugDumpNode(stderr, operatorNode, 0);
-    std::abort();
+    throw std::runtime_error("Unknown operator name: '" + opName
+        + "' at line " + std::to_string(xmlGetLineNo(operatorNode)));
   }
   return CXXCodeGen::makeTokenNode(*op);
 }
@@ -5,6 +5,26 @@ namespace XcodeMl {
 
 llvm::Optional<std::string> OperatorNameToSpelling(const std::string &);
 
+/*!
+ * \brief Returns the precedence of the built-in operator named
+ * \c opName in XcodeML, if it is a unary or binary operator.
+ */
+llvm::Optional<CXXCodeGen::Precedence> OperatorNameToPrecedence(
+    const std::string &opName);
+
+/*!
+ * \brief Make the code of the binary operation \c lhs \c op \c rhs,
+ * whose operator is of precedence \c prec.
+ *
+ * \param minimalParens Whether to put the operands in parentheses only
+ * where the precedence and associativity of \c op require it.
+ */
+XcodeMl::CodeFragment makeBinaryOperation(const XcodeMl::CodeFragment &lhs,
+    const XcodeMl::CodeFragment &op,
+    const XcodeMl::CodeFragment &rhs,
+    CXXCodeGen::Precedence prec,
+    bool minimalParens);
+
 XcodeMl::CodeFragment makeOpNode(xmlNodePtr);
 
 } // namespace XcodeMl
@@ -0,0 +1,273 @@
+#include <libxml/tree.h>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "llvm/ADT/StringRef.h"
+#include "XcodeMlTree.h"
+
+namespace XcodeMl {
+
+namespace {
+
+ElementKind
+kindOf(const std::string &name) {
+  static const std::unordered_map<std::string, ElementKind> kinds = {
+      {"XcodeProgram", ElementKind::XcodeProgram},
+      {"typeTable", ElementKind::TypeTable},
+      {"nnsTable", ElementKind::NnsTable},
+      {"globalSymbols", ElementKind::GlobalSymbols},
+      {"globalDeclarations", ElementKind::GlobalDeclarations},
+      {"symbols", ElementKind::Symbols},
+      {"declarations", ElementKind::Declarations},
+      {"id", ElementKind::Id},
+      {"name", ElementKind::Name},
+      {"clangDecl", ElementKind::ClangDecl},
+      {"clangStmt", ElementKind::ClangStmt},
+      {"clangTypeLoc", ElementKind::ClangTypeLoc},
+      {"clangNestedNameSpecifier", ElementKind::ClangNestedNameSpecifier},
+      {"clangDeclarationNameInfo", ElementKind::ClangDeclarationNameInfo},
+      {"basicType", ElementKind::BasicType},
+      {"pointerType", ElementKind::PointerType},
+      {"functionType", ElementKind::FunctionType},
+      {"arrayType", ElementKind::ArrayType},
+      {"structType", ElementKind::StructType},
+      {"classType", ElementKind::ClassType},
+      {"enumType", ElementKind::EnumType},
+  };
+  const auto it = kinds.find(name);
+  return it == kinds.end() ? ElementKind::Other : it->second;
+}
+
+bool
+hasElementChild(xmlNodePtr node) {
+  for (xmlNodePtr child = node->children; child; child = child->next) {
+    if (child->type == XML_ELEMENT_NODE) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*!
+ * \brief Returns the text of the child nodes \c children (of an
+ * attribute or an element without element children).
+ *
+ * The only text child, the common case, is borrowed; otherwise (e.g.,
+ * entity references) the text is concatenated into \c buffer.
+ */
+llvm::StringRef
+childText(xmlDocPtr doc, xmlNodePtr children, std::string &buffer) {
+  if (!children) {
+    return llvm::StringRef();
+  }
+  if (!children->next
+      && (children->type == XML_TEXT_NODE
+             || children->type == XML_CDATA_SECTION_NODE)) {
+    return llvm::StringRef(reinterpret_cast<const char *>(children->content));
+  }
+  xmlChar *str = children->parent->type == XML_ATTRIBUTE_NODE
+      ? xmlNodeListGetString(doc, children, 1)
+      : xmlNodeGetContent(children->parent);
+  buffer = str ? reinterpret_cast<const char *>(str) : "";
+  xmlFree(str);
+  return buffer;
+}
+
+} // namespace
+
+const uint32_t Tree::npos;
+
+Tree
+Tree::fromXml(xmlNodePtr root) {
+  Tree tree;
+  if (!root) {
+    return tree;
+  }
+  const auto empty = tree.intern("");
+  const auto lineno = tree.intern("lineno");
+  // element kinds by StringId of the element name
+  std::vector<ElementKind> kinds;
+  const auto addNode = [&](xmlNodePtr elem, NodeId parent) {
+    const auto name =
+        tree.intern(reinterpret_cast<const char *>(elem->name));
+    if (name >= kinds.size()) {
+      kinds.resize(name + 1, ElementKind::Other);
+      kinds[name] = kindOf(tree.strings[name]);
+    }
+    tree.nodes.push_back({name, kinds[name], parent, 0, 0, 0, 0, empty, 0});
+  };
+  std::string buffer;
+
+  std::vector<xmlNodePtr> elems(1, root);
+  addNode(root, npos);
+  for (NodeId i = 0; i < elems.size(); ++i) {
+    const auto elem = elems[i];
+    tree.nodes[i].firstAttr = tree.attrs.size();
+    for (xmlAttrPtr attr = elem->properties; attr; attr = attr->next) {
+      const auto key =
+          tree.intern(reinterpret_cast<const char *>(attr->name));
+      const auto value =
+          tree.append(childText(elem->doc, attr->children, buffer));
+      if (key == lineno) {
+        tree.nodes[i].line = std::atoi(tree.strings[value].c_str());
+      }
+      tree.attrs.push_back({key, value});
+    }
+    tree.nodes[i].numAttrs = tree.attrs.size() - tree.nodes[i].firstAttr;
+
+    if (!hasElementChild(elem)) {
+      tree.nodes[i].text =
+          tree.append(childText(elem->doc, elem->children, buffer));
+      continue;
+    }
+    tree.nodes[i].firstChild = elems.size();
+    for (xmlNodePtr child = elem->children; child; child = child->next) {
+      if (child->type == XML_ELEMENT_NODE) {
+        elems.push_back(child);
+        addNode(child, i);
+      }
+    }
+    tree.nodes[i].numChildren = elems.size() - tree.nodes[i].firstChild;
+  }
+  return tree;
+}
+
+xmlNodePtr
+Tree::toXml(xmlDocPtr doc) const {
+  // Nodes are in breadth-first order: every parent is created before
+  // its children, and the children of a node are consecutive.
+  std::vector<xmlNodePtr> elems(nodes.size());
+  for (NodeId i = 0; i < nodes.size(); ++i) {
+    const auto &node = nodes[i];
+    elems[i] = xmlNewDocNode(
+        doc, nullptr, BAD_CAST strings[node.name].c_str(), nullptr);
+    if (node.parent != npos) {
+      xmlAddChild(elems[node.parent], elems[i]);
+    }
+    for (auto j = node.firstAttr; j < node.firstAttr + node.numAttrs; ++j) {
+      xmlNewProp(elems[i],
+          BAD_CAST strings[attrs[j].key].c_str(),
+          BAD_CAST strings[attrs[j].value].c_str());
+    }
+    if (node.numChildren == 0 && !strings[node.text].empty()) {
+      xmlNodeAddContent(elems[i], BAD_CAST strings[node.text].c_str());
+    }
+  }
+  return elems.empty() ? nullptr : elems[0];
+}
+
+size_t
+Tree::size() const {
+  return nodes.size();
+}
+
+Tree::NodeId
+Tree::getRoot() const {
+  return nodes.empty() ? npos : 0;
+}
+
+Tree::NodeId
+Tree::getParent(NodeId node) const {
+  return nodes[node].parent;
+}
+
+Tree::NodeId
+Tree::childBegin(NodeId node) const {
+  return nodes[node].firstChild;
+}
+
+Tree::NodeId
+Tree::childEnd(NodeId node) const {
+  return nodes[node].firstChild + nodes[node].numChildren;
+}
+
+Tree::NodeId
+Tree::findChild(NodeId node, StringId name) const {
+  for (auto child = childBegin(node); child < childEnd(node); ++child) {
+    if (nodes[child].name == name) {
+      return child;
+    }
+  }
+  return npos;
+}
+
+ElementKind
+Tree::getKind(NodeId node) const {
+  return nodes[node].kind;
+}
+
+Tree::StringId
+Tree::getName(NodeId node) const {
+  return nodes[node].name;
+}
+
+const std::string &
+Tree::getText(NodeId node) const {
+  return strings[nodes[node].text];
+}
+
+int
+Tree::getLine(NodeId node) const {
+  return nodes[node].line;
+}
+
+Tree::StringId
+Tree::getAttr(NodeId node, StringId key) const {
+  const auto &n = nodes[node];
+  for (auto i = n.firstAttr; i < n.firstAttr + n.numAttrs; ++i) {
+    if (attrs[i].key == key) {
+      return attrs[i].value;
+    }
+  }
+  return npos;
+}
+
+bool
+Tree::hasAttr(NodeId node, StringId key) const {
+  return getAttr(node, key) != npos;
+}
+
+Tree::StringId
+Tree::lookup(const std::string &str) const {
+  const auto it = stringIds.find(llvm::StringRef(str));
+  return it == stringIds.end() ? npos : it->second;
+}
+
+const std::string &
+Tree::getString(StringId id) const {
+  return strings[id];
+}
+
+Tree::StringId
+Tree::intern(llvm::StringRef str) {
+  const auto it = stringIds.find(str);
+  if (it != stringIds.end()) {
+    return it->second;
+  }
+  // the keys refer to the strings, which a deque never moves
+  const StringId id = strings.size();
+  strings.push_back(str.str());
+  stringIds.emplace(strings.back(), id);
+  return id;
+}
+
+Tree::StringId
+Tree::append(llvm::StringRef str) {
+  strings.push_back(str.str());
+  return strings.size() - 1;
+}
+
+size_t
+Tree::StringRefHash::operator()(llvm::StringRef str) const {
+  // FNV-1a
+  uint64_t hash = 14695981039346656037ull;
+  for (const char c : str) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+  }
+  return hash;
+}
+
+} // namespace XcodeMl
@@ -0,0 +1,117 @@
+#ifndef XCODEMLTREE_H
+#define XCODEMLTREE_H
+
+namespace XcodeMl {
+
+/*!
+ * \brief Integer tags of the XcodeML elements the translators look at;
+ * every other element is tagged \c Other and keeps its name.
+ */
+enum class ElementKind : uint16_t {
+  Other,
+  XcodeProgram,
+  TypeTable,
+  NnsTable,
+  GlobalSymbols,
+  GlobalDeclarations,
+  Symbols,
+  Declarations,
+  Id,
+  Name,
+  ClangDecl,
+  ClangStmt,
+  ClangTypeLoc,
+  ClangNestedNameSpecifier,
+  ClangDeclarationNameInfo,
+  BasicType,
+  PointerType,
+  FunctionType,
+  ArrayType,
+  StructType,
+  ClassType,
+  EnumType,
+};
+
+/*!
+ * \brief A compact, read-only copy of an XcodeML element tree.
+ *
+ * Nodes live in one contiguous vector in breadth-first order, so the
+ * children of a node form the index range [childBegin, childEnd).
+ * Element names and attribute keys are interned into a string table
+ * shared by the whole tree, so that they can be compared as integers;
+ * attribute values and texts are added to the same table as they are,
+ * since most of them (type and NNS ids) occur once per table. Line
+ * numbers are decoded once, when the tree is built.
+ *
+ * Conversion from and to libxml2 happens only at the edges
+ * (\c fromXml and \c toXml); comments and whitespace between
+ * elements are not kept.
+ */
+class Tree {
+public:
+  using NodeId = uint32_t;
+  using StringId = uint32_t;
+  static const uint32_t npos = ~0u;
+
+  /*! \brief Copy the element \c root and its descendants. */
+  static Tree fromXml(xmlNodePtr root);
+  /*! \brief Rebuild the tree as a libxml2 element of \c doc. */
+  xmlNodePtr toXml(xmlDocPtr doc) const;
+
+  size_t size() const;
+  NodeId getRoot() const;
+  NodeId getParent(NodeId) const;
+  NodeId childBegin(NodeId) const;
+  NodeId childEnd(NodeId) const;
+  /*! \brief Returns the first child named \c name, or npos. */
+  NodeId findChild(NodeId, StringId name) const;
+
+  ElementKind getKind(NodeId) const;
+  StringId getName(NodeId) const;
+  /*! \brief Returns the text of an element without element children. */
+  const std::string &getText(NodeId) const;
+  /*! \brief Returns the value of the lineno attribute, or 0. */
+  int getLine(NodeId) const;
+
+  /*! \brief Returns the value of attribute \c key, or npos. */
+  StringId getAttr(NodeId, StringId key) const;
+  bool hasAttr(NodeId, StringId key) const;
+
+  /*!
+   * \brief Returns the id of the element name or attribute key \c str,
+   * or npos if the tree lacks it.
+   */
+  StringId lookup(const std::string &str) const;
+  const std::string &getString(StringId) const;
+
+private:
+  struct Node {
+    StringId name;
+    ElementKind kind;
+    NodeId parent;
+    NodeId firstChild;
+    uint32_t numChildren;
+    uint32_t firstAttr;
+    uint32_t numAttrs;
+    StringId text;
+    int line;
+  };
+  struct Attr {
+    StringId key;
+    StringId value;
+  };
+  struct StringRefHash {
+    size_t operator()(llvm::StringRef) const;
+  };
+  StringId intern(llvm::StringRef);
+  StringId append(llvm::StringRef);
+
+  std::vector<Node> nodes;
+  std::vector<Attr> attrs;
+  std::deque<std::string> strings;
+  std::unordered_map<llvm::StringRef, StringId, StringRefHash> stringIds;
+};
+
+} // namespace XcodeMl
+
+#endif /* !XCODEMLTREE_H */
@@ -1,6 +1,7 @@
 #include <cassert>
 #include <memory>
 #include <map>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include "llvm/ADT/Optional.h"
@@ -168,6 +169,16 @@ QualifiedType::classof(const Type *T) {
   return T->getKind() == TypeKind::Qualified;
 }
 
+bool
+QualifiedType::isConstQualified() const {
+  return isConst;
+}
+
+DataTypeIdent
+QualifiedType::getUnderlyingType() const {
+  return underlying;
+}
+
 QualifiedType::QualifiedType(const QualifiedType &other)
     : Type(other),
       underlying(other.underlying),
@@ -234,11 +245,18 @@ MemberPointer::classof(const Type *T) {
 CodeFragment
 MemberPointer::makeDeclaration(
     CodeFragment var, const TypeTable &typeTable, const NnsTable &nnsTable) {
-  const auto classTypeName = makeDecl(
-      typeTable.at(record), CXXCodeGen::makeVoidNode(), typeTable, nnsTable);
-  const auto innerDecl =
-    makeTokenNode("(")+wrapWithXcodeMlIdentity(classTypeName)
-    + makeTokenNode("::*") + var + makeTokenNode(")");
+  const auto recordT = typeTable.at(record);
+  // `int (S::*pm)`, but `int (__xcodeml_identity<...>::*pm)` unless
+  // the class can be named without its class-key
+  const auto spec = makeSimpleTypeSpecifier(recordT, typeTable, nnsTable);
+  const auto classTypeName = spec
+      ? *spec
+      : wrapWithXcodeMlIdentity(makeDecl(recordT,
+            CXXCodeGen::makeVoidNode(),
+            typeTable,
+            nnsTable));
+  const auto innerDecl = makeTokenNode("(") + classTypeName
+      + makeTokenNode("::*") + var + makeTokenNode(")");
 
   const auto pointeeT = typeTable.at(pointee);
   return makeDecl(pointeeT, innerDecl, typeTable, nnsTable);
@@ -322,7 +340,9 @@ CodeFragment
 ParamList::makeDeclaration(const std::vector<CodeFragment> &paramNames,
     const TypeTable &typeTable,
     const NnsTable &nnsTable) const {
-  assert(dtidents.size() == paramNames.size());
+  if (dtidents.size() != paramNames.size()) {
+    throw std::runtime_error("Parameter names do not match the types");
+  }
   std::vector<CodeFragment> decls;
   for (int i = 0, len = dtidents.size(); i < len; ++i) {
     const auto ithType = typeTable.at(dtidents[i]);
@@ -718,19 +738,21 @@ getClassKey(CXXClassKind kind) {
 CodeFragment
 ClassType::makeDeclaration(
     CodeFragment var, const TypeTable &typeTable, const NnsTable &nnsTable) {
+  return makeTokenNode(getClassKey(classKind()))
+      + makeQualifiedName(typeTable, nnsTable) + var;
+}
+
+CodeFragment
+ClassType::makeQualifiedName(
+    const TypeTable &typeTable, const NnsTable &nnsTable) const {
+  const auto tid = getAsTemplateId(typeTable, nnsTable);
   if (!nnsident.hasValue()) {
     assert(name_);
-    if (const auto tid = getAsTemplateId(typeTable, nnsTable)) {
-      return makeTokenNode(getClassKey(classKind())) + *tid + var;
-    }
-    return makeTokenNode(getClassKey(classKind())) + name_ + var;
+    return tid ? *tid : name_;
   }
   const auto nns = nnsTable.at(*nnsident);
   const auto spec = nns->makeDeclaration(typeTable, nnsTable);
-  if (const auto tid = getAsTemplateId(typeTable, nnsTable)) {
-    return makeTokenNode(getClassKey(classKind())) + spec + *tid + var;
-  }
-  return makeTokenNode(getClassKey(classKind())) + spec + name_ + var;
+  return spec + (tid ? *tid : name_);
 }
 
 Type *
@@ -1283,6 +1305,66 @@ getPointee(const TypeRef &type, const TypeTable &env) {
 
 } // namespace
 
+llvm::Optional<CodeFragment>
+makeSimpleTypeSpecifier(
+    const TypeRef &type, const TypeTable &env, const NnsTable &nnsTable) {
+  using MaybeCodeFragment = llvm::Optional<CodeFragment>;
+  if (!type || type->isConst() || type->isVolatile()) {
+    return MaybeCodeFragment();
+  }
+  switch (type->getKind()) {
+  case TypeKind::Reserved: {
+    // `int` but not `unsigned int`
+    const auto name = makeDecl(type, makeVoidNode(), env, nnsTable);
+    const auto spelling = CXXCodeGen::to_string(name);
+    if (spelling.empty() || spelling.find(' ') != std::string::npos) {
+      return MaybeCodeFragment();
+    }
+    return MaybeCodeFragment(name);
+  }
+  case TypeKind::Class: {
+    const auto classT = llvm::cast<ClassType>(type.get());
+    if (!classT->name()) {
+      return MaybeCodeFragment();
+    }
+    return MaybeCodeFragment(classT->makeQualifiedName(env, nnsTable));
+  }
+  case TypeKind::TemplateTypeParm: {
+    const auto paramT = llvm::cast<TemplateTypeParm>(type.get());
+    if (paramT->isPack() || !paramT->getSpelling().hasValue()) {
+      return MaybeCodeFragment();
+    }
+    return paramT->getSpelling();
+  }
+  default: return MaybeCodeFragment();
+  }
+}
+
+bool
+isPlainTypeId(const TypeRef &type, const TypeTable &env) {
+  if (!type) {
+    return false;
+  }
+  switch (type->getKind()) {
+  case TypeKind::Reserved:
+  case TypeKind::Class:
+  case TypeKind::Enum:
+  case TypeKind::TemplateTypeParm:
+  case TypeKind::TemplateSpecialization:
+  case TypeKind::DependentName: return true;
+
+  case TypeKind::Qualified: {
+    const auto underlying =
+        llvm::cast<QualifiedType>(type.get())->getUnderlyingType();
+    return isPlainTypeId(env.at(underlying), env);
+  }
+  case TypeKind::Pointer:
+    return isPlainTypeId(getPointee<Pointer>(type, env), env);
+
+  default: return false;
+  }
+}
+
 bool
 hasParen(const TypeRef &type, const TypeTable &env) {
   return llvm::isa<Function>(type.get());
@@ -177,6 +177,9 @@ public:
   ~QualifiedType() override;
   Type *clone() const override;
   static bool classof(const Type *);
+  /*! Returns true if this adds `const` to the underlying type. */
+  bool isConstQualified() const;
+  DataTypeIdent getUnderlyingType() const;
 
 protected:
   QualifiedType(const QualifiedType &);
@@ -485,6 +488,12 @@ public:
   bool isClassTemplateSpecialization() const;
   llvm::Optional<CodeFragment> getAsTemplateId(
       const TypeTable &typeTable, const NnsTable &nnsTable) const;
+  /*!
+   * \brief Returns the (qualified) name of this class without its
+   * class-key, e.g. `::a::S<int>`.
+   */
+  CodeFragment makeQualifiedName(
+      const TypeTable &typeTable, const NnsTable &nnsTable) const;
   static bool classof(const Type *);
   xmlNodePtr getNode(){ return reinterpret_cast<xmlNodePtr>(node);};
 protected:
@@ -678,5 +687,24 @@ TypeRef makeAtomicType(const DataTypeIdent &, const DataTypeIdent &);
 TypeRef makePackExpansionType(const DataTypeIdent &, const DataTypeIdent &);
 TypeRef makeUnaryTransformType(const DataTypeIdent &, const DataTypeIdent &);
 bool hasParen(const TypeRef &, const TypeTable &);
+
+/*!
+ * \brief Returns the spelling of \c type as a simple-type-specifier,
+ * the only form of types allowed in the functional cast `T(x)` and
+ * before `::`, or llvm::None if it has none (e.g. `unsigned int`,
+ * `const T` or `int *`).
+ *
+ * A class type is spelled without its class-key, so its name may be
+ * hidden by a variable or function of the same name.
+ */
+llvm::Optional<CodeFragment> makeSimpleTypeSpecifier(
+    const TypeRef &type, const TypeTable &, const NnsTable &);
+
+/*!
+ * \brief Returns true if the abstract declarator of \c type needs no
+ * parentheses or brackets, so that it can be a new-type-id as it is
+ * (`int *` but not `int (*)[3]`).
+ */
+bool isPlainTypeId(const TypeRef &type, const TypeTable &);
 }
 #endif /* !XCODEMLTYPE_H */
@@ -3,12 +3,15 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 #include <libxml/debugXML.h>
 #include <libxml/tree.h>
 #include <libxml/xpath.h>
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Casting.h"
 #include "LibXMLUtil.h"
 #include "StringTree.h"
@@ -28,7 +31,7 @@
 
 std::shared_ptr<XcodeMl::UnqualId>
 getUnqualIdFromNameNode(xmlNodePtr nameNode) {
-  const auto kind = getProp(nameNode, "name_kind");
+  const auto kind = getPropRef(nameNode, "name_kind");
 
   if (kind == "constructor") {
     const auto dtident = getProp(nameNode, "ctor_type");
@@ -39,18 +42,48 @@ getUnqualIdFromNameNode(xmlNodePtr nameNode) {
   } else if (kind == "operator") {
     const auto opName = getContent(nameNode);
     const auto pOpId = XcodeMl::OperatorNameToSpelling(opName);
-    assert(pOpId.hasValue());
+    if (!pOpId.hasValue()) {
+      throw std::runtime_error("Unknown operator name: '" + opName + "'");
+    }
     return std::make_shared<XcodeMl::OpFuncId>(*pOpId);
   } else if (kind == "conversion") {
     const auto dtident = getProp(nameNode, "destination_type");
     return std::make_shared<XcodeMl::ConvFuncId>(dtident);
   }
 
-  assert(kind == "name");
+  if (kind != "name") {
+    throw std::runtime_error("Unknown name_kind: '" + kind.str() + "'");
+  }
   const auto name = getContent(nameNode);
   return std::make_shared<XcodeMl::UIDIdent>(name);
 }
 
+std::shared_ptr<XcodeMl::UnqualId>
+getUnqualIdFromNameNode(xmlNodePtr nameNode, const SourceInfo &src) {
+  auto &ids = *src.unqualIds;
+  const auto kind = getPropRef(nameNode, "name_kind");
+
+  if (kind == "constructor") {
+    return ids.getCtorName(getPropRef(nameNode, "ctor_type"));
+  } else if (kind == "destructor") {
+    return ids.getDtorName(getPropRef(nameNode, "dtor_type"));
+  } else if (kind == "operator") {
+    const auto opName = getContent(nameNode);
+    const auto pOpId = XcodeMl::OperatorNameToSpelling(opName);
+    if (!pOpId.hasValue()) {
+      throw std::runtime_error("Unknown operator name: '" + opName + "'");
+    }
+    return ids.getOpFuncId(*pOpId);
+  } else if (kind == "conversion") {
+    return ids.getConvFuncId(getPropRef(nameNode, "destination_type"));
+  }
+
+  if (kind != "name") {
+    throw std::runtime_error("Unknown name_kind: '" + kind.str() + "'");
+  }
+  return ids.getIdent(getContentRef(nameNode));
+}
+
 std::shared_ptr<XcodeMl::UnqualId>
 getUnqualIdFromIdNode(xmlNodePtr idNode, xmlXPathContextPtr ctxt) {
   if (!idNode) {
@@ -64,11 +97,26 @@ getUnqualIdFromIdNode(xmlNodePtr idNode, xmlXPathContextPtr ctxt) {
   return getUnqualIdFromNameNode(nameNode);
 }
 
+std::shared_ptr<XcodeMl::UnqualId>
+getUnqualIdFromIdNode(xmlNodePtr idNode, const SourceInfo &src) {
+  if (!idNode) {
+    throw std::domain_error("expected id node, but got null");
+  }
+  xmlNodePtr nameNode = findFirst(idNode, "name", src.ctxt);
+  if (!nameNode) {
+    return src.unqualIds->getUnnamedId();
+  }
+  return getUnqualIdFromNameNode(nameNode, src);
+}
+
 XcodeMl::Name
 getQualifiedName(xmlNodePtr node, const SourceInfo &src) {
   const auto nameNode = findFirst(node, "name", src.ctxt);
-  assert(nameNode);
-  const auto unqualId = getUnqualIdFromNameNode(nameNode);
+  if (!nameNode) {
+    throw std::runtime_error(
+        "name not found at " + to_string(getXcodeMlPath(node)));
+  }
+  const auto unqualId = getUnqualIdFromNameNode(nameNode, src);
 
   const auto nameSpecNode =
       findFirst(node, "clangNestedNameSpecifier", src.ctxt);
@@ -120,8 +168,7 @@ getParamNames(xmlNodePtr fnNode, const SourceInfo &src) {
   const auto params = findNodes(
       fnNode, "clangTypeLoc/clangDecl[@class='ParmVar']/name", src.ctxt);
   for (auto p : params) {
-    XMLString name = xmlNodeGetContent(p);
-    vec.push_back(CXXCodeGen::makeTokenNode(name));
+    vec.push_back(CXXCodeGen::makeTokenNode(getContentRef(p).str()));
   }
   return vec;
 }
@@ -176,6 +223,9 @@ makeFunctionDeclHead(xmlNodePtr node,
   auto acc = isTrueProp(node, "is_function_template_specialization", false)
       ? CXXCodeGen::makeTokenNode("template <>")
       : CXXCodeGen::makeVoidNode();
+  if (isTrueProp(node, "is_inline", false)) {
+    acc = acc + CXXCodeGen::makeTokenNode("inline");
+  }
   acc = acc + makeFunctionDeclHead(fnType,
                   name,
                   paramNames,
@@ -240,3 +290,10 @@ std::ostream &operator<<(std::ostream &os, const XcodeMlPwdType &x) {
   xcodeMlPwd(x.node, os);
   return os;
 }
+
+std::string
+to_string(const XcodeMlPwdType &x) {
+  std::stringstream ss;
+  xcodeMlPwd(x.node, ss);
+  return ss.str();
+}
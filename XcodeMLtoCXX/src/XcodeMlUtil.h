@@ -10,9 +10,20 @@ class SourceInfo;
 
 std::shared_ptr<XcodeMl::UnqualId> getUnqualIdFromNameNode(xmlNodePtr idNode);
 
+/*!
+ * \brief Returns the unqualified-id of the name element \c nameNode,
+ * shared with the other occurrences of the name in the document of
+ * \c src.
+ */
+std::shared_ptr<XcodeMl::UnqualId> getUnqualIdFromNameNode(
+    xmlNodePtr nameNode, const SourceInfo &src);
+
 std::shared_ptr<XcodeMl::UnqualId> getUnqualIdFromIdNode(
     xmlNodePtr nameNode, xmlXPathContextPtr ctxt);
 
+std::shared_ptr<XcodeMl::UnqualId> getUnqualIdFromIdNode(
+    xmlNodePtr idNode, const SourceInfo &src);
+
 XcodeMl::Name getQualifiedName(xmlNodePtr node, const SourceInfo &);
 
 std::string getType(xmlNodePtr node);
@@ -47,4 +58,6 @@ XcodeMl::CodeFragment wrapWithLangLink(const XcodeMl::CodeFragment &content,
 
 std::ostream &operator<<(std::ostream &, const XcodeMlPwdType &);
 
+std::string to_string(const XcodeMlPwdType &);
+
 #endif /* !XCODEMLUTIL_H */
@@ -103,5 +103,20 @@ BOOST_AUTO_TEST_CASE(space_interleaving_test) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(line_directive_test) {
+  BOOST_TEST_CHECKPOINT("A new position is emitted on a line of its own");
+  stream.setLineInfo("a.cpp", 3);
+  stream << "int" << "x;";
+  stream.setLineInfo("a.cpp", 3);
+  stream << "int" << "y;";
+  stream.setLineInfo("b \"c\".h", 10);
+  stream << "int" << "z;" << cxxgen::newline;
+  BOOST_CHECK_EQUAL(stream.str(),
+      "#line 3 \"a.cpp\"\n"
+      "int x;int y;\n"
+      "#line 10 \"b \\\"c\\\".h\"\n"
+      "int z;\n");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 }
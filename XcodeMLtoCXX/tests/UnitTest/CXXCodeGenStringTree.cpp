@@ -0,0 +1,90 @@
+#define BOOST_TEST_MODULE CXXCodeGen::StringTree
+#include <boost/test/included/unit_test.hpp>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Stream.h"
+#include "StringTree.h"
+
+namespace cxxgen = CXXCodeGen;
+
+namespace {
+
+BOOST_AUTO_TEST_SUITE(cxxgen_stringtree)
+
+BOOST_AUTO_TEST_CASE(nested_inner_node_test) {
+  BOOST_TEST_CHECKPOINT("InnerNode flushes its descendants in order");
+
+  const auto inner = cxxgen::makeInnerNode({cxxgen::makeTokenNode("b"),
+      cxxgen::makeInnerNode({}),
+      cxxgen::makeInnerNode({cxxgen::makeTokenNode("c")})});
+  const auto tree = cxxgen::makeInnerNode(
+      {cxxgen::makeTokenNode("a"), inner, cxxgen::makeTokenNode("d")});
+  BOOST_CHECK(cxxgen::to_string(tree) == "a b c d");
+}
+
+BOOST_AUTO_TEST_CASE(deep_inner_node_test) {
+  BOOST_TEST_CHECKPOINT("InnerNode flushes deeply nested descendants");
+
+  const long depth = 10000;
+  auto tree = cxxgen::makeTokenNode("x");
+  for (long i = 0; i < depth; ++i) {
+    tree = cxxgen::makeInnerNode({cxxgen::makeTokenNode("("),
+        tree,
+        cxxgen::makeTokenNode(")")});
+  }
+  const auto str = cxxgen::to_string(tree);
+  BOOST_CHECK(str.find('x') != std::string::npos);
+  BOOST_CHECK(std::count(str.begin(), str.end(), '(') == depth);
+  BOOST_CHECK(std::count(str.begin(), str.end(), ')') == depth);
+  BOOST_CHECK(str.front() == '(' && str.back() == ')');
+}
+
+BOOST_AUTO_TEST_CASE(operation_node_test) {
+  BOOST_TEST_CHECKPOINT("OperationNode is output in parentheses");
+
+  using cxxgen::Precedence;
+  const auto a = cxxgen::makeTokenNode("a");
+  const auto b = cxxgen::makeTokenNode("b");
+  const auto sum = cxxgen::makeOperationNode(
+      a + cxxgen::makeTokenNode("+") + b, Precedence::Additive);
+  BOOST_CHECK(cxxgen::to_string(sum) == "(a+b)");
+  BOOST_CHECK(cxxgen::to_string(sum + a) == "(a+b)a");
+
+  BOOST_TEST_CHECKPOINT("makeOperand drops redundant parentheses");
+  BOOST_CHECK(cxxgen::to_string(
+                  cxxgen::makeOperand(sum, Precedence::Additive))
+      == "a+b");
+  BOOST_CHECK(cxxgen::to_string(
+                  cxxgen::makeOperand(sum, Precedence::Multiplicative))
+      == "(a+b)");
+  // through inner nodes that contain nothing but the operation
+  const auto wrapped =
+      cxxgen::makeInnerNode({cxxgen::makeVoidNode() + sum});
+  BOOST_CHECK(cxxgen::to_string(
+                  cxxgen::makeOperand(wrapped, Precedence::Comma))
+      == "a+b");
+  BOOST_CHECK(cxxgen::to_string(
+                  cxxgen::makeOperand(a + b, Precedence::Primary))
+      == "a b");
+
+  BOOST_TEST_CHECKPOINT("makeEnclosedOperand encloses unknown code");
+  BOOST_CHECK(cxxgen::to_string(
+                  cxxgen::makeEnclosedOperand(a, Precedence::Primary))
+      == "a");
+  BOOST_CHECK(cxxgen::to_string(cxxgen::makeEnclosedOperand(
+                  cxxgen::makeTokenNode("1.5"), Precedence::Primary))
+      == "1.5");
+  BOOST_CHECK(cxxgen::to_string(cxxgen::makeEnclosedOperand(
+                  cxxgen::makeTokenNode("-1"), Precedence::Primary))
+      == "(-1)");
+  BOOST_CHECK(cxxgen::to_string(
+                  cxxgen::makeEnclosedOperand(sum, Precedence::Unary))
+      == "(a+b)");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace
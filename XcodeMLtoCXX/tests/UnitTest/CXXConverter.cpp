@@ -0,0 +1,71 @@
+#define BOOST_TEST_MODULE CXXConverter
+#include <boost/test/included/unit_test.hpp>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <libxml/tree.h>
+
+#include "CXXConverter.h"
+
+namespace {
+
+/*! \brief Returns a program that declares \c x of type \c type. */
+std::string
+program(const std::string &type) {
+  return std::string("<clangAST source=\"t.cpp\" language=\"C++\">")
+      + "<clangDecl class=\"TranslationUnit\">"
+      + "<xcodemlTypeTable>"
+      + "<pointerType type=\"Pointer0\" ref=\"int\"/>"
+      + "</xcodemlTypeTable>"
+      + "<xcodemlNnsTable>"
+      + "<namespaceNNS nns=\"NNS0\" parent=\"global\">a</namespaceNNS>"
+      + "</xcodemlNnsTable>"
+      + "<clangDecl class=\"Namespace\"><name name_kind=\"name\">a</name>"
+      + "<clangDecl class=\"Var\" xcodemlType=\"" + type + "\">"
+      + "<name name_kind=\"name\">x</name></clangDecl>"
+      + "</clangDecl>"
+      + "</clangDecl></clangAST>";
+}
+
+std::string
+convert(const std::string &content) {
+  std::stringstream ss;
+  convertXcodeMlToCXX(content.c_str(), content.size(), ss);
+  return ss.str();
+}
+
+BOOST_AUTO_TEST_SUITE(cxx_converter)
+
+BOOST_AUTO_TEST_CASE(buffer_test) {
+  BOOST_TEST_CHECKPOINT("A document in memory is converted");
+  BOOST_CHECK_EQUAL(
+      convert(program("Pointer0")), "namespace a{int(*x);\n}\n\n");
+
+  BOOST_TEST_CHECKPOINT("Only the given size of the buffer is read");
+  const char garbage[] = "<garbage";
+  const auto content = program("int") + garbage;
+  std::stringstream ss;
+  convertXcodeMlToCXX(
+      content.c_str(), content.size() - std::strlen(garbage), ss);
+  BOOST_CHECK_EQUAL(ss.str(), "namespace a{int x;\n}\n\n");
+}
+
+BOOST_AUTO_TEST_CASE(malformed_test) {
+  BOOST_TEST_CHECKPOINT("Malformed XML throws");
+  BOOST_CHECK_THROW(convert("<clangAST><clangDecl>"), std::runtime_error);
+  BOOST_CHECK_THROW(convert(""), std::runtime_error);
+
+  BOOST_TEST_CHECKPOINT("A reference to a missing type throws");
+  BOOST_CHECK_THROW(convert(program("Pointer1")), std::out_of_range);
+
+  BOOST_TEST_CHECKPOINT("A missing element throws");
+  auto noName = program("int");
+  const std::string name = "<name name_kind=\"name\">x</name>";
+  noName.replace(noName.find(name), name.size(), "");
+  BOOST_CHECK_THROW(convert(noName), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace
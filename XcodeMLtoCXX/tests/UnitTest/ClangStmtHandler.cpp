@@ -0,0 +1,99 @@
+#define BOOST_TEST_MODULE ClangStmtHandler
+#include <boost/test/included/unit_test.hpp>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include <libxml/xpath.h>
+#include "llvm/ADT/Optional.h"
+
+#include "Stream.h"
+#include "StringTree.h"
+#include "XMLString.h"
+#include "XcodeMlNns.h"
+#include "XcodeMlType.h"
+#include "XcodeMlTypeTable.h"
+#include "XMLWalker.h"
+#include "SourceInfo.h"
+#include "CodeBuilder.h"
+
+namespace {
+
+/*!
+ * \brief Returns the code of the array \c t of \c size elements
+ * initialized with \c init (a <clangStmt class="InitListExpr">).
+ */
+std::string
+buildArray(const std::string &size, const std::string &init) {
+  const std::string content =
+      std::string("<clangAST source=\"t.cpp\" language=\"C++\">")
+      + "<clangDecl class=\"TranslationUnit\">"
+      + "<xcodemlTypeTable>"
+      + "<arrayType type=\"Array0\" element_type=\"int\" array_size=\"" + size
+      + "\"/>"
+      + "</xcodemlTypeTable>"
+      + "<xcodemlNnsTable/>"
+      + "<clangDecl class=\"Var\" xcodemlType=\"Array0\">"
+      + "<name name_kind=\"name\">t</name>" + init + "</clangDecl>"
+      + "</clangDecl></clangAST>";
+  const auto doc = xmlReadMemory(
+      content.c_str(), content.size(), "t.xml", nullptr, 0);
+  BOOST_REQUIRE(doc);
+  const auto ctxt = xmlXPathNewContext(doc);
+  std::stringstream ss;
+  buildCode(xmlDocGetRootElement(doc), ctxt, ss);
+  xmlXPathFreeContext(ctxt);
+  xmlFreeDoc(doc);
+  return ss.str();
+}
+
+BOOST_AUTO_TEST_SUITE(clang_stmt_handler)
+
+BOOST_AUTO_TEST_CASE(init_list_test) {
+  BOOST_TEST_CHECKPOINT("Each element is converted");
+  BOOST_CHECK_EQUAL(
+      buildArray("2",
+          "<clangStmt class=\"InitListExpr\" xcodemlType=\"Array0\">"
+          "<clangStmt class=\"IntegerLiteral\" token=\"1\"/>"
+          "<clangStmt class=\"IntegerLiteral\" token=\"0x2\"/>"
+          "</clangStmt>"),
+      "int t[2]={1,0x2};\n");
+  BOOST_CHECK_EQUAL(buildArray("0",
+                        "<clangStmt class=\"InitListExpr\" "
+                        "xcodemlType=\"Array0\"/>"),
+      "int t[0]={};\n");
+}
+
+BOOST_AUTO_TEST_CASE(literal_list_test) {
+  BOOST_TEST_CHECKPOINT("Packed literals are spelled as they are");
+  BOOST_CHECK_EQUAL(
+      buildArray("4",
+          "<clangStmt class=\"InitListExpr\" xcodemlType=\"Array0\">"
+          "<xcodemlLiteralList class=\"IntegerLiteral\" type=\"int\" "
+          "count=\"4\">\n  1 -2\t0x3F\n-0x10 </xcodemlLiteralList>"
+          "</clangStmt>"),
+      "int t[4]={1,-2,0x3F,-0x10};\n");
+
+  BOOST_TEST_CHECKPOINT("A packed list may have one or no element");
+  BOOST_CHECK_EQUAL(
+      buildArray("1",
+          "<clangStmt class=\"InitListExpr\" xcodemlType=\"Array0\">"
+          "<xcodemlLiteralList class=\"IntegerLiteral\" type=\"int\" "
+          "count=\"1\">-7</xcodemlLiteralList>"
+          "</clangStmt>"),
+      "int t[1]={-7};\n");
+  BOOST_CHECK_EQUAL(
+      buildArray("0",
+          "<clangStmt class=\"InitListExpr\" xcodemlType=\"Array0\">"
+          "<xcodemlLiteralList class=\"IntegerLiteral\" type=\"int\" "
+          "count=\"0\"> </xcodemlLiteralList>"
+          "</clangStmt>"),
+      "int t[0]={};\n");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace
@@ -0,0 +1,122 @@
+#define BOOST_TEST_MODULE DependencyGraph
+#include <boost/test/included/unit_test.hpp>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include <libxml/xpath.h>
+#include "llvm/ADT/Optional.h"
+
+#include "StringTree.h"
+#include "XMLString.h"
+#include "XcodeMlNns.h"
+#include "XcodeMlType.h"
+#include "XcodeMlTypeTable.h"
+#include "XMLWalker.h"
+#include "SourceInfo.h"
+#include "CodeBuilder.h"
+#include "DependencyGraph.h"
+
+namespace {
+
+const std::string program =
+    "<clangAST source=\"t.cpp\" language=\"C++\">"
+    "<clangDecl class=\"TranslationUnit\">"
+    "<xcodemlTypeTable>"
+    "<functionType type=\"Function0\" return_type=\"int\"><params/>"
+    "</functionType>"
+    "<classType type=\"Class0\" cxx_class_kind=\"struct\" nns=\"NNS1\">"
+    "<name>S</name></classType>"
+    "<pointerType type=\"Pointer0\" ref=\"Class0\"/>"
+    "</xcodemlTypeTable>"
+    "<xcodemlNnsTable>"
+    "<namespaceNNS nns=\"NNS0\" parent=\"global\">a</namespaceNNS>"
+    "<namespaceNNS nns=\"NNS1\" parent=\"NNS0\">b</namespaceNNS>"
+    "</xcodemlNnsTable>"
+    "<clangDecl class=\"Namespace\"><name name_kind=\"name\">a</name>"
+    "<clangDecl class=\"Namespace\"><name name_kind=\"name\">b</name>"
+    "<clangDecl class=\"CXXRecord\" xcodemlType=\"Class0\">"
+    "<name name_kind=\"name\">S</name></clangDecl>"
+    "<clangDecl class=\"Var\" xcodemlType=\"int\">"
+    "<name name_kind=\"name\">x</name></clangDecl>"
+    "</clangDecl>"
+    "</clangDecl>"
+    "<clangDecl class=\"Var\" xcodemlType=\"Pointer0\">"
+    "<name name_kind=\"name\">ps</name></clangDecl>"
+    "<clangDecl class=\"Function\" xcodemlType=\"Function0\">"
+    "<name name_kind=\"name\">f</name>"
+    "<clangTypeLoc class=\"FunctionProto\"/>"
+    "<clangStmt class=\"CompoundStmt\"><clangStmt class=\"ReturnStmt\">"
+    "<clangStmt class=\"DeclRefExpr\" xcodemlType=\"int\">"
+    "<name name_kind=\"name\">x</name>"
+    "<clangNestedNameSpecifier clang_nested_name_specifier_kind=\"namespace\">"
+    "<name name_kind=\"name\">b</name>"
+    "<clangNestedNameSpecifier clang_nested_name_specifier_kind=\"namespace\">"
+    "<name name_kind=\"name\">a</name></clangNestedNameSpecifier>"
+    "</clangNestedNameSpecifier>"
+    "</clangStmt>"
+    "</clangStmt></clangStmt>"
+    "</clangDecl>"
+    "</clangDecl>"
+    "</clangAST>";
+
+/*!
+ * \brief Returns the dependency graph that converting \c content
+ * records.
+ */
+std::string
+buildGraph(const std::string &content) {
+  const auto doc = xmlReadMemory(
+      content.c_str(), content.size(), "t.xml", nullptr, 0);
+  BOOST_REQUIRE(doc);
+  const auto ctxt = xmlXPathNewContext(doc);
+  DependencyGraph graph;
+  std::stringstream code;
+  buildCode(xmlDocGetRootElement(doc),
+      ctxt,
+      code,
+      nullptr,
+      nullptr,
+      false,
+      false,
+      &graph);
+  xmlXPathFreeContext(ctxt);
+  xmlFreeDoc(doc);
+  std::stringstream ss;
+  graph.write(ss);
+  return ss.str();
+}
+
+BOOST_AUTO_TEST_SUITE(dependency_graph)
+
+BOOST_AUTO_TEST_CASE(graph_test) {
+  const auto graph = buildGraph(program);
+
+  BOOST_TEST_CHECKPOINT("Declarations are numbered in document order");
+  BOOST_CHECK_EQUAL(graph.substr(0, graph.find("uses")),
+      "decl D0 CXXRecord a::b::S\n"
+      "decl D1 Var a::b::x\n"
+      "decl D2 Var ps\n"
+      "decl D3 Function f\n");
+
+  BOOST_TEST_CHECKPOINT("Declarations use their types");
+  BOOST_CHECK_NE(graph.find("uses D2 Pointer0\n"), std::string::npos);
+
+  BOOST_TEST_CHECKPOINT("Declarations use the declarations they name");
+  BOOST_CHECK_NE(graph.find("uses D3 Function0 D1\n"), std::string::npos);
+
+  BOOST_TEST_CHECKPOINT("Types use their definitions and their NNSs");
+  BOOST_CHECK_NE(graph.find("uses Class0 D0 NNS1\n"), std::string::npos);
+  BOOST_CHECK_NE(graph.find("uses Pointer0 Class0\n"), std::string::npos);
+
+  BOOST_TEST_CHECKPOINT("NNSs use their parents");
+  BOOST_CHECK_NE(graph.find("uses NNS1 NNS0\n"), std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace
@@ -0,0 +1,182 @@
+#define BOOST_TEST_MODULE FragmentCache
+#include <boost/test/included/unit_test.hpp>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include <libxml/xpath.h>
+#include "llvm/ADT/Optional.h"
+
+#include "LibXMLUtil.h"
+#include "Stream.h"
+#include "StringTree.h"
+#include "XMLString.h"
+#include "XcodeMlNns.h"
+#include "XcodeMlType.h"
+#include "XcodeMlTypeTable.h"
+#include "XMLWalker.h"
+#include "SourceInfo.h"
+#include "CodeBuilder.h"
+#include "FragmentCache.h"
+
+namespace {
+
+const char *const cacheDir = "FragmentCache_test.d";
+
+/*! \brief Returns a program whose function \c f takes a \c pointee*. */
+std::string
+program(const std::string &pointee) {
+  return std::string("<clangAST source=\"t.cpp\" language=\"C++\">")
+      + "<clangDecl class=\"TranslationUnit\">"
+      + "<xcodemlTypeTable>"
+      + "<functionType type=\"Function0\" return_type=\"int\">"
+      + "<params><paramTypeName type=\"Pointer0\"/></params>"
+      + "</functionType>"
+      + "<pointerType type=\"Pointer0\" ref=\"" + pointee + "\"/>"
+      + "</xcodemlTypeTable>"
+      + "<xcodemlNnsTable/>"
+      + "<clangDecl class=\"Function\" xcodemlType=\"Function0\">"
+      + "<name name_kind=\"name\">f</name>"
+      + "<clangTypeLoc class=\"FunctionProto\">"
+      + "<clangDecl class=\"ParmVar\" xcodemlType=\"Pointer0\">"
+      + "<name name_kind=\"name\">p</name></clangDecl>"
+      + "</clangTypeLoc>"
+      + "<clangStmt class=\"CompoundStmt\">"
+      + "<clangStmt class=\"ReturnStmt\">"
+      + "<clangStmt class=\"IntegerLiteral\" token=\"0\"/>"
+      + "</clangStmt></clangStmt>"
+      + "</clangDecl>"
+      + "</clangDecl></clangAST>";
+}
+
+/*!
+ * \brief Returns the code of \c content, converted through a cache in
+ * \c cacheDir if \c cached. As in XcodeMLtoCXX, each conversion has
+ * its own FragmentCache.
+ */
+std::string
+convert(const std::string &content, bool cached) {
+  std::unique_ptr<FragmentCache> cache;
+  if (cached) {
+    cache.reset(new FragmentCache(cacheDir, "/proc/self/exe"));
+    BOOST_REQUIRE(cache->isEnabled());
+  }
+  const auto doc =
+      xmlReadMemory(content.c_str(), content.size(), "t.xml", nullptr, 0);
+  BOOST_REQUIRE(doc);
+  const auto ctxt = xmlXPathNewContext(doc);
+  std::stringstream ss;
+  buildCode(xmlDocGetRootElement(doc), ctxt, ss, cache.get());
+  xmlXPathFreeContext(ctxt);
+  xmlFreeDoc(doc);
+  return ss.str();
+}
+
+/*! \brief Returns the names of the entries in the cache directory. */
+std::vector<std::string>
+listEntries() {
+  std::vector<std::string> entries;
+  const auto dir = opendir(cacheDir);
+  if (!dir) {
+    return entries;
+  }
+  while (const auto entry = readdir(dir)) {
+    const std::string name = entry->d_name;
+    if (name != "." && name != "..") {
+      entries.push_back(name);
+    }
+  }
+  closedir(dir);
+  return entries;
+}
+
+void
+removeCache() {
+  for (auto &&entry : listEntries()) {
+    std::remove((std::string(cacheDir) + "/" + entry).c_str());
+  }
+  rmdir(cacheDir);
+}
+
+BOOST_AUTO_TEST_SUITE(fragment_cache)
+
+BOOST_AUTO_TEST_CASE(convert_test) {
+  removeCache();
+
+  BOOST_TEST_CHECKPOINT("A miss stores the generated code");
+  const auto expected = convert(program("int"), false);
+  BOOST_CHECK_EQUAL(convert(program("int"), true), expected);
+  const auto entries = listEntries();
+  BOOST_REQUIRE_EQUAL(entries.size(), 1);
+
+  BOOST_TEST_CHECKPOINT("A hit gives the same code");
+  BOOST_CHECK_EQUAL(convert(program("int"), true), expected);
+  BOOST_CHECK(listEntries() == entries);
+
+  BOOST_TEST_CHECKPOINT("A hit is read from the cache");
+  std::ofstream(std::string(cacheDir) + "/" + entries.front())
+      << "int f(int *p);";
+  BOOST_CHECK_EQUAL(convert(program("int"), true), "int f(int *p);\n");
+
+  BOOST_TEST_CHECKPOINT("Editing a referenced type misses");
+  const auto edited = convert(program("char"), true);
+  BOOST_CHECK_EQUAL(edited, convert(program("char"), false));
+  BOOST_CHECK(edited != expected);
+  BOOST_CHECK_EQUAL(listEntries().size(), 2);
+
+  removeCache();
+}
+
+BOOST_AUTO_TEST_CASE(entry_test) {
+  removeCache();
+  const FragmentCache cache(cacheDir, "/proc/self/exe");
+  BOOST_REQUIRE(cache.isEnabled());
+
+  const auto content = program("int");
+  const auto doc =
+      xmlReadMemory(content.c_str(), content.size(), "t.xml", nullptr, 0);
+  BOOST_REQUIRE(doc);
+  const auto ctxt = xmlXPathNewContext(doc);
+  const XcodeMl::TypeTable types;
+  const XcodeMl::NnsTable nnss;
+  SourceInfo src(ctxt, types, nnss, Language::CPlusPlus);
+  const auto unit = xmlDocGetRootElement(doc)->children;
+  const auto function = unit->children->next->next;
+  BOOST_REQUIRE_EQUAL(getName(function), "clangDecl");
+
+  BOOST_TEST_CHECKPOINT("Only functions have keys");
+  BOOST_CHECK(!cache.makeKey(unit, src).hasValue());
+  const auto key = cache.makeKey(function, src);
+  BOOST_REQUIRE(key.hasValue());
+  BOOST_CHECK(cache.makeKey(function, src) == key);
+
+  BOOST_TEST_CHECKPOINT("The key depends on the mode of the conversion");
+  src.minimalParens = true;
+  BOOST_CHECK(cache.makeKey(function, src) != key);
+  src.minimalParens = false;
+
+  BOOST_TEST_CHECKPOINT("lookup() finds what store() stored");
+  BOOST_CHECK(!cache.lookup(*key).hasValue());
+  cache.store(*key, "int f(int *p);\n");
+  const auto code = cache.lookup(*key);
+  BOOST_REQUIRE(code.hasValue());
+  BOOST_CHECK_EQUAL(*code, "int f(int *p);\n");
+  cache.store(*key, "");
+  BOOST_CHECK_EQUAL(*cache.lookup(*key), "");
+  BOOST_CHECK_EQUAL(listEntries().size(), 1);
+
+  xmlXPathFreeContext(ctxt);
+  xmlFreeDoc(doc);
+  removeCache();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace
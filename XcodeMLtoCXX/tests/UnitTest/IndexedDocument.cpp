@@ -0,0 +1,147 @@
+#define BOOST_TEST_MODULE IndexedDocument
+#include <boost/test/included/unit_test.hpp>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include <libxml/xpath.h>
+#include "llvm/ADT/Optional.h"
+
+#include "StringTree.h"
+#include "XMLString.h"
+#include "XcodeMlNns.h"
+#include "XcodeMlType.h"
+#include "XcodeMlTypeTable.h"
+#include "XMLWalker.h"
+#include "SourceInfo.h"
+#include "CodeBuilder.h"
+#include "IndexedDocument.h"
+
+namespace {
+
+const char *const filename = "IndexedDocument_test.xml";
+const char *const indexFile = "IndexedDocument_test.xml.index";
+
+/*!
+ * \brief Lay out a document and its index as CXXtoXcodeML --index does
+ * (see XcodeMlIndex.h).
+ */
+class IndexedDocumentWriter {
+public:
+  /*! \brief Returns the offset and length attributes of \c text. */
+  std::string
+  add(const std::string &text) {
+    const auto range = "offset=\"" + std::to_string(document.size())
+        + "\" length=\"" + std::to_string(text.size()) + "\"";
+    document += text;
+    return range;
+  }
+  void
+  write(const std::string &entries) {
+    std::ofstream(filename) << document;
+    std::ofstream(indexFile)
+        << "<xcodemlIndex source=\"t.cpp\" length=\"" << document.size()
+        << "\">" << entries << "</xcodemlIndex>\n";
+  }
+  std::string document;
+};
+
+const std::string functionType =
+    "<functionType type=\"Function0\" return_type=\"int\"><params/>"
+    "</functionType>";
+
+std::string
+makeFunction(const std::string &name, const std::string &value) {
+  return "<clangDecl class=\"Function\" xcodemlType=\"Function0\">"
+         "<name name_kind=\"name\">"
+      + name
+      + "</name>"
+        "<clangTypeLoc class=\"FunctionProto\"/>"
+        "<clangStmt class=\"CompoundStmt\"><clangStmt class=\"ReturnStmt\">"
+        "<clangStmt class=\"IntegerLiteral\" token=\""
+      + value + "\"/></clangStmt></clangStmt></clangDecl>\n";
+}
+
+/*!
+ * \brief Write a document with the function a::f in a namespace and the
+ * function g after it, along with its index.
+ */
+void
+writeIndexedDocument() {
+  IndexedDocumentWriter w;
+  auto entries = "<header " + w.add("<clangAST source=\"t.cpp\">\n"
+                                    "<clangDecl class=\"TranslationUnit\">\n")
+      + "/>";
+  entries += "<typeTable "
+      + w.add("<xcodemlTypeTable>" + functionType + "</xcodemlTypeTable>\n")
+      + "/>";
+  entries +=
+      "<nnsTable " + w.add("<xcodemlNnsTable></xcodemlNnsTable>\n") + "/>";
+
+  const auto head = std::string("<clangDecl class=\"Namespace\">"
+                                "<name name_kind=\"name\">a</name>\n");
+  const auto tail = std::string("</clangDecl>\n");
+  const auto namespaceOffset = w.document.size();
+  w.document += head;
+  const auto f = w.add(makeFunction("f", "1"));
+  w.document += tail;
+  entries += "<decl kind=\"Namespace\" name=\"a\" offset=\""
+      + std::to_string(namespaceOffset) + "\" length=\""
+      + std::to_string(w.document.size() - namespaceOffset)
+      + "\" head_length=\"" + std::to_string(head.size())
+      + "\" tail_length=\"" + std::to_string(tail.size()) + "\">"
+      + "<decl kind=\"Function\" name=\"a::f\" mangled_name=\"_ZN1a1fEv\" "
+      + f + "/></decl>";
+  entries += "<decl kind=\"Function\" name=\"g\" mangled_name=\"_Z1gv\" "
+      + w.add(makeFunction("g", "2")) + "/>";
+  entries += "<footer " + w.add("</clangDecl>\n</clangAST>\n") + "/>";
+  w.write(entries);
+}
+
+/*!
+ * \brief Returns the code of the declarations named \c name, as
+ * XcodeMLtoCXX --only prints it.
+ */
+std::string
+buildOnly(const std::string &name) {
+  const auto doc = readIndexedDocument(filename, indexFile, name);
+  const auto ctxt = xmlXPathNewContext(doc);
+  std::stringstream ss;
+  buildCode(xmlDocGetRootElement(doc), ctxt, ss);
+  xmlXPathFreeContext(ctxt);
+  xmlFreeDoc(doc);
+  return ss.str();
+}
+
+BOOST_AUTO_TEST_SUITE(indexed_document)
+
+BOOST_AUTO_TEST_CASE(only_test) {
+  writeIndexedDocument();
+
+  BOOST_TEST_CHECKPOINT("A declaration is read in its namespace");
+  BOOST_CHECK_EQUAL(buildOnly("a::f"), 
+      "namespace a{int f(){return 1;\n}\n}\n");
+
+  BOOST_TEST_CHECKPOINT("A declaration is found by its mangled name");
+  BOOST_CHECK_EQUAL(buildOnly("_Z1gv"), "int g(){return 2;\n}\n");
+
+  BOOST_TEST_CHECKPOINT("Unknown names are rejected");
+  BOOST_CHECK_THROW(buildOnly("h"), std::runtime_error);
+
+  BOOST_TEST_CHECKPOINT("A stale index is rejected");
+  std::ofstream(filename, std::ios::app) << "\n";
+  BOOST_CHECK_THROW(buildOnly("a::f"), std::runtime_error);
+
+  std::remove(filename);
+  std::remove(indexFile);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace
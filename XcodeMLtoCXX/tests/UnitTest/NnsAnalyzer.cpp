@@ -0,0 +1,98 @@
+#define BOOST_TEST_MODULE NnsAnalyzer
+#include <boost/test/included/unit_test.hpp>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include <libxml/xpath.h>
+#include "llvm/ADT/Optional.h"
+#include "llvm/Support/Casting.h"
+#include "StringTree.h"
+#include "XcodeMlNns.h"
+#include "XcodeMlType.h"
+#include "XcodeMlTypeTable.h"
+#include "NnsAnalyzer.h"
+
+namespace {
+
+const char table[] =
+    "<xcodemlNnsTable>"
+    "<namespaceNNS nns=\"NNS0\" parent=\"global\">a</namespaceNNS>"
+    "<namespaceNNS nns=\"NNS1\" parent=\"NNS0\" is_anonymous=\"1\"/>"
+    "<!-- comments and texts are skipped -->"
+    "<namespaceNNS nns=\"NNS2\" parent=\"NNS1\" "
+    "is_anonymous=\"false\">b</namespaceNNS>"
+    "<otherNNS nns=\"NNS3\"/>"
+    "</xcodemlNnsTable>";
+
+const char expansion[] =
+    "<xcodemlNnsTable>"
+    "<namespaceNNS nns=\"NNS0\" parent=\"global\">c</namespaceNNS>"
+    "</xcodemlNnsTable>";
+
+std::string
+declare(const XcodeMl::NnsTable &nnss, const std::string &ident) {
+  const XcodeMl::TypeTable env;
+  return CXXCodeGen::to_string(nnss.at(ident)->makeDeclaration(env, nnss));
+}
+
+BOOST_AUTO_TEST_SUITE(nns_analyzer)
+
+BOOST_AUTO_TEST_CASE(analyzeNnsTable_test) {
+  xmlDocPtr doc = xmlReadMemory(table, sizeof(table) - 1, "", nullptr, 0);
+  BOOST_REQUIRE(doc);
+
+  BOOST_TEST_CHECKPOINT("Every kind of namespace is defined");
+  const auto nnss = analyzeNnsTable(xmlDocGetRootElement(doc), nullptr);
+  BOOST_CHECK_EQUAL(declare(nnss, "NNS0"), "::a::");
+  BOOST_CHECK_EQUAL(declare(nnss, "NNS2"), "::a::b::");
+  BOOST_CHECK_EQUAL(nnss.getParentChain("NNS2").size(), 4);
+  BOOST_CHECK(nnss.at("NNS3") != nullptr);
+
+  BOOST_TEST_CHECKPOINT("The initial table has only the global namespace");
+  const auto initial = analyzeNnsTable(nullptr, nullptr);
+  BOOST_CHECK_THROW(initial.at("NNS0"), std::out_of_range);
+  BOOST_CHECK(initial.at("global") != nullptr);
+
+  BOOST_TEST_CHECKPOINT("expandNnsTable() redefines without modifying");
+  xmlDocPtr other =
+      xmlReadMemory(expansion, sizeof(expansion) - 1, "", nullptr, 0);
+  BOOST_REQUIRE(other);
+  const auto expanded =
+      expandNnsTable(nnss, xmlDocGetRootElement(other), nullptr);
+  BOOST_CHECK_EQUAL(declare(expanded, "NNS2"), "::c::b::");
+  BOOST_CHECK_EQUAL(declare(nnss, "NNS2"), "::a::b::");
+
+  xmlFreeDoc(other);
+  xmlFreeDoc(doc);
+}
+
+BOOST_AUTO_TEST_CASE(malformed_test) {
+  BOOST_TEST_CHECKPOINT("A definition without its identifier throws");
+  const char noIdent[] =
+      "<xcodemlNnsTable><namespaceNNS parent=\"global\">a</namespaceNNS>"
+      "</xcodemlNnsTable>";
+  xmlDocPtr doc = xmlReadMemory(noIdent, sizeof(noIdent) - 1, "", nullptr, 0);
+  BOOST_REQUIRE(doc);
+  BOOST_CHECK_THROW(analyzeNnsTable(xmlDocGetRootElement(doc), nullptr),
+      std::runtime_error);
+  xmlFreeDoc(doc);
+
+  BOOST_TEST_CHECKPOINT("A boolean attribute must be 0, 1, false or true");
+  const char badFlag[] =
+      "<xcodemlNnsTable>"
+      "<namespaceNNS nns=\"NNS0\" parent=\"global\" is_anonymous=\"yes\"/>"
+      "</xcodemlNnsTable>";
+  doc = xmlReadMemory(badFlag, sizeof(badFlag) - 1, "", nullptr, 0);
+  BOOST_REQUIRE(doc);
+  BOOST_CHECK_THROW(analyzeNnsTable(xmlDocGetRootElement(doc), nullptr),
+      std::runtime_error);
+  xmlFreeDoc(doc);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace
@@ -0,0 +1,143 @@
+#define BOOST_TEST_MODULE OutputSplitter
+#include <boost/test/included/unit_test.hpp>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include <libxml/xpath.h>
+#include "llvm/ADT/Optional.h"
+
+#include "Stream.h"
+#include "StringTree.h"
+#include "XMLString.h"
+#include "XcodeMlNns.h"
+#include "XcodeMlType.h"
+#include "XcodeMlTypeTable.h"
+#include "XMLWalker.h"
+#include "SourceInfo.h"
+#include "CodeBuilder.h"
+#include "OutputSplitter.h"
+
+namespace cxxgen = CXXCodeGen;
+
+namespace {
+
+const std::string program =
+    "<clangAST source=\"t.cpp\" language=\"C++\">"
+    "<clangDecl class=\"TranslationUnit\">"
+    "<xcodemlTypeTable>"
+    "<basicType type=\"Basic0\" name=\"int\" is_const=\"true\"/>"
+    "<functionType type=\"Function0\" return_type=\"int\"><params/>"
+    "</functionType>"
+    "</xcodemlTypeTable>"
+    "<xcodemlNnsTable/>"
+    "<clangDecl class=\"Var\" xcodemlType=\"int\">"
+    "<name name_kind=\"name\">x</name>"
+    "<clangStmt class=\"IntegerLiteral\" token=\"1\"/></clangDecl>"
+    "<clangDecl class=\"Var\" xcodemlType=\"Basic0\">"
+    "<name name_kind=\"name\">c</name>"
+    "<clangStmt class=\"IntegerLiteral\" token=\"2\"/></clangDecl>"
+    "<clangDecl class=\"Function\" xcodemlType=\"Function0\">"
+    "<name name_kind=\"name\">f</name>"
+    "<clangTypeLoc class=\"FunctionProto\"/>"
+    "<clangStmt class=\"CompoundStmt\"><clangStmt class=\"ReturnStmt\">"
+    "<clangStmt class=\"IntegerLiteral\" token=\"3\"/>"
+    "</clangStmt></clangStmt></clangDecl>"
+    "<clangDecl class=\"Function\" xcodemlType=\"Function0\" "
+    "is_inline=\"true\">"
+    "<name name_kind=\"name\">g</name>"
+    "<clangTypeLoc class=\"FunctionProto\"/>"
+    "<clangStmt class=\"CompoundStmt\"><clangStmt class=\"ReturnStmt\">"
+    "<clangStmt class=\"IntegerLiteral\" token=\"4\"/>"
+    "</clangStmt></clangStmt></clangDecl>"
+    "<clangDecl class=\"Namespace\" is_anonymous=\"true\">"
+    "<name name_kind=\"name\"/>"
+    "<clangDecl class=\"Var\" xcodemlType=\"int\">"
+    "<name name_kind=\"name\">y</name></clangDecl>"
+    "</clangDecl>"
+    "</clangDecl>"
+    "</clangAST>";
+
+/*!
+ * \brief Returns the code of the shared header that converting
+ * \c content with \c splitter gives.
+ */
+std::string
+buildSplitCode(const std::string &content, OutputSplitter &splitter) {
+  const auto doc = xmlReadMemory(
+      content.c_str(), content.size(), "t.xml", nullptr, 0);
+  BOOST_REQUIRE(doc);
+  const auto ctxt = xmlXPathNewContext(doc);
+  std::stringstream ss;
+  buildCode(xmlDocGetRootElement(doc), ctxt, ss, nullptr, &splitter);
+  xmlXPathFreeContext(ctxt);
+  xmlFreeDoc(doc);
+  return ss.str();
+}
+
+BOOST_AUTO_TEST_SUITE(output_splitter)
+
+BOOST_AUTO_TEST_CASE(balance_test) {
+  OutputSplitter splitter(2);
+  splitter.addDefinition(cxxgen::makeTokenNode("int f(){return 12345;}"));
+  splitter.addDefinition(cxxgen::makeTokenNode("int g(){}"));
+  splitter.addDefinition(cxxgen::makeTokenNode("int h(){}"));
+
+  BOOST_TEST_CHECKPOINT("Definitions go to the unit with the least code");
+  const auto &units = splitter.getUnits();
+  BOOST_REQUIRE_EQUAL(units.size(), 2);
+  BOOST_CHECK_EQUAL(units[0], "int f(){return 12345;}\n");
+  BOOST_CHECK_EQUAL(units[1], "int g(){}\nint h(){}\n");
+}
+
+BOOST_AUTO_TEST_CASE(namespace_test) {
+  OutputSplitter splitter(1);
+  splitter.enterNamespace(cxxgen::makeTokenNode("namespace a"), false);
+  splitter.enterNamespace(cxxgen::makeTokenNode("namespace b"), false);
+  BOOST_CHECK(!splitter.isInAnonymousNamespace());
+  splitter.addDefinition(cxxgen::makeTokenNode("int x;"));
+  splitter.exitNamespace();
+  splitter.enterNamespace(cxxgen::makeTokenNode("namespace"), true);
+  BOOST_CHECK(splitter.isInAnonymousNamespace());
+  splitter.exitNamespace();
+  splitter.exitNamespace();
+  splitter.addDefinition(cxxgen::makeTokenNode("int y;"));
+
+  BOOST_TEST_CHECKPOINT("Definitions are wrapped in their namespaces");
+  BOOST_CHECK_EQUAL(splitter.getUnits()[0],
+      "namespace a{namespace b{int x;}}\nint y;\n");
+}
+
+BOOST_AUTO_TEST_CASE(split_code_test) {
+  OutputSplitter splitter(2);
+  const auto header = buildSplitCode(program, splitter);
+
+  BOOST_TEST_CHECKPOINT("Out-of-line definitions are moved to the units");
+  const auto &units = splitter.getUnits();
+  BOOST_REQUIRE_EQUAL(units.size(), 2);
+  BOOST_CHECK_EQUAL(units[0], "int x=1;\n");
+  BOOST_CHECK_EQUAL(units[1], "int f(){return 3;\n}\n");
+
+  BOOST_TEST_CHECKPOINT("Their declarations stay in the header");
+  BOOST_CHECK_NE(header.find("extern int x;"), std::string::npos);
+  BOOST_CHECK_NE(header.find("int f();"), std::string::npos);
+
+  BOOST_TEST_CHECKPOINT(
+      "Constants, inline functions and unnamed namespaces stay whole");
+  BOOST_CHECK_NE(header.find("int const c=2;"), std::string::npos);
+  BOOST_CHECK_NE(header.find("inline int g(){return 4;"), std::string::npos);
+  BOOST_CHECK_NE(header.find("namespace{int y;"), std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(include_guard_test) {
+  BOOST_CHECK_EQUAL(makeIncludeGuard("out.h"), "OUT_H");
+  BOOST_CHECK_EQUAL(makeIncludeGuard("foo-bar.h"), "FOO_BAR_H");
+  BOOST_CHECK_EQUAL(makeIncludeGuard("1x.h"), "H_1X_H");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace
@@ -0,0 +1,132 @@
+#define BOOST_TEST_MODULE SchemaValidator
+#include <boost/test/included/unit_test.hpp>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "SchemaValidator.h"
+
+namespace {
+
+const char *const filename = "SchemaValidator_test.xml";
+
+const std::string program =
+    "<XcodeProgram language=\"C++\">\n"
+    "<typeTable><pointerType type=\"P0\" ref=\"int\"/></typeTable>\n"
+    "<globalSymbols>\n"
+    "<id sclass=\"extern_def\" type=\"P0\"><name>p</name></id>\n"
+    "<id sclass=\"extern_def\" type=\"int\"><name>i</name></id>\n"
+    "</globalSymbols>\n"
+    "<globalDeclarations>"
+    "<varDecl><name>p</name></varDecl>"
+    "<varDecl><name>i</name>"
+    "<value><intConstant type=\"int\">1</intConstant></value></varDecl>"
+    "</globalDeclarations>\n"
+    "</XcodeProgram>\n";
+
+/*!
+ * \brief Returns the message of the error that validating \c content
+ * gives, or "" if it is valid.
+ */
+std::string
+validate(const std::string &content) {
+  {
+    std::ofstream ofs(filename);
+    ofs << content;
+  }
+  std::string message;
+  try {
+    validateXcodeMlDocument(filename);
+  } catch (std::runtime_error &e) {
+    message = e.what();
+  }
+  std::remove(filename);
+  return message;
+}
+
+std::string
+replace(std::string str, const std::string &from, const std::string &to) {
+  return str.replace(str.find(from), from.size(), to);
+}
+
+BOOST_AUTO_TEST_SUITE(schema_validator)
+
+BOOST_AUTO_TEST_CASE(valid_test) {
+  BOOST_CHECK_EQUAL(validate(program), "");
+  BOOST_CHECK_EQUAL(
+      validate(replace(program, "language=\"C++\"", "language=\" C \"")), "");
+}
+
+BOOST_AUTO_TEST_CASE(entity_test) {
+  const std::string internal = "<!DOCTYPE XcodeProgram [\n"
+                               "<!ENTITY one \"1\">\n"
+                               "<!ENTITY t \"t\">\n"
+                               "]>\n";
+  BOOST_TEST_CHECKPOINT("Entity references are checked as their text");
+  BOOST_CHECK_EQUAL(validate(internal + replace(program, ">1<", ">&one;<")),
+      "");
+  BOOST_CHECK_EQUAL(
+      validate(internal + replace(program, "<typeTable>", "<typeTable>&t;")),
+      "SchemaValidator_test.xml:6: /XcodeProgram/typeTable: "
+      "text not allowed here");
+
+  BOOST_TEST_CHECKPOINT("External entities are not loaded");
+  const char *const external = "SchemaValidator_test.txt";
+  {
+    std::ofstream ofs(external);
+    ofs << "t";
+  }
+  BOOST_CHECK_EQUAL(validate(std::string("<!DOCTYPE XcodeProgram [\n")
+                        + "<!ENTITY x SYSTEM \"" + external + "\">\n]>\n"
+                        + replace(program, "<typeTable>", "<typeTable>&x;")),
+      "");
+  std::remove(external);
+}
+
+BOOST_AUTO_TEST_CASE(error_test) {
+  BOOST_TEST_CHECKPOINT("Attributes are checked");
+  BOOST_CHECK_EQUAL(validate(replace(program, "type=\"int\"", "scope=\"\"")),
+      "SchemaValidator_test.xml:5: /XcodeProgram/globalSymbols/id[2]: "
+      "attribute 'scope' not allowed");
+  BOOST_CHECK_EQUAL(validate(replace(program, " ref=\"int\"", "")),
+      "SchemaValidator_test.xml:2: /XcodeProgram/typeTable/pointerType: "
+      "attribute 'ref' missing");
+  BOOST_CHECK_EQUAL(
+      validate(replace(program, "language=\"C++\"", "language=\"Fortran\"")),
+      "SchemaValidator_test.xml:1: /XcodeProgram: "
+      "attribute 'language' has invalid value 'Fortran'");
+  BOOST_CHECK_EQUAL(validate(replace(program, "ref=", "is_const=\"1\" to=")),
+      "SchemaValidator_test.xml:2: /XcodeProgram/typeTable/pointerType: "
+      "attribute 'to' not allowed");
+
+  BOOST_TEST_CHECKPOINT("Child elements are checked");
+  BOOST_CHECK_EQUAL(
+      validate(replace(program, "<varDecl><name>p</name>", "<varDecl>")),
+      "SchemaValidator_test.xml:7: "
+      "/XcodeProgram/globalDeclarations/varDecl: "
+      "element incomplete; expected name");
+  BOOST_CHECK_EQUAL(validate(replace(program,
+                        "<globalSymbols>",
+                        "<globalDeclarations/><globalSymbols>")),
+      "SchemaValidator_test.xml:3: /XcodeProgram/globalDeclarations: "
+      "element not allowed here; expected globalSymbols");
+  BOOST_CHECK_EQUAL(
+      validate(replace(program, "</name></id>", "</name><x/></id>")),
+      "SchemaValidator_test.xml:4: /XcodeProgram/globalSymbols/id/x: "
+      "element not allowed here; expected alignAs, bitField or the end");
+
+  BOOST_TEST_CHECKPOINT("Text is checked");
+  BOOST_CHECK_EQUAL(validate(replace(program, "<typeTable>", "<typeTable>t")),
+      "SchemaValidator_test.xml:2: /XcodeProgram/typeTable: "
+      "text not allowed here");
+
+  BOOST_TEST_CHECKPOINT("The root element is checked");
+  BOOST_CHECK_EQUAL(validate("<clangAST/>"),
+      "SchemaValidator_test.xml:1: /clangAST: "
+      "element not allowed here; expected XcodeProgram");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace
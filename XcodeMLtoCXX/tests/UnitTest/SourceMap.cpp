@@ -0,0 +1,45 @@
+#define BOOST_TEST_MODULE SourceMap
+#include <boost/test/included/unit_test.hpp>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SourceMap.h"
+
+namespace {
+
+BOOST_AUTO_TEST_SUITE(source_map)
+
+BOOST_AUTO_TEST_CASE(extract_test) {
+  SourceMap map;
+  BOOST_TEST_CHECKPOINT("extract() removes the #line directives");
+  const auto code = map.extract("out.cpp",
+      "int a;\n"
+      "#line 3 \"a.cpp\"\n"
+      "int b;\n"
+      "int c;\n"
+      "#line 10 \"b.h\"\n"
+      "#line 20 \"a.cpp\"\n"
+      "int d;");
+  BOOST_CHECK_EQUAL(code, "int a;\nint b;\nint c;\nint d;");
+
+  const auto unit = map.extract("out_0.cpp", "#line 1 \"b.h\"\nint e;\n", 2);
+  BOOST_CHECK_EQUAL(unit, "int e;\n");
+
+  BOOST_TEST_CHECKPOINT("Source files are listed once");
+  std::stringstream ss;
+  map.write(ss);
+  BOOST_CHECK_EQUAL(ss.str(),
+      "source 0 a.cpp\n"
+      "source 1 b.h\n"
+      "code out.cpp\n"
+      "2-3 0 3\n"
+      "4-4 0 20\n"
+      "code out_0.cpp\n"
+      "2-2 1 1\n");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace
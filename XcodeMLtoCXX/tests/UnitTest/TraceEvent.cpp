@@ -0,0 +1,90 @@
+#define BOOST_TEST_MODULE TraceEvent
+#include <boost/test/included/unit_test.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "TraceEvent.h"
+
+namespace {
+
+const char *const filename = "TraceEvent_test.json";
+
+const unsigned threshold = 1000;
+
+std::string
+readTrace() {
+  std::ifstream ifs(filename);
+  std::stringstream ss;
+  ss << ifs.rdbuf();
+  std::remove(filename);
+  return ss.str();
+}
+
+/*!
+ * \brief Returns \c trace with the number following each \c key
+ * replaced with "N", and stores the last such number in \c value.
+ */
+std::string
+mask(std::string trace, const std::string &key, long long &value) {
+  for (auto pos = trace.find(key); pos != std::string::npos;
+       pos = trace.find(key, pos + 1)) {
+    const auto begin = pos + key.size();
+    const auto end = trace.find_first_not_of("0123456789", begin);
+    value = std::atoll(trace.substr(begin, end - begin).c_str());
+    trace.replace(begin, end - begin, "N");
+  }
+  return trace;
+}
+
+BOOST_AUTO_TEST_SUITE(trace_event)
+
+BOOST_AUTO_TEST_CASE(disabled_test) {
+  BOOST_TEST_CHECKPOINT("A Scope records nothing until start()");
+  TraceEvent::Scope scope("walker", "proc");
+  BOOST_CHECK(!scope.isActive());
+  BOOST_CHECK(TraceEvent::finish());
+}
+
+BOOST_AUTO_TEST_CASE(threshold_test) {
+  TraceEvent::start(filename, threshold);
+  {
+    TraceEvent::Scope scope("walker", "short");
+    BOOST_CHECK(scope.isActive());
+  }
+  {
+    TraceEvent::Scope scope("walker", "long");
+    scope.setName("a\"b\\c\nd");
+    scope.setDetail("x\ty\x01");
+    std::this_thread::sleep_for(std::chrono::microseconds(2 * threshold));
+  }
+  BOOST_REQUIRE(TraceEvent::finish());
+  BOOST_CHECK(!TraceEvent::enabled);
+
+  BOOST_TEST_CHECKPOINT("Only the events over the threshold are written");
+  long long ts = -1, dur = -1;
+  const auto trace = mask(mask(readTrace(), "\"ts\":", ts), "\"dur\":", dur);
+  BOOST_CHECK_EQUAL(trace,
+      "{\"traceEvents\":[\n"
+      "{\"name\":\"a\\\"b\\\\c\\nd\",\"cat\":\"walker\",\"ph\":\"X\","
+      "\"ts\":N,\"dur\":N,\"pid\":1,\"tid\":1,"
+      "\"args\":{\"detail\":\"x\\ty\\u0001\"}}\n"
+      "],\"displayTimeUnit\":\"ms\"}\n");
+  BOOST_CHECK(ts >= 0);
+  BOOST_CHECK(dur >= threshold);
+
+  BOOST_TEST_CHECKPOINT("A trace without events is still valid");
+  TraceEvent::start(filename, threshold);
+  { TraceEvent::Scope scope("walker", "short"); }
+  BOOST_REQUIRE(TraceEvent::finish());
+  BOOST_CHECK_EQUAL(
+      readTrace(), "{\"traceEvents\":[\n],\"displayTimeUnit\":\"ms\"}\n");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace
@@ -0,0 +1,47 @@
+#define BOOST_TEST_MODULE XcodeMl::Name
+#include <boost/test/included/unit_test.hpp>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <libxml/tree.h>
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Casting.h"
+#include "StringTree.h"
+#include "XcodeMlNns.h"
+#include "XcodeMlType.h"
+#include "XcodeMlTypeTable.h"
+#include "XcodeMlName.h"
+
+BOOST_AUTO_TEST_SUITE(xcodeml_name)
+
+BOOST_AUTO_TEST_CASE(unqual_id_table_test) {
+  using namespace XcodeMl;
+
+  UnqualIdTable ids;
+  const TypeTable env;
+  const NnsTable nnsTable;
+
+  BOOST_TEST_CHECKPOINT("The same kind and spelling gives the same object");
+  const auto x = ids.getIdent("x");
+  BOOST_CHECK(llvm::isa<UIDIdent>(x.get()));
+  BOOST_CHECK_EQUAL(ids.getIdent(std::string("x")), x);
+  BOOST_CHECK(ids.getIdent("y") != x);
+  BOOST_CHECK_EQUAL(CXXCodeGen::to_string(x->toString(env, nnsTable)), "x");
+
+  const auto plus = ids.getOpFuncId("+");
+  BOOST_CHECK(llvm::isa<OpFuncId>(plus.get()));
+  BOOST_CHECK_EQUAL(ids.getOpFuncId("+"), plus);
+
+  BOOST_TEST_CHECKPOINT("Names of different kinds are distinct");
+  const auto ctor = ids.getCtorName("Class0");
+  const auto dtor = ids.getDtorName("Class0");
+  BOOST_CHECK(llvm::isa<CtorName>(ctor.get()));
+  BOOST_CHECK(llvm::isa<DtorName>(dtor.get()));
+  BOOST_CHECK(ctor != dtor);
+  BOOST_CHECK_EQUAL(ids.getCtorName("Class0"), ctor);
+  BOOST_CHECK_EQUAL(ids.getUnnamedId(), ids.getUnnamedId());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,54 @@
+#define BOOST_TEST_MODULE XcodeMl::Nns
+#include <boost/test/included/unit_test.hpp>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <libxml/tree.h>
+#include "llvm/ADT/Optional.h"
+#include "llvm/Support/Casting.h"
+#include "StringTree.h"
+#include "XcodeMlNns.h"
+#include "XcodeMlType.h"
+#include "XcodeMlTypeTable.h"
+
+BOOST_AUTO_TEST_SUITE(xcodeml_nns)
+
+BOOST_AUTO_TEST_CASE(makeDeclaration_test) {
+  using namespace XcodeMl;
+
+  const TypeTable env;
+  NnsTable nnss = {{"global", makeGlobalNns()}};
+  nnss.define("NNS0", makeNamespaceNns("NNS0", "global", "a"));
+  nnss.define("NNS1", makeNamespaceNns("NNS1", "NNS0", "b"));
+  nnss.define("NNS2", makeUnnamedNamespaceNns("NNS2", "NNS1"));
+  nnss.define("NNS3", makeNamespaceNns("NNS3", "NNS2", "c"));
+
+  BOOST_TEST_CHECKPOINT("NnsTable::getParentChain()");
+  const auto &chain = nnss.getParentChain("NNS3");
+  BOOST_REQUIRE_EQUAL(chain.size(), 5);
+  BOOST_CHECK(chain.front() == nnss.at("global"));
+  BOOST_CHECK(chain.back() == nnss.at("NNS3"));
+
+  BOOST_TEST_CHECKPOINT("Nns::makeDeclaration()");
+  const auto c = nnss.at("NNS3")->makeDeclaration(env, nnss);
+  BOOST_CHECK_EQUAL(CXXCodeGen::to_string(c), "::a::b::c::");
+  const auto b = nnss.at("NNS1")->makeDeclaration(env, nnss);
+  BOOST_CHECK_EQUAL(CXXCodeGen::to_string(b), "::a::b::");
+
+  BOOST_TEST_CHECKPOINT("The representations are memoized");
+  BOOST_CHECK(nnss.getMemoizedSpec("NNS2").hasValue());
+  BOOST_CHECK(nnss.at("NNS3")->makeDeclaration(env, nnss) == c);
+
+  BOOST_TEST_CHECKPOINT("Redefinition discards the memoized ones");
+  auto expanded = nnss;
+  expanded.define("NNS1", makeNamespaceNns("NNS1", "NNS0", "d"));
+  BOOST_CHECK(!expanded.getMemoizedSpec("NNS3").hasValue());
+  const auto d = expanded.at("NNS3")->makeDeclaration(env, expanded);
+  BOOST_CHECK_EQUAL(CXXCodeGen::to_string(d), "::a::d::c::");
+  BOOST_CHECK_EQUAL(CXXCodeGen::to_string(
+                        nnss.at("NNS3")->makeDeclaration(env, nnss)),
+      "::a::b::c::");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,90 @@
+#define BOOST_TEST_MODULE XcodeMlTree
+#include <boost/test/included/unit_test.hpp>
+#include <libxml/tree.h>
+#include <libxml/parser.h>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+#include "XcodeMlTree.h"
+
+namespace {
+
+const char program[] =
+    "<XcodeProgram>"
+    "<typeTable><basicType type=\"B0\" name=\"int\"/></typeTable>"
+    "<globalDeclarations>"
+    "<clangDecl class=\"Var\" lineno=\"3\">"
+    "<name>x&amp;y</name><clangTypeLoc type=\"B0\"/>"
+    "</clangDecl>"
+    "<unknownElement/>"
+    "</globalDeclarations>"
+    "</XcodeProgram>";
+
+std::string
+dump(xmlNodePtr node) {
+  xmlBufferPtr buf = xmlBufferCreate();
+  xmlNodeDump(buf, node->doc, node, 0, 0);
+  const std::string result(reinterpret_cast<const char *>(buf->content));
+  xmlBufferFree(buf);
+  return result;
+}
+
+BOOST_AUTO_TEST_SUITE(xcodeml_tree)
+
+BOOST_AUTO_TEST_CASE(layout_test) {
+  xmlDocPtr doc = xmlReadMemory(program, sizeof(program) - 1, "", nullptr, 0);
+  const auto tree = XcodeMl::Tree::fromXml(xmlDocGetRootElement(doc));
+  xmlFreeDoc(doc);
+
+  BOOST_TEST_CHECKPOINT("Nodes are laid out in breadth-first order");
+  BOOST_REQUIRE_EQUAL(tree.size(), 8);
+  const auto root = tree.getRoot();
+  BOOST_CHECK(tree.getKind(root) == XcodeMl::ElementKind::XcodeProgram);
+  BOOST_CHECK_EQUAL(tree.childEnd(root) - tree.childBegin(root), 2);
+  const auto decls = tree.childBegin(root) + 1;
+  BOOST_CHECK(tree.getKind(decls) == XcodeMl::ElementKind::GlobalDeclarations);
+  BOOST_CHECK_EQUAL(tree.getParent(decls), root);
+
+  BOOST_TEST_CHECKPOINT("Attributes, text and line numbers are decoded");
+  const auto decl = tree.childBegin(decls);
+  BOOST_CHECK(tree.getKind(decl) == XcodeMl::ElementKind::ClangDecl);
+  BOOST_CHECK_EQUAL(tree.getLine(decl), 3);
+  BOOST_CHECK_EQUAL(
+      tree.getString(tree.getAttr(decl, tree.lookup("class"))), "Var");
+  BOOST_CHECK(!tree.hasAttr(decl, tree.lookup("type")));
+  const auto name = tree.findChild(decl, tree.lookup("name"));
+  BOOST_REQUIRE(name != XcodeMl::Tree::npos);
+  BOOST_CHECK_EQUAL(tree.getText(name), "x&y");
+  BOOST_CHECK(tree.getKind(tree.childBegin(decls) + 1)
+      == XcodeMl::ElementKind::Other);
+  BOOST_CHECK_EQUAL(tree.lookup("missing"), XcodeMl::Tree::npos);
+
+  BOOST_TEST_CHECKPOINT("Attribute keys are shared by every node");
+  const auto basicType = tree.childBegin(tree.childBegin(root));
+  const auto typeLoc = tree.findChild(decl, tree.lookup("clangTypeLoc"));
+  const auto type = tree.lookup("type");
+  BOOST_REQUIRE(tree.hasAttr(basicType, type));
+  BOOST_REQUIRE(tree.hasAttr(typeLoc, type));
+  BOOST_CHECK_EQUAL(tree.getString(tree.getAttr(basicType, type)),
+      tree.getString(tree.getAttr(typeLoc, type)));
+}
+
+BOOST_AUTO_TEST_CASE(round_trip_test) {
+  xmlDocPtr doc = xmlReadMemory(program, sizeof(program) - 1, "", nullptr, 0);
+  const auto tree = XcodeMl::Tree::fromXml(xmlDocGetRootElement(doc));
+
+  xmlDocPtr copy = xmlNewDoc(BAD_CAST "1.0");
+  xmlDocSetRootElement(copy, tree.toXml(copy));
+  BOOST_CHECK_EQUAL(
+      dump(xmlDocGetRootElement(copy)), dump(xmlDocGetRootElement(doc)));
+  xmlFreeDoc(copy);
+  xmlFreeDoc(doc);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace
@@ -148,4 +148,35 @@ BOOST_AUTO_TEST_CASE(RTTI_test) {
   BOOST_CHECK(cast<Struct>(stt.get()));
 }
 
+BOOST_AUTO_TEST_CASE(plain_spelling_test) {
+  using namespace XcodeMl;
+
+  TypeTable table;
+  NnsTable nnsTable;
+  table["int"] = makeReservedType("int", wrap("int"));
+  table["uint"] = makeReservedType("uint", wrap("unsigned int"));
+  table["cint"] = makeReservedType("cint", wrap("int"), true, false);
+  table["p1"] = makePointerType("p1", "int");
+  table["a1"] = makeArrayType("a1", table["int"], 3);
+  table["p2"] = makePointerType("p2", "a1");
+  table["f1"] = makeFunctionType("f1", table["int"], {});
+  table["p3"] = makePointerType("p3", "f1");
+
+  BOOST_TEST_CHECKPOINT("isPlainTypeId(T) is false if T needs parentheses");
+  BOOST_CHECK(isPlainTypeId(table["int"], table));
+  BOOST_CHECK(isPlainTypeId(table["uint"], table));
+  BOOST_CHECK(isPlainTypeId(table["p1"], table));
+  BOOST_CHECK(!isPlainTypeId(table["a1"], table));
+  BOOST_CHECK(!isPlainTypeId(table["p2"], table));
+  BOOST_CHECK(!isPlainTypeId(table["p3"], table));
+
+  BOOST_TEST_CHECKPOINT("makeSimpleTypeSpecifier(T) is only for one-word T");
+  const auto intSpec = makeSimpleTypeSpecifier(table["int"], table, nnsTable);
+  BOOST_REQUIRE(intSpec.hasValue());
+  BOOST_CHECK_EQUAL(CXXCodeGen::to_string(*intSpec), "int");
+  BOOST_CHECK(!makeSimpleTypeSpecifier(table["uint"], table, nnsTable));
+  BOOST_CHECK(!makeSimpleTypeSpecifier(table["cint"], table, nnsTable));
+  BOOST_CHECK(!makeSimpleTypeSpecifier(table["p1"], table, nnsTable));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
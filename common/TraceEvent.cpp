@@ -0,0 +1,119 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "TraceEvent.h"
+
+namespace TraceEvent {
+
+bool enabled = false;
+
+namespace {
+
+struct Event {
+  std::string category;
+  std::string name;
+  std::string detail;
+  long long begin;
+  long long duration;
+};
+
+std::string traceFile;
+long long threshold = 0;
+std::chrono::steady_clock::time_point origin;
+std::vector<Event> events;
+
+void
+writeString(std::ostream &os, const std::string &str) {
+  os << '"';
+  for (const char c : str) {
+    switch (c) {
+    case '"': os << "\\\""; break;
+    case '\\': os << "\\\\"; break;
+    case '\n': os << "\\n"; break;
+    case '\t': os << "\\t"; break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        char buf[8];
+        std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+        os << buf;
+      } else {
+        os << c;
+      }
+    }
+  }
+  os << '"';
+}
+
+} // namespace
+
+/*!
+ * \brief Start recording the events lasting at least \c thresholdMicros
+ * microseconds, to be written to \c file by finish().
+ */
+void
+start(const std::string &file, unsigned thresholdMicros) {
+  traceFile = file;
+  threshold = thresholdMicros;
+  origin = std::chrono::steady_clock::now();
+  events.clear();
+  enabled = true;
+}
+
+/*!
+ * \brief Stop recording and write the events.
+ * \return false if the trace could not be written.
+ */
+bool
+finish() {
+  if (!enabled) {
+    return true;
+  }
+  enabled = false;
+  std::ofstream os(traceFile);
+  os << "{\"traceEvents\":[";
+  bool first = true;
+  for (const auto &event : events) {
+    os << (first ? "\n" : ",\n") << "{\"name\":";
+    writeString(os, event.name);
+    os << ",\"cat\":";
+    writeString(os, event.category);
+    os << ",\"ph\":\"X\",\"ts\":" << event.begin
+       << ",\"dur\":" << event.duration << ",\"pid\":1,\"tid\":1";
+    if (!event.detail.empty()) {
+      os << ",\"args\":{\"detail\":";
+      writeString(os, event.detail);
+      os << "}";
+    }
+    os << "}";
+    first = false;
+  }
+  os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  events.clear();
+  return static_cast<bool>(os);
+}
+
+/*! \brief Return the microseconds elapsed since start(). */
+long long
+now() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - origin)
+      .count();
+}
+
+void
+Scope::end() {
+  if (!enabled) {
+    return;
+  }
+  const auto duration = now() - begin;
+  if (duration < threshold) {
+    return;
+  }
+  events.push_back(
+      {category ? category : "", name ? name : "", detail, begin, duration});
+}
+
+} // namespace TraceEvent
@@ -0,0 +1,68 @@
+#ifndef TRACEEVENT_H
+#define TRACEEVENT_H
+
+#include <string>
+
+/*!
+ * \brief Profiling output in the Chrome trace-event format, viewable in
+ * chrome://tracing or Perfetto.
+ *
+ * A Scope records a complete event ("ph": "X") for the time it lives, if
+ * that is at least the threshold given to start(). While tracing is not
+ * started, a Scope costs a load and a branch.
+ */
+namespace TraceEvent {
+
+extern bool enabled;
+
+void start(const std::string &file, unsigned thresholdMicros);
+bool finish();
+long long now();
+
+class Scope {
+public:
+  /*!
+   * \param category Category of the event, e.g. the name of the walker.
+   * \param name Name of the event, e.g. the name of the procedure.
+   * Both are copied only if the event is recorded.
+   */
+  Scope(const char *category, const char *name)
+      : category(category), name(name), begin(enabled ? now() : -1) {
+  }
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+  ~Scope() {
+    if (begin >= 0) {
+      end();
+    }
+  }
+  /*! \brief Return true if the event may be recorded. */
+  bool
+  isActive() const {
+    return begin >= 0;
+  }
+  /*! \brief Name the event after a string made by the caller. */
+  void
+  setName(const std::string &str) {
+    ownedName = str;
+    name = ownedName.c_str();
+  }
+  /*! \brief Set the "detail" argument shown with the event. */
+  void
+  setDetail(const std::string &str) {
+    detail = str;
+  }
+
+private:
+  void end();
+
+  const char *category;
+  const char *name;
+  long long begin;
+  std::string ownedName;
+  std::string detail;
+};
+
+} // namespace TraceEvent
+
+#endif /* !TRACEEVENT_H */
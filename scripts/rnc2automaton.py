@@ -0,0 +1,508 @@
+#!/usr/bin/env python3
+"""Compile a RELAX NG compact schema into the tables of XcodeMLtoCXX's
+streaming validator (XcodeMLtoCXX/src/SchemaValidator.cpp).
+
+usage: rnc2automaton.py schema/XcodeML_CXX.rnc > XcodeMLtoCXX/src/XcodeMlSchema.inc
+
+Every element pattern is turned into
+  - the attributes it allows, with their values and whether they are
+    required, and
+  - a DFA over the names of its child elements.
+Element patterns of the same name that may occur at the same position
+are merged into one type, so that the validator never has to look
+ahead. The merged type allows what any of them allows, which is the
+usual single-type approximation of RELAX NG; co-occurrence constraints
+between attributes and child elements are not checked either.
+
+Supported: grammar, start, named patterns, element, attribute, text,
+empty, notAllowed, string values, list (treated as a group of its
+contents), mixed, `,` `|` `&` (the latter checked as `,`), `?` `*` `+`
+and `#` comments.
+"""
+
+import os
+import re
+import sys
+
+ANY = None  # any text
+
+
+class Error(Exception):
+    pass
+
+
+def tokenize(source):
+    token_re = re.compile(r'''
+        (?P<space>\s+|\#[^\n]*)
+      | (?P<string>"[^"]*"|'[^']*')
+      | (?P<ident>\\?[A-Za-z_][\w.\-]*)
+      | (?P<punct>\|=|&=|[{}()|,&?*+=])
+    ''', re.VERBOSE)
+    pos = 0
+    tokens = []
+    while pos < len(source):
+        m = token_re.match(source, pos)
+        if not m:
+            line = source.count('\n', 0, pos) + 1
+            raise Error('line %d: unexpected character %r' % (line, source[pos]))
+        pos = m.end()
+        if m.lastgroup == 'space':
+            continue
+        if m.lastgroup == 'string':
+            tokens.append(('string', m.group()[1:-1]))
+        elif m.lastgroup == 'ident':
+            tokens.append(('ident', m.group().lstrip('\\')))
+        else:
+            tokens.append(('punct', m.group()))
+    tokens.append(('eof', ''))
+    return tokens
+
+
+class Parser(object):
+    def __init__(self, tokens):
+        self.tokens = tokens
+        self.pos = 0
+        self.defs = {}
+        self.elements = []  # (name, content pattern)
+
+    def peek(self):
+        return self.tokens[self.pos]
+
+    def next(self):
+        token = self.tokens[self.pos]
+        self.pos += 1
+        return token
+
+    def expect(self, kind, value=None):
+        token = self.next()
+        if token[0] != kind or (value is not None and token[1] != value):
+            raise Error('expected %s, got %r' % (value or kind, token[1]))
+        return token[1]
+
+    def parse_grammar(self):
+        braced = self.peek() == ('ident', 'grammar')
+        if braced:
+            self.next()
+            self.expect('punct', '{')
+        while self.peek()[0] == 'ident':
+            name = self.next()[1]
+            self.expect('punct', '=')
+            if name in self.defs:
+                raise Error('%s is defined twice' % name)
+            self.defs[name] = self.parse_pattern()
+        if braced:
+            self.expect('punct', '}')
+        self.expect('eof')
+
+    def parse_pattern(self):
+        items = [self.parse_particle()]
+        op = None
+        while self.peek()[0] == 'punct' and self.peek()[1] in '|,&':
+            if op is not None and self.peek()[1] != op:
+                raise Error('mixed operators without parentheses')
+            op = self.next()[1]
+            items.append(self.parse_particle())
+        if op is None:
+            return items[0]
+        return ('choice' if op == '|' else 'group', items)
+
+    def parse_particle(self):
+        pattern = self.parse_primary()
+        while self.peek()[0] == 'punct' and self.peek()[1] in '?*+':
+            suffix = self.next()[1]
+            pattern = {'?': 'opt', '*': 'star', '+': 'plus'}[suffix], pattern
+        return pattern
+
+    def parse_primary(self):
+        kind, value = self.next()
+        if kind == 'string':
+            return ('value', normalize(value))
+        if kind == 'punct' and value == '(':
+            pattern = self.parse_pattern()
+            self.expect('punct', ')')
+            return pattern
+        if kind != 'ident':
+            raise Error('unexpected %r' % value)
+        if value in ('element', 'attribute'):
+            name = self.expect('ident')
+            self.expect('punct', '{')
+            content = self.parse_pattern()
+            self.expect('punct', '}')
+            if value == 'attribute':
+                return ('attribute', name, content)
+            self.elements.append((name, content))
+            return ('element', len(self.elements) - 1)
+        if value in ('list', 'mixed'):
+            self.expect('punct', '{')
+            content = self.parse_pattern()
+            self.expect('punct', '}')
+            if value == 'mixed':
+                return ('group', [content, ('text',)])
+            return content
+        if value in ('text', 'empty', 'notAllowed'):
+            return (value,)
+        return ('ref', value)
+
+
+def normalize(value):
+    return ' '.join(value.split())
+
+
+def union(values, other):
+    return ANY if values is ANY or other is ANY else values | other
+
+
+class Schema(object):
+    def __init__(self, parser):
+        self.defs = parser.defs
+        self.elements = parser.elements
+        if 'start' not in self.defs:
+            raise Error('no start pattern')
+        for name, pattern in self.defs.items():
+            self.check_refs(pattern, name)
+        for name, content in self.elements:
+            self.check_refs(content, 'element ' + name)
+
+    def check_refs(self, pattern, where):
+        kind = pattern[0]
+        if kind == 'ref':
+            if pattern[1] not in self.defs:
+                raise Error('%s refers to undefined %s' % (where, pattern[1]))
+        elif kind in ('choice', 'group'):
+            for item in pattern[1]:
+                self.check_refs(item, where)
+        elif kind in ('opt', 'star', 'plus'):
+            self.check_refs(pattern[1], where)
+        elif kind == 'attribute':
+            self.check_refs(pattern[2], where)
+
+    def values(self, pattern):
+        """The normalized strings that a text pattern matches, or ANY.
+        The empty string stands for the absence of text."""
+        kind = pattern[0]
+        if kind == 'value':
+            return {pattern[1]}
+        if kind == 'text':
+            return ANY
+        if kind in ('empty', 'attribute', 'element', 'notAllowed'):
+            return {''}
+        if kind == 'ref':
+            return self.values(self.defs[pattern[1]])
+        if kind == 'choice':
+            result = set()
+            for item in pattern[1]:
+                values = self.values(item)
+                if values is ANY:
+                    return ANY
+                result |= values
+            return result
+        if kind == 'group':
+            result = {''}
+            for item in pattern[1]:
+                values = self.values(item)
+                if values == {''}:
+                    continue
+                if result != {''}:
+                    return ANY
+                result = values
+            return result
+        values = self.values(pattern[1])
+        if values is ANY or kind == 'opt' or values == {''}:
+            return ANY if values is ANY else values | {''}
+        return ANY  # repeated text
+
+    def attributes(self, pattern, result):
+        """Collect the attributes of an element content pattern."""
+        kind = pattern[0]
+        if kind == 'attribute':
+            result[pattern[1]] = union(
+                result.get(pattern[1], set()), self.values(pattern[2]))
+        elif kind == 'ref':
+            self.attributes(self.defs[pattern[1]], result)
+        elif kind in ('choice', 'group'):
+            for item in pattern[1]:
+                self.attributes(item, result)
+        elif kind in ('opt', 'star', 'plus'):
+            self.attributes(pattern[1], result)
+        return result
+
+    def required(self, pattern):
+        """The attributes that every match of a pattern has."""
+        kind = pattern[0]
+        if kind == 'attribute':
+            return {pattern[1]}
+        if kind == 'ref':
+            return self.required(self.defs[pattern[1]])
+        if kind == 'group':
+            result = set()
+            for item in pattern[1]:
+                result |= self.required(item)
+            return result
+        if kind == 'choice':
+            sets = [self.required(item) for item in pattern[1]]
+            return set.intersection(*sets)
+        if kind == 'plus':
+            return self.required(pattern[1])
+        return set()
+
+
+class Nfa(object):
+    """Thompson NFA over element indices, shared by all the content
+    models. Attributes and text are epsilon transitions."""
+
+    def __init__(self, schema):
+        self.schema = schema
+        self.epsilon = []
+        self.moves = []  # (element index, target state)
+        self.content = {}  # element index -> (start, final)
+        self.finals = set()
+        self.expanding = set()
+
+    def new_state(self):
+        self.epsilon.append([])
+        self.moves.append([])
+        return len(self.epsilon) - 1
+
+    def content_of(self, element):
+        if element not in self.content:
+            start, final = self.new_state(), self.new_state()
+            self.build(self.schema.elements[element][1], start, final)
+            self.content[element] = (start, final)
+            self.finals.add(final)
+        return self.content[element]
+
+    def build(self, pattern, start, end):
+        kind = pattern[0]
+        if kind == 'element':
+            self.moves[start].append((pattern[1], end))
+        elif kind in ('text', 'value', 'empty', 'attribute'):
+            self.epsilon[start].append(end)
+        elif kind == 'notAllowed':
+            pass
+        elif kind == 'ref':
+            name = pattern[1]
+            if name in self.expanding:
+                raise Error('%s refers to itself outside an element' % name)
+            self.expanding.add(name)
+            self.build(self.schema.defs[name], start, end)
+            self.expanding.discard(name)
+        elif kind == 'choice':
+            for item in pattern[1]:
+                self.build(item, start, end)
+        elif kind == 'group':
+            cur = start
+            for item in pattern[1][:-1]:
+                nxt = self.new_state()
+                self.build(item, cur, nxt)
+                cur = nxt
+            self.build(pattern[1][-1], cur, end)
+        else:
+            inner_start, inner_end = self.new_state(), self.new_state()
+            self.epsilon[start].append(inner_start)
+            self.epsilon[inner_end].append(end)
+            self.build(pattern[1], inner_start, inner_end)
+            if kind in ('opt', 'star'):
+                self.epsilon[start].append(end)
+            if kind in ('star', 'plus'):
+                self.epsilon[inner_end].append(inner_start)
+
+    def closure(self, states):
+        result = set(states)
+        pending = list(states)
+        while pending:
+            for target in self.epsilon[pending.pop()]:
+                if target not in result:
+                    result.add(target)
+                    pending.append(target)
+        return frozenset(result)
+
+
+class Compiler(object):
+    def __init__(self, schema):
+        self.schema = schema
+        self.nfa = Nfa(schema)
+        self.types = []  # (name, element indices, DFA start)
+        self.type_ids = {}
+        self.states = []  # (accepting, {name: (state, type)})
+        self.state_ids = {}
+
+    def compile(self):
+        # the document is a type of its own, whose content is the start
+        # pattern
+        doc_start, doc_final = self.nfa.new_state(), self.nfa.new_state()
+        self.nfa.build(self.schema.defs['start'], doc_start, doc_final)
+        self.nfa.finals.add(doc_final)
+        self.types.append(('', (), self.dfa_state(self.nfa.closure([doc_start]))))
+        index = 0
+        while index < len(self.states):
+            nfa_states = self.states[index][1]
+            moves = {}
+            for state in nfa_states:
+                for element, target in self.nfa.moves[state]:
+                    name = self.schema.elements[element][0]
+                    targets, elements = moves.setdefault(name, (set(), set()))
+                    targets.add(target)
+                    elements.add(element)
+            transitions = {}
+            for name, (targets, elements) in moves.items():
+                nxt = self.dfa_state(self.nfa.closure(targets))
+                transitions[name] = (nxt, self.type_of(name, elements))
+            self.states[index] = (self.states[index][0], nfa_states, transitions)
+            index += 1
+        return self
+
+    def dfa_state(self, nfa_states):
+        if nfa_states not in self.state_ids:
+            self.state_ids[nfa_states] = len(self.states)
+            accepting = bool(nfa_states & self.nfa.finals)
+            self.states.append((accepting, nfa_states))
+        return self.state_ids[nfa_states]
+
+    def type_of(self, name, elements):
+        key = frozenset(elements)
+        if key not in self.type_ids:
+            starts = [self.nfa.content_of(e)[0] for e in sorted(key)]
+            self.type_ids[key] = len(self.types)
+            self.types.append((name, tuple(sorted(key)),
+                               self.dfa_state(self.nfa.closure(starts))))
+        return self.type_ids[key]
+
+    def describe(self, elements):
+        """Attributes, required attributes and text values of a type."""
+        attributes = {}
+        required = None
+        values = set() if elements else {''}
+        for element in elements:
+            content = self.schema.elements[element][1]
+            for name, allowed in self.schema.attributes(content, {}).items():
+                attributes[name] = union(attributes.get(name, set()), allowed)
+            req = self.schema.required(content)
+            required = req if required is None else required & req
+            values = union(values, self.schema.values(content))
+        return attributes, required or set(), values
+
+
+def c_string(value):
+    return '"' + value.replace('\\', '\\\\').replace('"', '\\"') + '"'
+
+
+def emit(compiler, source_name, out):
+    types = compiler.types
+    states = compiler.states
+    described = [compiler.describe(elements) for _, elements, _ in types]
+
+    symbols = set()
+    for name, _, _ in types:
+        symbols.add(name)
+    for attributes, _, _ in described:
+        symbols.update(attributes)
+    symbols.discard('')
+    symbols = sorted(symbols)
+    symbol_ids = dict((s, i) for i, s in enumerate(symbols))
+
+    values = []
+    value_ids = {}
+
+    def value_range(allowed):
+        if allowed is ANY:
+            return 0, -1
+        key = tuple(sorted(allowed))
+        if key not in value_ids:
+            value_ids[key] = len(values)
+            values.extend(key)
+        return value_ids[key], len(key)
+
+    attribute_rows = []
+    type_rows = []
+    for (name, _, start), (attributes, required, text) in zip(types, described):
+        first_attribute = len(attribute_rows)
+        for attr in sorted(attributes, key=lambda a: symbol_ids[a]):
+            first, count = value_range(attributes[attr])
+            attribute_rows.append((symbol_ids[attr], attr in required,
+                                   first, count, attr))
+        has_children = any(states[s][2] for s in reachable(states, start))
+        first_value, num_values = value_range(text)
+        type_rows.append((symbol_ids.get(name, -1), start, first_attribute,
+                          len(attribute_rows) - first_attribute,
+                          first_value, num_values, has_children, name))
+
+    transition_rows = []
+    state_rows = []
+    for accepting, _, transitions in states:
+        first = len(transition_rows)
+        for name in sorted(transitions, key=lambda n: symbol_ids[n]):
+            target, type_id = transitions[name]
+            transition_rows.append((symbol_ids[name], target, type_id, name))
+        state_rows.append((accepting, first, len(transition_rows) - first))
+
+    w = out.write
+    w('// Generated by scripts/rnc2automaton.py from %s.\n' % source_name)
+    w('// Do not edit; run `make schema-tables` in XcodeMLtoCXX/src instead.\n\n')
+    w('const char *const symbols[] = {\n')
+    for symbol in symbols:
+        w('    %s,\n' % c_string(symbol))
+    w('};\n\n')
+    w('const char *const values[] = {\n')
+    for value in values or ['']:
+        w('    %s,\n' % c_string(value))
+    w('};\n\n')
+    w('/* symbol, required, first value, number of values (-1: any) */\n')
+    w('const Attribute attributes[] = {\n')
+    for symbol, required, first, count, name in attribute_rows:
+        w('    {%d, %s, %d, %d}, // %s\n'
+          % (symbol, 'true' if required else 'false', first, count, name))
+    w('};\n\n')
+    w('/* symbol, target state, type */\n')
+    w('const Transition transitions[] = {\n')
+    for symbol, target, type_id, name in transition_rows:
+        w('    {%d, %d, %d}, // %s\n' % (symbol, target, type_id, name))
+    w('};\n\n')
+    w('/* accepting, first transition, number of transitions */\n')
+    w('const State states[] = {\n')
+    for i, (accepting, first, count) in enumerate(state_rows):
+        w('    {%s, %d, %d}, // %d\n'
+          % ('true' if accepting else 'false', first, count, i))
+    w('};\n\n')
+    w('/* symbol, start state, first attribute, number of attributes,\n'
+      ' * first value, number of values (-1: any), has child elements */\n')
+    w('const Type types[] = {\n')
+    for i, row in enumerate(type_rows):
+        symbol, start, first_attr, num_attrs, first_value, num_values, \
+            has_children, name = row
+        w('    {%d, %d, %d, %d, %d, %d, %s}, // %d %s\n'
+          % (symbol, start, first_attr, num_attrs, first_value, num_values,
+             'true' if has_children else 'false', i, name or '(document)'))
+    w('};\n')
+
+
+def reachable(states, start):
+    seen = set([start])
+    pending = [start]
+    while pending:
+        for target, _ in states[pending.pop()][2].values():
+            if target not in seen:
+                seen.add(target)
+                pending.append(target)
+    return seen
+
+
+def main(argv):
+    if len(argv) != 2:
+        sys.stderr.write(__doc__.split('\n\n')[1] + '\n')
+        return 2
+    with open(argv[1]) as f:
+        source = f.read()
+    try:
+        parser = Parser(tokenize(source))
+        parser.parse_grammar()
+        compiler = Compiler(Schema(parser)).compile()
+    except Error as e:
+        sys.stderr.write('%s: %s\n' % (argv[1], e))
+        return 1
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    emit(compiler, os.path.relpath(os.path.abspath(argv[1]), root), sys.stdout)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))